@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/Activation.hpp"
+#include "../include/Gemm.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Matrix.hpp"
+
+using namespace std;
+
+#define BENCH_ROUNDS 5
+#define BENCH_VALUES 4096
+
+/**
+ * @brief Times the activation kernels of one element type on every instruction set
+ * @param steps Number of timed passes over BENCH_VALUES values per round
+ */
+template <typename T>
+static void runKernels(int steps) {
+    vector<T> x(BENCH_VALUES), a(BENCH_VALUES), d(BENCH_VALUES);
+    for (int i = 0; i < BENCH_VALUES; i++) {
+        x.at(i) = (T)(8.0 * sin(i * 0.37));
+    }
+
+    const KernelIsa isas[] = { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_AVX512 };
+    const KernelIsa active = Kernels::getIsa();
+    for (int t = 0; t < ACTIVATION_COUNT; t++) {
+        const ActivationType type = (ActivationType)t;
+        cout << Activation::getName(type) << "\t" << (sizeof(T) == sizeof(double) ? "f64" : "f32");
+
+        // libm reference, one value at a time
+        double best = 1e30;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int s = 0; s < steps; s++) {
+                for (int i = 0; i < BENCH_VALUES; i++) {
+                    const double v = Activation::value(type, x[i]);
+                    a[i] = (T)v;
+                    d[i] = (T)Activation::derivative(type, x[i], v);
+                }
+            }
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        cout << "\t" << best / steps / BENCH_VALUES * 1e9;
+
+        for (int k = 0; k < 4; k++) {
+            if (!Kernels::setIsa(isas[k])) {
+                cout << "\t-";
+                continue;
+            }
+            double maxError = 0.0;
+            Activation::apply(type, x.data(), a.data(), d.data(), BENCH_VALUES);
+            for (int i = 0; i < BENCH_VALUES; i++) {
+                const double v = Activation::value(type, x[i]);
+                maxError = max(maxError, fabs(a[i] - v));
+                maxError = max(maxError, fabs(d[i] - Activation::derivative(type, x[i], v)));
+            }
+
+            best = 1e30;
+            for (int round = 0; round < BENCH_ROUNDS; round++) {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                for (int s = 0; s < steps; s++) {
+                    Activation::apply(type, x.data(), a.data(), d.data(), BENCH_VALUES);
+                }
+                best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+            }
+            cout << "\t" << best / steps / BENCH_VALUES * 1e9 << " (" << maxError << ")";
+        }
+        cout << endl;
+    }
+    Kernels::setIsa(active);
+}
+
+/**
+ * @brief Times the fused forward pass of one layer with every activation
+ * @param rows Neurons of the layer (M)
+ * @param cols Neurons of the previous layer (K)
+ * @param batch Samples per pass (N)
+ * @param steps Number of timed passes per round
+ */
+static void runLayer(int rows, int cols, int batch, int steps) {
+    Matrix w(rows, cols, false), x(cols, batch, false), bias(rows, 1, false);
+    Matrix vals(rows, batch, false), activated(rows, batch, false), derived(rows, batch, false);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            w.at(i, j) = sin(i * 3 + j * 0.7) * 0.1;
+        }
+        bias.at(i, 0) = 0.01 * i;
+    }
+    for (int i = 0; i < cols; i++) {
+        for (int j = 0; j < batch; j++) {
+            x.at(i, j) = cos(i * 1.3 + j);
+        }
+    }
+
+    cout << rows << "x" << cols << "\t" << batch;
+    for (int t = 0; t < ACTIVATION_COUNT; t++) {
+        const ActivationType type = (ActivationType)t;
+        Gemm::multiplyBiasActivate(w, x, bias, type, vals, &activated, &derived);
+
+        double best = 1e30;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int s = 0; s < steps; s++) {
+                Gemm::multiplyBiasActivate(w, x, bias, type, vals, &activated, &derived);
+            }
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        cout << "\t" << best / steps * 1e6;
+    }
+    cout << endl;
+}
+
+/**
+ * @brief Times the activation kernels per instruction set against the libm reference,
+ *        then a training layer forward pass with each activation
+ * @param argc Argument count
+ * @param argv Optional number of timed passes per round
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    int steps = argc > 1 ? stoi(argv[1]) : 200;
+
+    cout << "Kernels in ns per value (max abs error against libm), active ISA " << Kernels::getIsaName() << endl;
+    cout << "Activation\ttype\tlibm\tscalar\tsse2\tavx2\tavx512" << endl;
+    runKernels<double>(steps);
+    runKernels<float>(steps);
+
+    cout << endl << "Fused layer forward pass with derivatives, us per pass" << endl;
+    cout << "Layer\tbatch";
+    for (int t = 0; t < ACTIVATION_COUNT; t++) {
+        cout << "\t" << Activation::getName((ActivationType)t);
+    }
+    cout << endl;
+    const int layers[][2] = { { 128, 5 }, { 256, 128 }, { 10, 256 } };
+    const int batches[] = { 1, 64 };
+    for (int b = 0; b < 2; b++) {
+        for (int l = 0; l < 3; l++) {
+            runLayer(layers[l][0], layers[l][1], batches[b], steps);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,230 @@
+#ifndef _BENCH_HARNESS_HPP_
+#define _BENCH_HARNESS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @struct BenchResult
+ * @brief Timing statistics of one benchmark case
+ */
+struct BenchResult {
+    string group;       ///< Family of the case, e.g. "gemm" or "train"
+    string name;        ///< Unique name of the case, the key used to compare runs
+    int reps;           ///< Timed repetitions
+    double median;      ///< Median seconds per repetition
+    double p99;         ///< 99th percentile seconds per repetition
+    double min;         ///< Fastest repetition in seconds
+    double mean;        ///< Mean seconds per repetition
+    double flops;       ///< Floating point operations per repetition, 0 if not meaningful
+    double bytes;       ///< Bytes read and written per repetition, 0 if not meaningful
+};
+
+/**
+ * @class BenchHarness
+ * @brief Minimal self-contained benchmark runner
+ *
+ * Each case is warmed up, then repeated until both a minimum number of repetitions and a
+ * minimum total time have been reached (or a repetition cap), and the per-repetition
+ * times are reduced to median and p99. Throughput is derived from the median. Results are
+ * written as JSON with one case per line, so two runs can be diffed with any text tool
+ * and read back by compare() without a JSON library.
+ */
+class BenchHarness {
+public:
+    /**
+     * @brief Constructor for BenchHarness
+     * @param warmup Untimed repetitions before measuring
+     * @param minReps Minimum timed repetitions
+     * @param maxReps Maximum timed repetitions
+     * @param minSeconds Minimum total timed seconds per case
+     */
+    BenchHarness(int warmup = 2, int minReps = 5, int maxReps = 1000, double minSeconds = 0.5)
+        : warmup(warmup), minReps(minReps), maxReps(maxReps), minSeconds(minSeconds) {}
+
+    /**
+     * @brief Only runs cases whose name contains the filter
+     * @param filter Substring, empty to run everything
+     */
+    void setFilter(const string& filter) { this->filter = filter; }
+
+    /**
+     * @brief Adds a key/value pair to the "context" object of the JSON output
+     * @param key Key
+     * @param value Value, written as a string
+     */
+    void setContext(const string& key, const string& value) { this->context[key] = value; }
+
+    /**
+     * @brief Times a case
+     * @param group Family of the case
+     * @param name Unique name of the case
+     * @param flops Floating point operations per call of body, 0 if not meaningful
+     * @param bytes Bytes moved per call of body, 0 if not meaningful
+     * @param body Work to time, called once per repetition
+     * @return Whether the case ran (false if filtered out)
+     */
+    template <typename F>
+    bool run(const string& group, const string& name, double flops, double bytes, F body) {
+        if (!this->filter.empty() && name.find(this->filter) == string::npos) {
+            return false;
+        }
+
+        for (int i = 0; i < this->warmup; i++) {
+            body();
+        }
+
+        vector<double> times;
+        double total = 0.0;
+        while ((int)times.size() < this->maxReps && ((int)times.size() < this->minReps || total < this->minSeconds)) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            body();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            times.push_back(seconds);
+            total += seconds;
+        }
+        sort(times.begin(), times.end());
+
+        BenchResult r;
+        r.group = group;
+        r.name = name;
+        r.reps = (int)times.size();
+        r.median = times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+        r.p99 = times[min(times.size() - 1, (size_t)(0.99 * times.size()))];
+        r.min = times.front();
+        r.mean = total / times.size();
+        r.flops = flops;
+        r.bytes = bytes;
+        this->results.push_back(r);
+        this->print(cout, r);
+        return true;
+    }
+
+    /**
+     * @brief Gets the results so far
+     * @return Results in the order they ran
+     */
+    const vector<BenchResult>& getResults() const { return this->results; }
+
+    /**
+     * @brief Prints the header of the table written while running
+     * @param out Stream
+     */
+    static void printHeader(ostream& out) {
+        out << "case\treps\tmedian us\tp99 us\tGFLOP/s\tGB/s" << endl;
+    }
+
+    /**
+     * @brief Writes all results as JSON
+     * @param path Output file
+     * @return Whether the file was written
+     */
+    bool writeJson(const string& path) const {
+        ofstream out(path);
+        if (!out.is_open()) {
+            cerr << "Cannot write " << path << endl;
+            return false;
+        }
+        out.precision(9);
+        out << "{" << endl << "  \"context\": {";
+        bool first = true;
+        for (map<string, string>::const_iterator it = this->context.begin(); it != this->context.end(); ++it) {
+            out << (first ? "" : ", ") << "\"" << it->first << "\": \"" << it->second << "\"";
+            first = false;
+        }
+        out << "}," << endl << "  \"results\": [" << endl;
+        for (size_t i = 0; i < this->results.size(); i++) {
+            const BenchResult& r = this->results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"group\": \"" << r.group << "\", \"reps\": " << r.reps
+                << ", \"median_s\": " << r.median << ", \"p99_s\": " << r.p99 << ", \"min_s\": " << r.min
+                << ", \"mean_s\": " << r.mean << ", \"flops\": " << r.flops << ", \"bytes\": " << r.bytes
+                << ", \"gflops\": " << (r.flops > 0 ? r.flops / r.median * 1e-9 : 0.0)
+                << ", \"gbytes_per_s\": " << (r.bytes > 0 ? r.bytes / r.median * 1e-9 : 0.0) << "}"
+                << (i + 1 < this->results.size() ? "," : "") << endl;
+        }
+        out << "  ]" << endl << "}" << endl;
+        return true;
+    }
+
+    /**
+     * @brief Compares the medians with a file written by writeJson
+     * @param path Baseline file
+     * @param threshold Relative slowdown reported as a regression, e.g. 0.1 for 10%
+     * @return Number of regressions, or -1 if the baseline cannot be read
+     */
+    int compare(const string& path, double threshold) const {
+        ifstream in(path);
+        if (!in.is_open()) {
+            cerr << "Cannot read baseline " << path << endl;
+            return -1;
+        }
+
+        // writeJson puts every result on its own line, so the two fields can be picked out directly
+        map<string, double> baseline;
+        string line;
+        while (getline(in, line)) {
+            size_t name = line.find("\"name\": \"");
+            size_t median = line.find("\"median_s\": ");
+            if (name == string::npos || median == string::npos) {
+                continue;
+            }
+            name += 9;
+            baseline[line.substr(name, line.find('"', name) - name)] = atof(line.c_str() + median + 12);
+        }
+
+        int regressions = 0;
+        cout << endl << "case\tbaseline us\tcurrent us\tchange" << endl;
+        for (size_t i = 0; i < this->results.size(); i++) {
+            const BenchResult& r = this->results[i];
+            map<string, double>::const_iterator it = baseline.find(r.name);
+            if (it == baseline.end() || it->second <= 0) {
+                continue;
+            }
+            double change = r.median / it->second - 1.0;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            char percent[32];
+            snprintf(percent, sizeof(percent), "%+.1f%%", change * 100);
+            cout << r.name << "\t" << it->second * 1e6 << "\t" << r.median * 1e6 << "\t" << percent
+                 << (regressed ? "\tREGRESSION" : "") << endl;
+        }
+        return regressions;
+    }
+
+private:
+    /**
+     * @brief Prints one row of the table
+     * @param out Stream
+     * @param r Result
+     */
+    static void print(ostream& out, const BenchResult& r) {
+        out << r.name << "\t" << r.reps << "\t" << r.median * 1e6 << "\t" << r.p99 * 1e6 << "\t";
+        if (r.flops > 0) {
+            out << r.flops / r.median * 1e-9;
+        }
+        out << "\t";
+        if (r.bytes > 0) {
+            out << r.bytes / r.median * 1e-9;
+        }
+        out << endl;
+    }
+
+    int warmup;                     ///< Untimed repetitions
+    int minReps;                    ///< Minimum timed repetitions
+    int maxReps;                    ///< Maximum timed repetitions
+    double minSeconds;              ///< Minimum total timed seconds
+    string filter;                  ///< Substring a case name must contain
+    map<string, string> context;    ///< Build and machine description
+    vector<BenchResult> results;    ///< Results in run order
+};
+
+#endif // _BENCH_HARNESS_HPP_
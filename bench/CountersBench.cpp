@@ -0,0 +1,118 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/Initializer.hpp"
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/PerfCounters.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+#define BENCH_BATCH 64
+
+/**
+ * @brief Counts one GEMM shape directly with PerfCounters
+ * @param counters Counters of the calling thread
+ * @param peak Machine ceilings
+ * @param m Rows of A
+ * @param k Columns of A
+ * @param n Columns of B
+ * @param reps Multiplications counted
+ */
+static void countGemm(const PerfCounters& counters, const MachinePeak& peak, int m, int k, int n, int reps) {
+    Matrix a(m, k, true), b(k, n, true);
+    delete (a * b);
+
+    uint64_t before[PERF_EVENT_COUNT], after[PERF_EVENT_COUNT];
+    counters.read(before);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        delete (a * b);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    counters.read(after);
+
+    const double gflops = 2.0 * m * k * n * reps / seconds * 1e-9;
+    const double percent = 100.0 * gflops / peak.gflops;
+    cout << m << "x" << k << "x" << n << "\t" << gflops << "\t";
+    if (percent > 100.0) {
+        cout << ">100%";
+    }
+    else {
+        cout << percent << "%";
+    }
+    for (int e = PERF_CYCLES; e < PERF_EVENT_COUNT; e++) {
+        cout << "\t";
+        if (counters.isCounting((PerfEvent)e)) {
+            cout << (after[e] - before[e]) / reps;
+        }
+        else {
+            cout << "n/a";
+        }
+    }
+    if (counters.isCounting(PERF_CYCLES) && counters.isCounting(PERF_INSTRUCTIONS)) {
+        cout << "\tIPC " << (double)(after[PERF_INSTRUCTIONS] - before[PERF_INSTRUCTIONS]) / (after[PERF_CYCLES] - before[PERF_CYCLES]);
+    }
+    cout << endl;
+}
+
+/**
+ * @brief Reads hardware counters around Matrix::operator* at the layer shapes, then, when the
+ *        library is built with NN_PROFILE, around every layer of training steps, and compares
+ *        the achieved GFLOP/s with the measured roofline
+ * @param argc Argument count
+ * @param argv Optional number of training steps
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    const int steps = argc > 1 ? stoi(argv[1]) : 10;
+    // Counters follow the calling thread, so keep all the work on it
+    ThreadPool::setNumThreads(1);
+
+    PerfCounters counters;
+    cout << "Events:";
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        cout << " " << PerfCounters::getName((PerfEvent)e) << (counters.isCounting((PerfEvent)e) ? "" : " (off)");
+    }
+    cout << endl;
+    if (!counters.getError().empty()) {
+        cout << "First failure: " << counters.getError() << endl;
+    }
+
+    MachinePeak peak = PerfCounters::measurePeak();
+    cout << "Measured peak: " << peak.gflops << " GFLOP/s, " << peak.gbytesPerSecond << " GB/s" << endl << endl;
+
+    cout << "GEMM\tGFLOP/s\tof peak";
+    for (int e = PERF_CYCLES; e < PERF_EVENT_COUNT; e++) {
+        cout << "\t" << PerfCounters::getName((PerfEvent)e);
+    }
+    cout << endl;
+    const int shapes[][3] = { { 128, 5, 1 }, { 256, 128, 1 }, { 256, 128, BENCH_BATCH }, { 10, 256, BENCH_BATCH }, { 1024, 1024, BENCH_BATCH } };
+    for (int s = 0; s < 5; s++) {
+        countGemm(counters, peak, shapes[s][0], shapes[s][1], shapes[s][2], s < 2 ? 200 : 10);
+    }
+
+    if (!Profiler::isCompiledIn()) {
+        cout << endl << "Built without NN_PROFILE: configure with -DNN_PROFILE=ON for per-layer counters" << endl;
+        return 0;
+    }
+
+    Initializer::setSeed(1);
+    NeuralNetwork nn({ 784, 1024, 1024, 10 }, 0.0001, INIT_XAVIER_UNIFORM);
+    Matrix inputs(784, BENCH_BATCH, true), targets(10, BENCH_BATCH, true);
+    nn.trainBatch(inputs, targets);
+
+    Profiler::reset();
+    Profiler::setHardwareCounters(true);
+    for (int s = 0; s < steps; s++) {
+        nn.trainBatch(inputs, targets);
+    }
+    Profiler::setHardwareCounters(false);
+
+    cout << endl << "784-1024-1024-10, batch " << BENCH_BATCH << ", " << steps << " steps" << endl;
+    Profiler::printCounters(cout, peak);
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/Dataset.hpp"
+#include "../include/MappedDataset.hpp"
+#include "../include/NeuralNetwork.hpp"
+
+using namespace std;
+
+#define BENCH_INPUTS 5
+#define BENCH_TARGETS 10
+
+/**
+ * @brief Writes a synthetic CSV dataset
+ * @param path Path to write to
+ * @param rows Number of samples
+ */
+static void writeCsv(const string& path, size_t rows) {
+    ofstream file(path);
+    file.precision(9);
+    for (size_t r = 0; r < rows; r++) {
+        for (int k = 0; k < BENCH_INPUTS + BENCH_TARGETS; k++) {
+            file << sin(r * 0.013 + k * 0.7) << (k != BENCH_INPUTS + BENCH_TARGETS - 1 ? "," : "\n");
+        }
+    }
+}
+
+/**
+ * @brief Drains a dataset as fast as possible
+ * @param path Dataset to read
+ * @param config Loader configuration
+ * @param label Printed name of the run
+ */
+static void runRead(const string& path, const DatasetConfig& config, const string& label) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    DatasetLoader loader(path, BENCH_INPUTS, BENCH_TARGETS, config);
+    DatasetBatch batch;
+    double sum = 0.0;
+    while (loader.next(batch)) {
+        for (size_t i = 0; i < batch.inputs.size(); i++) {
+            sum += batch.inputs[i][0];
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << label << "\t" << loader.getSamplesRead() << "\t" << loader.getSamplesRead() / seconds
+         << "\t" << sum << endl;
+}
+
+/**
+ * @brief Trains from a dataset and reports how long training waited for the reader
+ * @param path Dataset to read
+ * @param config Loader configuration
+ * @param label Printed name of the run
+ */
+static void runTrain(const string& path, const DatasetConfig& config, const string& label) {
+    NeuralNetwork nn({ BENCH_INPUTS, 64, BENCH_TARGETS }, 0.01);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    DatasetLoader loader(path, BENCH_INPUTS, BENCH_TARGETS, config);
+    DatasetBatch batch;
+    nn.reserveHistory(1 << 16);
+    while (loader.next(batch)) {
+        nn.trainBatch(batch.inputs, batch.targets);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << label << "\t" << loader.getSamplesRead() / seconds << "\t" << seconds << "\t"
+         << loader.getStallSeconds() << "\t" << nn.getError() << endl;
+}
+
+/**
+ * @brief Reads every batch of a mapped dataset, in shuffled order
+ * @param path Columnar dataset
+ * @param batchSize Samples per batch
+ * @param label Printed name of the run
+ */
+template <typename T>
+static void runMappedRead(const string& path, int batchSize, const string& label) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    BasicMappedDataset<T> data(path);
+    size_t samples = 0;
+    double sum = 0.0;
+    const int batches = data.beginEpoch(batchSize, true);
+    for (int b = 0; b < batches; b++) {
+        BasicMatrix<T> x = data.batchInputs(b);
+        for (int k = 0; k < x.getNumCols(); k++) {
+            sum += x.at(0, k);
+        }
+        samples += x.getNumCols();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << label << "\t" << samples << "\t" << samples / seconds << "\t" << sum << endl;
+}
+
+/**
+ * @brief Trains from a mapped dataset, passing the batch views straight to the network
+ * @param path Columnar dataset
+ * @param batchSize Samples per batch
+ * @param label Printed name of the run
+ */
+static void runMappedTrain(const string& path, int batchSize, const string& label) {
+    NeuralNetwork nn({ BENCH_INPUTS, 64, BENCH_TARGETS }, 0.01);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    MappedDataset data(path);
+    nn.reserveHistory(1 << 16);
+    const int batches = data.beginEpoch(batchSize, true);
+    for (int b = 0; b < batches; b++) {
+        nn.trainBatch(data.batchInputs(b), data.batchTargets(b));
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << label << "\t" << batches * batchSize / seconds << "\t" << seconds << "\t" << 0.0 << "\t"
+         << nn.getError() << endl;
+}
+
+/**
+ * @brief Measures dataset streaming throughput for CSV and binary files, with and without
+ *        shuffling, against batch views of a mapped columnar file, then the reader
+ *        stalls seen by a training loop
+ * @param argc Argument count
+ * @param argv Optional number of rows
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? stoul(argv[1]) : 200000;
+    const string csv = "nn_dataset_bench.csv";
+    const string bin = "nn_dataset_bench.bin";
+    const string col = "nn_dataset_bench.col";
+    const string col32 = "nn_dataset_bench.f32.col";
+    writeCsv(csv, rows);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    DatasetWriter::fromCsv(csv, bin, BENCH_INPUTS, BENCH_TARGETS);
+    cout << "CSV to binary conversion of " << rows << " rows: "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+    start = chrono::steady_clock::now();
+    MappedDataset::convert(csv, col, BENCH_INPUTS, BENCH_TARGETS);
+    MappedDataset::convert(bin, col32, BENCH_INPUTS, BENCH_TARGETS, MODEL_FLOAT32);
+    cout << "CSV to columnar and binary to columnar f32 conversion: "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl << endl;
+
+    DatasetConfig plain;
+    plain.batchSize = 64;
+    DatasetConfig shuffled = plain;
+    shuffled.shuffleWindow = 8192;
+
+    cout << "Read\tsamples\tsamples/s\tchecksum" << endl;
+    runRead(csv, plain, "csv");
+    runRead(csv, shuffled, "csv+shuffle");
+    runRead(bin, plain, "binary");
+    runRead(bin, shuffled, "binary+shuffle");
+    runMappedRead<double>(col, plain.batchSize, "mapped+shuffle");
+    runMappedRead<float>(col32, plain.batchSize, "mapped f32+shuffle");
+
+    cout << endl << "Train 5-64-10, batch 64\tsamples/s\tseconds\tstalled\terror" << endl;
+    runTrain(csv, shuffled, "csv+shuffle");
+    runTrain(bin, shuffled, "binary+shuffle");
+    runMappedTrain(col, plain.batchSize, "mapped+shuffle");
+
+    remove(csv.c_str());
+    remove(bin.c_str());
+    remove(col.c_str());
+    remove(col32.c_str());
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include "../include/Gemm.hpp"
+#include "../include/Layer.hpp"
+#include "../include/Matrix.hpp"
+
+using namespace std;
+
+#define BENCH_ROUNDS 7
+
+/**
+ * @brief Times one layer of the forward pass, separate passes against the fused kernel
+ * @param rows Neurons of the layer (M)
+ * @param cols Neurons of the previous layer (K)
+ * @param batch Samples per pass (N)
+ * @param steps Number of timed passes of each path per round
+ */
+static void run(int rows, int cols, int batch, int steps) {
+    Matrix w(rows, cols, false), x(cols, batch, false), bias(rows, 1, false);
+    Matrix vals(rows, batch, false), activated(rows, batch, false), derived(rows, batch, false);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            w.at(i, j) = sin(i * 3 + j * 0.7) * 0.1;
+        }
+        bias.at(i, 0) = 0.01 * i;
+    }
+    for (int i = 0; i < cols; i++) {
+        for (int j = 0; j < batch; j++) {
+            x.at(i, j) = cos(i * 1.3 + j);
+        }
+    }
+
+    // Warm up both paths (thread pool, pack buffers, caches)
+    Gemm::multiplyBiasActivate(w, x, bias, ACTIVATION_SOFTSIGN, vals, &activated, &derived);
+
+    // Best single pass of each path, alternating every pass so both see the same machine
+    // noise; a layer pass is only microseconds, so totals over many passes mostly measure
+    // the noise of a shared machine
+    double separate = 1e30;
+    double fused = 1e30;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int s = 0; s < steps; s++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            Gemm::multiply(w, x, vals);
+            vals.broadcastAddColumn(bias);
+            Layer::activateValues(ACTIVATION_SOFTSIGN, vals, activated, derived);
+            chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+            Gemm::multiplyBiasActivate(w, x, bias, ACTIVATION_SOFTSIGN, vals, &activated, &derived);
+            chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+            separate = min(separate, chrono::duration<double>(middle - start).count());
+            fused = min(fused, chrono::duration<double>(stop - middle).count());
+        }
+    }
+
+    cout << rows << "x" << cols << "\t" << batch
+         << "\t" << separate * 1e6 << "\t" << fused * 1e6
+         << "\t" << separate / fused << "x" << endl;
+}
+
+/**
+ * @brief Runs the layers of the main.cpp topology at batch sizes 1 and 64
+ * @param argc Argument count
+ * @param argv Optional number of timed passes per round
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    int steps = argc > 1 ? stoi(argv[1]) : 200;
+
+    cout << "Layer\tbatch\tseparate (us)\tfused (us)\tspeedup" << endl;
+    const int layers[][2] = { { 128, 5 }, { 256, 128 }, { 10, 256 } };
+    const int batches[] = { 1, 64 };
+    for (int b = 0; b < 2; b++) {
+        for (int l = 0; l < 3; l++) {
+            run(layers[l][0], layers[l][1], batches[b], steps);
+        }
+    }
+    return 0;
+}
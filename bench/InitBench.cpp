@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Initializer.hpp"
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+#define BENCH_ROUNDS 3
+
+/**
+ * @brief Sums a matrix, to compare fills bit for bit
+ */
+static double checksum(const Matrix& m) {
+    double sum = 0.0;
+    for (int r = 0; r < m.getNumRows(); r++) {
+        for (int c = 0; c < m.getNumCols(); c++) {
+            sum += m.at(r, c) * (1 + (r * 31 + c) % 7);
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Times the old per-element generator setup, one random_device and mt19937 per value
+ * @param m Matrix to fill
+ * @return Seconds
+ */
+static double runLegacy(Matrix& m) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < m.getNumRows(); r++) {
+        for (int c = 0; c < m.getNumCols(); c++) {
+            random_device rd;
+            mt19937 gen(rd());
+            uniform_real_distribution<> dis(0, 1);
+            m.at(r, c) = dis(gen);
+        }
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Times the uniform fill with a given number of threads
+ * @param m Matrix to fill
+ * @param threads Thread count
+ * @return Best seconds of BENCH_ROUNDS
+ */
+static double runUniform(Matrix& m, int threads) {
+    ThreadPool::setNumThreads(threads);
+    double best = 1e30;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Initializer::uniform(m, 0.0, 1.0, 42, 0);
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+/**
+ * @brief Compares the old per-element initialization with the counter-based generator,
+ *        checks that the values do not depend on the thread count, then reports the
+ *        moments of every scheme against their targets
+ * @param argc Argument count
+ * @param argv Optional matrix side
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    const int side = argc > 1 ? stoi(argv[1]) : 1024;
+    const int hardware = max(1, (int)thread::hardware_concurrency());
+    const int original = ThreadPool::global().getNumThreads();
+
+    Matrix legacy(side / 8, side, false);
+    double legacySeconds = runLegacy(legacy);
+    cout << "Uniform fill of " << side << "x" << side << " in ms" << endl;
+    cout << "random_device+mt19937 per value\t" << legacySeconds * 8 * 1e3 << " (extrapolated from " << side / 8 << " rows)" << endl;
+
+    Matrix m(side, side, false);
+    double reference = 0.0;
+    for (int threads = 1; threads <= max(4, hardware); threads *= 2) {
+        double seconds = runUniform(m, threads);
+        double sum = checksum(m);
+        if (threads == 1) {
+            reference = sum;
+        }
+        cout << "Philox, " << threads << " threads\t" << seconds * 1e3 << (sum == reference ? "\tsame values" : "\tDIFFERENT VALUES") << endl;
+    }
+    ThreadPool::setNumThreads(original);
+
+    cout << endl << "Scheme\t\tmean\tstd\ttarget std (512 x 256 weights)" << endl;
+    const InitScheme schemes[] = { INIT_UNIFORM, INIT_XAVIER_UNIFORM, INIT_XAVIER_NORMAL, INIT_HE_UNIFORM, INIT_HE_NORMAL };
+    const double targets[] = { sqrt(1.0 / 12), sqrt(2.0 / 768), sqrt(2.0 / 768), sqrt(2.0 / 256), sqrt(2.0 / 256) };
+    for (int s = 0; s < 5; s++) {
+        Matrix w(512, 256, false);
+        Initializer::initialize(w, schemes[s], 7, s);
+        double sum = 0.0, squares = 0.0;
+        for (int r = 0; r < 512; r++) {
+            for (int c = 0; c < 256; c++) {
+                sum += w.at(r, c);
+                squares += w.at(r, c) * w.at(r, c);
+            }
+        }
+        double mean = sum / (512 * 256);
+        cout << Initializer::getName(schemes[s]) << "\t" << mean << "\t" << sqrt(squares / (512 * 256) - mean * mean)
+             << "\t" << targets[s] << endl;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    NeuralNetwork nn({ 784, 4096, 4096, 10 }, 0.01, INIT_HE_NORMAL, 1);
+    cout << endl << "784-4096-4096-10 network with he_normal weights: "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e3 << " ms" << endl;
+    return 0;
+}
@@ -0,0 +1,302 @@
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BenchHarness.hpp"
+#include "../include/Gemm.hpp"
+#include "../include/Initializer.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Layer.hpp"
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/ThreadPool.hpp"
+
+#ifndef NN_BUILD_TYPE
+#define NN_BUILD_TYPE "unknown"
+#endif
+
+using namespace std;
+
+#define BENCH_BATCH 64
+#define BENCH_MODEL_PATH "nn_bench_model"
+// Networks with more weights than this skip the text model format and, with --quick, everything
+#define BENCH_LARGE_WEIGHTS 1000000
+
+/**
+ * @brief Formats a topology as "5-128-256-10"
+ * @param topology Neurons per layer
+ * @return Name
+ */
+static string topologyName(const vector<int>& topology) {
+    stringstream s;
+    for (size_t i = 0; i < topology.size(); i++) {
+        s << (i ? "-" : "") << topology[i];
+    }
+    return s.str();
+}
+
+/**
+ * @brief Counts the weights of a topology
+ * @param topology Neurons per layer
+ * @return Number of weights, biases excluded
+ */
+static double countWeights(const vector<int>& topology) {
+    double weights = 0;
+    for (size_t i = 0; i + 1 < topology.size(); i++) {
+        weights += (double)topology[i] * topology[i + 1];
+    }
+    return weights;
+}
+
+/**
+ * @brief Gets the size of a file
+ * @param path File
+ * @return Size in bytes
+ */
+static double fileSize(const string& path) {
+    ifstream in(path, ios::binary | ios::ate);
+    return in.is_open() ? (double)in.tellg() : 0.0;
+}
+
+/**
+ * @brief Times Matrix::operator* at the forward shape of a layer, W (M x K) * X (K x N)
+ * @param bench Harness
+ * @param m Neurons of the layer
+ * @param k Neurons of the previous layer
+ * @param n Samples
+ */
+static void benchGemm(BenchHarness& bench, int m, int k, int n) {
+    Matrix a(m, k, true), b(k, n, true);
+    stringstream name;
+    name << "gemm/" << m << "x" << k << "x" << n;
+    bench.run("gemm", name.str(), 2.0 * m * k * n, sizeof(double) * ((double)m * k + (double)k * n + (double)m * n), [&]() {
+        delete (a * b);
+    });
+}
+
+/**
+ * @brief Times the element-wise Matrix operations on one rows x cols operand
+ * @param bench Harness
+ * @param rows Rows
+ * @param cols Columns
+ */
+static void benchElementwise(BenchHarness& bench, int rows, int cols) {
+    Matrix a(rows, cols, true), b(rows, cols, true), out(rows, cols, false);
+    const double n = (double)rows * cols;
+    stringstream shape;
+    shape << rows << "x" << cols;
+
+    bench.run("elementwise", "add/" + shape.str(), n, 3 * n * sizeof(double), [&]() { delete (a + b); });
+    bench.run("elementwise", "sub/" + shape.str(), n, 3 * n * sizeof(double), [&]() { delete (a - b); });
+    bench.run("elementwise", "hadamard/" + shape.str(), n, 3 * n * sizeof(double), [&]() { a.elementwiseMultiply(b, out); });
+    bench.run("elementwise", "scale/" + shape.str(), n, 2 * n * sizeof(double), [&]() { a.scalarMultiply(1.0); });
+    bench.run("elementwise", "axpy/" + shape.str(), 2 * n, 3 * n * sizeof(double), [&]() { out.axpy(0.5, a); });
+    bench.run("elementwise", "transpose/" + shape.str(), 0, 2 * n * sizeof(double), [&]() { delete a.transpose(); });
+}
+
+/**
+ * @brief Times the copies Layer::matrixify* make of a layer
+ * @param bench Harness
+ * @param size Neurons of the layer
+ */
+static void benchLayer(BenchHarness& bench, int size) {
+    Layer layer(size);
+    for (int i = 0; i < size; i++) {
+        layer.setNeuronVal(i, 0.001 * i);
+    }
+    const double bytes = 2.0 * size * sizeof(double);
+    const string shape = to_string(size);
+
+    bench.run("layer", "matrixifyVals/" + shape, 0, bytes, [&]() { delete layer.matrixifyVals(); });
+    bench.run("layer", "matrixifyActivatedVals/" + shape, 0, bytes, [&]() { delete layer.matrixifyActivatedVals(); });
+    bench.run("layer", "matrixifyDerivedVals/" + shape, 0, bytes, [&]() { delete layer.matrixifyDerivedVals(); });
+}
+
+/**
+ * @brief Times a whole network: single-sample passes, batch training and the model files
+ *
+ * FLOP counts are the multiply-adds of the weight matrices: 2 per weight forward, and
+ * 6 per weight for a training step (delta propagation, weight gradient and update).
+ * Bytes for the passes count one sweep over the weights per matrix product.
+ *
+ * @param bench Harness
+ * @param topology Neurons per layer
+ */
+static void benchNetwork(BenchHarness& bench, const vector<int>& topology) {
+    const string name = topologyName(topology);
+    const double weights = countWeights(topology);
+    const double weightBytes = weights * sizeof(double);
+
+    Initializer::setSeed(1);
+    NeuralNetwork nn(topology, 0.0001, INIT_XAVIER_UNIFORM);
+    nn.setActivation((int)topology.size() - 1, ACTIVATION_IDENTITY);
+
+    vector<double> input(topology.front()), target(topology.back());
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = 0.1 * (i % 10);
+    }
+    for (size_t i = 0; i < target.size(); i++) {
+        target[i] = (double)(i % 3);
+    }
+    nn.setCurrentInput(input);
+    nn.setCurrentTarget(target);
+
+    bench.run("network", "feedForward/" + name, 2 * weights, weightBytes, [&]() { nn.feedForward(); });
+    nn.feedForward();
+    bench.run("network", "backPropogate/" + name, 4 * weights, 4 * weightBytes, [&]() { nn.backPropogate(); });
+    bench.run("network", "step/" + name, 6 * weights, 5 * weightBytes, [&]() {
+        nn.feedForward();
+        nn.backPropogate();
+    });
+
+    Matrix inputs(topology.front(), BENCH_BATCH, true), targets(topology.back(), BENCH_BATCH, true);
+    bench.run("train", "trainBatch" + to_string(BENCH_BATCH) + "/" + name, 6 * weights * BENCH_BATCH, 5 * weightBytes, [&]() {
+        nn.trainBatch(inputs, targets);
+    });
+
+    const string binary = BENCH_MODEL_PATH ".nn";
+    nn.saveModel(binary);
+    const double binaryBytes = fileSize(binary);
+    bench.run("model", "saveModel/binary/" + name, 0, binaryBytes, [&]() { nn.saveModel(binary); });
+    bench.run("model", "load/binary/" + name, 0, binaryBytes, [&]() { NeuralNetwork loaded(binary); });
+    remove(binary.c_str());
+
+    if (weights <= BENCH_LARGE_WEIGHTS) {
+        const string text = BENCH_MODEL_PATH ".txt";
+        nn.saveModel(text, MODEL_TEXT);
+        const double textBytes = fileSize(text);
+        bench.run("model", "saveModel/text/" + name, 0, textBytes, [&]() { nn.saveModel(text, MODEL_TEXT); });
+        bench.run("model", "load/text/" + name, 0, textBytes, [&]() { NeuralNetwork loaded(text); });
+        remove(text.c_str());
+    }
+}
+
+/**
+ * @brief Runs the benchmark suite over the main.cpp topology up to multi-thousand-neuron
+ *        layers and writes the results as JSON
+ *
+ * Options:
+ *   --json <path>        Output file (default nn_bench.json)
+ *   --baseline <path>    Compare medians with an earlier output, exit code 1 on regression
+ *   --threshold <ratio>  Relative slowdown counted as a regression (default 0.1)
+ *   --filter <text>      Only run cases whose name contains text
+ *   --quick              Skip the networks with more than a million weights
+ *   --min-time <s>       Minimum timed seconds per case (default 0.5)
+ *
+ * @param argc Argument count
+ * @param argv Options
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    string jsonPath = "nn_bench.json";
+    string baselinePath;
+    string filter;
+    double threshold = 0.1;
+    double minSeconds = 0.5;
+    bool quick = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        }
+        else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        }
+        else if (arg == "--threshold" && hasValue) {
+            threshold = stod(argv[++i]);
+        }
+        else if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        }
+        else if (arg == "--min-time" && hasValue) {
+            minSeconds = stod(argv[++i]);
+        }
+        else if (arg == "--quick") {
+            quick = true;
+        }
+        else {
+            cerr << "Usage: " << argv[0] << " [--json path] [--baseline path] [--threshold ratio] [--filter text] [--quick] [--min-time s]" << endl;
+            return 2;
+        }
+    }
+
+    BenchHarness bench(1, 5, 1000, minSeconds);
+    bench.setFilter(filter);
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    bench.setContext("date", date);
+    bench.setContext("build_type", NN_BUILD_TYPE);
+    bench.setContext("compiler", __VERSION__);
+    bench.setContext("isa", Kernels::getIsaName());
+    bench.setContext("gemm_kernel", Gemm::getKernelName(Gemm::getKernel()));
+    bench.setContext("threads", to_string(ThreadPool::global().getNumThreads()));
+    if (string(NN_BUILD_TYPE) == "Debug") {
+        cerr << "Warning: Debug build, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers" << endl;
+    }
+
+    vector<vector<int> > topologies;
+    topologies.push_back({ 5, 128, 256, 10 });
+    topologies.push_back({ 784, 512, 256, 10 });
+    topologies.push_back({ 1024, 2048, 2048, 10 });
+    topologies.push_back({ 784, 4096, 4096, 10 });
+    if (quick) {
+        vector<vector<int> > small;
+        for (size_t t = 0; t < topologies.size(); t++) {
+            if (countWeights(topologies[t]) <= BENCH_LARGE_WEIGHTS) {
+                small.push_back(topologies[t]);
+            }
+        }
+        topologies = small;
+    }
+
+    BenchHarness::printHeader(cout);
+
+    // Every distinct layer shape at one sample and at a training batch
+    set<pair<int, int> > shapes;
+    set<int> sizes;
+    for (size_t t = 0; t < topologies.size(); t++) {
+        for (size_t l = 0; l + 1 < topologies[t].size(); l++) {
+            shapes.insert(make_pair(topologies[t][l + 1], topologies[t][l]));
+        }
+        for (size_t l = 0; l < topologies[t].size(); l++) {
+            sizes.insert(topologies[t][l]);
+        }
+    }
+    for (set<pair<int, int> >::iterator it = shapes.begin(); it != shapes.end(); ++it) {
+        benchGemm(bench, it->first, it->second, 1);
+        benchGemm(bench, it->first, it->second, BENCH_BATCH);
+    }
+
+    for (set<int>::iterator it = sizes.begin(); it != sizes.end(); ++it) {
+        if (*it >= 128) {
+            benchElementwise(bench, *it, BENCH_BATCH);
+        }
+        benchLayer(bench, *it);
+    }
+
+    for (size_t t = 0; t < topologies.size(); t++) {
+        benchNetwork(bench, topologies[t]);
+    }
+
+    if (!bench.writeJson(jsonPath)) {
+        return 2;
+    }
+    cout << "Results written to " << jsonPath << endl;
+
+    if (!baselinePath.empty()) {
+        int regressions = bench.compare(baselinePath, threshold);
+        if (regressions < 0) {
+            return 2;
+        }
+        cout << regressions << " regression(s) over " << threshold * 100 << "%" << endl;
+        return regressions > 0 ? 1 : 0;
+    }
+    return 0;
+}
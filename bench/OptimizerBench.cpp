@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/Initializer.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/Optimizer.hpp"
+
+using namespace std;
+
+#define BENCH_ROUNDS 5
+#define BENCH_VALUES 65536
+#define BENCH_RULES 5
+#define BENCH_SAMPLES 256
+#define BENCH_BATCH 16
+
+/**
+ * @brief Times one fused update per rule on every instruction set
+ * @param steps Number of timed updates of BENCH_VALUES parameters per round
+ */
+template <typename T>
+static void runKernels(int steps) {
+    BasicMatrix<T> w(1, BENCH_VALUES, false), g(1, BENCH_VALUES, false);
+    for (int i = 0; i < BENCH_VALUES; i++) {
+        g.at(0, i) = (T)(0.01 * sin(i * 0.37));
+    }
+    vector<BasicMatrix<T>*> params(1, &w);
+
+    const KernelIsa isas[] = { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_AVX512 };
+    const KernelIsa active = Kernels::getIsa();
+    for (int r = 0; r < BENCH_RULES; r++) {
+        OptimizerConfig config((OptimizerType)r);
+        config.weightDecay = 0.01;
+        cout << Optimizer::getName(config.type) << "\t" << (sizeof(T) == sizeof(double) ? "f64" : "f32");
+
+        for (int k = 0; k < 4; k++) {
+            if (!Kernels::setIsa(isas[k])) {
+                cout << "\t-";
+                continue;
+            }
+            BasicOptimizer<T> optimizer(config);
+            optimizer.reset(params, 1);
+
+            double best = 1e30;
+            for (int round = 0; round < BENCH_ROUNDS; round++) {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                for (int s = 0; s < steps; s++) {
+                    optimizer.beginStep();
+                    optimizer.update(0, w, g, 1e-3, 1.0);
+                }
+                best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+            }
+            cout << "\t" << best / steps / BENCH_VALUES * 1e9;
+        }
+        cout << endl;
+    }
+    Kernels::setIsa(active);
+}
+
+/**
+ * @brief Trains the same network with every rule and reports the error per epoch
+ * @param epochs Number of epochs
+ * @param learningRates Learning rate of each rule
+ */
+static void runTraining(int epochs, const double* learningRates) {
+    // Smooth 4 -> 2 regression target
+    vector<vector<double>> inputs, targets;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        vector<double> x(4);
+        for (int j = 0; j < 4; j++) {
+            x.at(j) = sin(i * 0.61 + j * 1.7);
+        }
+        inputs.push_back(x);
+        targets.push_back({ 0.5 * sin(x.at(0) + x.at(1)), 0.5 * x.at(2) * x.at(3) });
+    }
+
+    const int reported[] = { 1, 5, 10, 25, 50, 100 };
+    for (int r = 0; r < BENCH_RULES; r++) {
+        Initializer::setSeed(1);
+        NeuralNetwork nn({ 4, 32, 32, 2 }, learningRates[r]);
+        nn.setActivation(3, ACTIVATION_IDENTITY);
+        nn.setOptimizer(OptimizerConfig((OptimizerType)r));
+        cout << Optimizer::getName((OptimizerType)r) << "\t" << learningRates[r];
+
+        int next = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int e = 1; e <= epochs; e++) {
+            double sum = 0.0;
+            for (int b = 0; b < BENCH_SAMPLES; b += BENCH_BATCH) {
+                vector<vector<double>> x(inputs.begin() + b, inputs.begin() + b + BENCH_BATCH);
+                vector<vector<double>> t(targets.begin() + b, targets.begin() + b + BENCH_BATCH);
+                nn.trainBatch(x, t);
+                sum += nn.getError();
+            }
+            if (next < 6 && e == reported[next]) {
+                cout << "\t" << sum / (BENCH_SAMPLES / BENCH_BATCH);
+                next++;
+            }
+        }
+        cout << "\t" << chrono::duration<double>(chrono::steady_clock::now() - start).count() / epochs * 1e3 << endl;
+    }
+}
+
+/**
+ * @brief Times the fused update kernels per instruction set, then compares how fast each
+ *        rule brings the training error down
+ * @param argc Argument count
+ * @param argv Optional number of timed updates per round
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    int steps = argc > 1 ? stoi(argv[1]) : 100;
+
+    cout << "Fused update in ns per parameter, active ISA " << Kernels::getIsaName() << endl;
+    cout << "Rule\ttype\tscalar\tsse2\tavx2\tavx512" << endl;
+    runKernels<double>(steps);
+    runKernels<float>(steps);
+
+    cout << endl << "Mean batch error after epoch, batch " << BENCH_BATCH << ", and ms per epoch" << endl;
+    cout << "Rule\tlr\t1\t5\t10\t25\t50\t100\tms" << endl;
+    const double learningRates[BENCH_RULES] = { 0.05, 0.05, 0.05, 0.002, 0.002 };
+    runTraining(100, learningRates);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+
+using namespace std;
+
+/**
+ * @brief Samples of the main.cpp problem repeated to fill a batch
+ * @param size Number of samples
+ * @param inputs Receives the inputs
+ * @param targets Receives the targets
+ */
+static void makeBatch(int size, vector<vector<double>>& inputs, vector<vector<double>>& targets) {
+    const double input[] = { 1, 2, 3, 4, 5 };
+    const double target[] = { 10, 4, 3, 2, 1, 0, 9, 8, 7, 6 };
+    for (int k = 0; k < size; k++) {
+        // Scaled per sample so the columns differ
+        double s = 1.0 + 0.01 * (k % 7);
+        vector<double> in, out;
+        for (int i = 0; i < 5; i++) {
+            in.push_back(input[i] * s);
+        }
+        for (int i = 0; i < 10; i++) {
+            out.push_back(target[i]);
+        }
+        inputs.push_back(in);
+        targets.push_back(out);
+    }
+}
+
+/**
+ * @brief Times training and inference of one network configuration
+ * @param name Label of the configuration
+ * @param masterWeights Keep a double master copy of the weights
+ * @param batchSize Samples per trainBatch/predictBatch call
+ * @param steps Number of timed calls
+ */
+template <typename T>
+static void run(const string& name, bool masterWeights, int batchSize, int steps) {
+    vector<int> topology;
+    topology.push_back(5);
+    topology.push_back(128);
+    topology.push_back(256);
+    topology.push_back(10);
+
+    vector<vector<double>> inputs, targets;
+    makeBatch(batchSize, inputs, targets);
+
+    BasicNeuralNetwork<T> nn(topology, 0.0001);
+    nn.setMasterWeights(masterWeights);
+    nn.reserveHistory(steps + 1);
+
+    // Warm up: sizes the workspaces and starts the thread pool
+    nn.trainBatch(inputs, targets);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+        nn.trainBatch(inputs, targets);
+    }
+    double train = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+        delete nn.predictBatch(inputs);
+    }
+    double infer = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double samples = (double)steps * batchSize;
+    cout << name << "\t" << batchSize
+         << "\t" << (long)(samples / train) << "\t" << (long)(samples / infer)
+         << "\t" << nn.getError() << endl;
+}
+
+/**
+ * @brief Compares double, float and float with master weights on the main.cpp topology
+ * @param argc Argument count
+ * @param argv Optional number of timed steps
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    int steps = argc > 1 ? stoi(argv[1]) : 200;
+
+    cout << "Topology 5-128-256-10, " << steps << " steps per configuration" << endl;
+    cout << "dtype\t\tbatch\ttrain/s\tinfer/s\terror" << endl;
+    const int batches[] = { 1, 64 };
+    for (int b = 0; b < 2; b++) {
+        run<double>("float64\t", false, batches[b], steps);
+        run<float>("float32\t", false, batches[b], steps);
+        run<float>("float32+master", true, batches[b], steps);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "../include/Initializer.hpp"
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/Profiler.hpp"
+
+using namespace std;
+
+#define BENCH_ROUNDS 5
+#define BENCH_BATCH 64
+
+/**
+ * @brief Times training steps with recording on or off
+ * @param nn Network
+ * @param inputs Batch inputs
+ * @param targets Batch targets
+ * @param steps Steps per round
+ * @param record Whether the profiler records
+ * @return Best seconds per step over BENCH_ROUNDS
+ */
+static double runSteps(NeuralNetwork& nn, const Matrix& inputs, const Matrix& targets, int steps, bool record) {
+    Profiler::setEnabled(record);
+    double best = 1e30;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            nn.trainBatch(inputs, targets);
+        }
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count() / steps);
+    }
+    Profiler::setEnabled(true);
+    return best;
+}
+
+/**
+ * @brief Measures what recording costs per training step on a small and a wide network,
+ *        then profiles both passes of the wide one and exports the trace
+ * @param argc Argument count
+ * @param argv Optional number of steps per round
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    const int steps = argc > 1 ? stoi(argv[1]) : 20;
+    if (!Profiler::isCompiledIn()) {
+        cout << "Built without NN_PROFILE: the scopes are compiled out, configure with -DNN_PROFILE=ON to record" << endl;
+    }
+
+    cout << "Topology\tbatch\tpaused (us)\trecording (us)\toverhead" << endl;
+    const vector<int> topologies[] = { { 5, 128, 256, 10 }, { 784, 1024, 1024, 10 } };
+    for (int t = 0; t < 2; t++) {
+        const vector<int>& topology = topologies[t];
+        Initializer::setSeed(1);
+        NeuralNetwork nn(topology, 0.0001, INIT_XAVIER_UNIFORM);
+        Matrix inputs(topology.front(), BENCH_BATCH, true), targets(topology.back(), BENCH_BATCH, true);
+        nn.trainBatch(inputs, targets);
+
+        double paused = runSteps(nn, inputs, targets, steps, false);
+        double recording = runSteps(nn, inputs, targets, steps, true);
+        cout << topology.front() << "-" << topology[1] << "-" << topology[2] << "-" << topology.back() << "\t" << BENCH_BATCH
+             << "\t" << paused * 1e6 << "\t" << recording * 1e6 << "\t" << (recording / paused - 1.0) * 100 << "%" << endl;
+
+        if (t == 1 && Profiler::isCompiledIn()) {
+            Profiler::reset();
+            for (int s = 0; s < steps; s++) {
+                nn.trainBatch(inputs, targets);
+            }
+            cout << endl;
+            Profiler::printSummary(cout);
+            if (Profiler::writeChromeTrace("nn_profile_bench.json")) {
+                cout << "Trace of " << steps << " steps written to nn_profile_bench.json" << endl;
+            }
+        }
+    }
+    return 0;
+}
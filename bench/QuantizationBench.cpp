@@ -0,0 +1,60 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/QuantizedNetwork.hpp"
+
+using namespace std;
+
+/**
+ * @brief Times predict of the double network against the int8 engine on the main.cpp
+ *        topology and prints the accuracy report
+ * @param argc Argument count
+ * @param argv Optional number of timed predictions
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    int steps = argc > 1 ? stoi(argv[1]) : 2000;
+
+    vector<int> topology;
+    topology.push_back(5);
+    topology.push_back(128);
+    topology.push_back(256);
+    topology.push_back(10);
+
+    // Inputs around the main.cpp sample, half for calibration and half for the report
+    vector<vector<double>> calibration, inputs;
+    for (int k = 0; k < 256; k++) {
+        vector<double> in;
+        for (int i = 0; i < 5; i++) {
+            in.push_back((i + 1) * (0.5 + (double)((k * 37 + i * 11) % 100) / 100.0));
+        }
+        (k % 2 == 0 ? calibration : inputs).push_back(in);
+    }
+
+    NeuralNetwork nn(topology, 0.01);
+    QuantizedNetwork q8(nn, calibration);
+    QuantizedNetwork::printReport(q8.evaluate(nn, inputs));
+
+    vector<double> output(topology.back());
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+        delete nn.predict(inputs.at(i % inputs.size()));
+    }
+    double f64 = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+        q8.predictInto(inputs.at(i % inputs.size()).data(), output.data());
+    }
+    double int8 = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "==========" << endl;
+    cout << "Latency per predict (" << Kernels::getIsaName() << "): " << endl;
+    cout << "float64:\t" << f64 / steps * 1e6 << " us" << endl;
+    cout << "int8:\t\t" << int8 / steps * 1e6 << " us" << endl;
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/Initializer.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/Trainer.hpp"
+
+using namespace std;
+
+#define BENCH_SAMPLES 2048
+#define BENCH_VALIDATION 512
+
+/**
+ * @brief Fills a smooth 4 -> 2 regression set
+ * @param first Index of the first sample, so training and validation sets differ
+ * @param count Number of samples
+ * @param inputs Receives the input vectors
+ * @param targets Receives the target vectors
+ */
+static void makeSet(int first, int count, vector<vector<double>>& inputs, vector<vector<double>>& targets) {
+    for (int i = first; i < first + count; i++) {
+        vector<double> x(4);
+        for (int j = 0; j < 4; j++) {
+            x.at(j) = sin(i * 0.61 + j * 1.7);
+        }
+        inputs.push_back(x);
+        targets.push_back({ 0.5 * sin(x.at(0) + x.at(1)), 0.5 * x.at(2) * x.at(3) });
+    }
+}
+
+/**
+ * @brief Trains with one learning rate schedule and reports the losses
+ * @param label Printed name of the run
+ * @param config Trainer configuration
+ */
+static void runSchedule(const string& label, const TrainerConfig& config) {
+    vector<vector<double>> inputs, targets, validationInputs, validationTargets;
+    makeSet(0, BENCH_SAMPLES, inputs, targets);
+    makeSet(BENCH_SAMPLES, BENCH_VALIDATION, validationInputs, validationTargets);
+
+    Initializer::setSeed(1);
+    NeuralNetwork nn({ 4, 32, 32, 2 }, 0.01);
+    nn.setActivation(3, ACTIVATION_IDENTITY);
+    nn.setOptimizer(OptimizerConfig(OPTIMIZER_ADAM));
+    Trainer trainer(nn, config);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    const vector<TrainerEpoch>& history = trainer.fit(inputs, targets, validationInputs, validationTargets);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << label << "\t" << history.size() << "\t" << history.back().trainLoss << "\t" << trainer.getBestValidationLoss()
+         << "\t" << trainer.getBestEpoch() << "\t" << seconds << endl;
+}
+
+/**
+ * @brief Compares the training thread time of a synchronous save with an asynchronous checkpoint
+ * @param width Hidden layer size
+ * @param rounds Number of checkpoints
+ */
+static void runCheckpoint(int width, int rounds) {
+    const string path = "nn_trainer_bench.nn";
+    NeuralNetwork nn({ 64, width, width, 10 }, 0.01);
+    Trainer trainer(nn);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        nn.saveModel(path);
+    }
+    double sync = chrono::duration<double>(chrono::steady_clock::now() - start).count() / rounds;
+
+    for (int r = 0; r < rounds; r++) {
+        trainer.checkpoint(path);
+        trainer.waitForCheckpoints();
+    }
+    double async = trainer.getCheckpointSeconds() / rounds;
+
+    cout << "64-" << width << "-" << width << "-10\t" << sync * 1e3 << "\t" << async * 1e3 << endl;
+    remove(path.c_str());
+}
+
+/**
+ * @brief Compares learning rate schedules and early stopping on a small regression, then
+ *        how long a checkpoint holds up training when saved synchronously or in the background
+ * @param argc Argument count
+ * @param argv Optional number of epochs
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    TrainerConfig base;
+    base.epochs = argc > 1 ? stoi(argv[1]) : 40;
+    base.batchSize = 16;
+    base.logEvery = 0;
+
+    cout << "Schedule\tepochs\ttrain\tbest val\tat\ts" << endl;
+    runSchedule("constant", base);
+    TrainerConfig step = base;
+    step.schedule = SCHEDULE_STEP;
+    step.stepEpochs = base.epochs / 3;
+    runSchedule("step", step);
+    TrainerConfig cosine = base;
+    cosine.schedule = SCHEDULE_COSINE;
+    runSchedule("cosine", cosine);
+    cosine.warmupSteps = BENCH_SAMPLES / base.batchSize;
+    runSchedule("warmup+cosine", cosine);
+    TrainerConfig early = base;
+    early.patience = 3;
+    early.minDelta = 1e-5;
+    runSchedule("early stop", early);
+
+    cout << endl << "Checkpoint ms on the training thread\tsaveModel\tTrainer::checkpoint" << endl;
+    runCheckpoint(256, 10);
+    runCheckpoint(1024, 5);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include "../include/Gemm.hpp"
+#include "../include/Matrix.hpp"
+
+using namespace std;
+
+#define BENCH_ROUNDS 7
+
+/**
+ * @brief Largest absolute difference between two matrices of the same shape
+ * @param a First matrix
+ * @param b Second matrix
+ * @return max |a - b|
+ */
+static double maxDifference(const Matrix& a, const Matrix& b) {
+    double diff = 0.0;
+    for (int i = 0; i < a.getNumRows(); i++) {
+        for (int j = 0; j < a.getNumCols(); j++) {
+            diff = max(diff, fabs(a.at(i, j) - b.at(i, j)));
+        }
+    }
+    return diff;
+}
+
+/**
+ * @brief Times the two backpropagation products of one weight matrix, transposing copies
+ *        first against reading the operands in place with the transpose flags
+ *
+ * The weight gradient is delta * vals^T and the delta of the previous layer weights^T * delta.
+ * @param rows Neurons of the layer (M)
+ * @param cols Neurons of the previous layer (K)
+ * @param batch Samples per step (N)
+ * @param steps Number of timed steps per round
+ */
+static void run(int rows, int cols, int batch, int steps) {
+    Matrix w(rows, cols, false), vals(cols, batch, false), delta(rows, batch, false);
+    Matrix gradient(rows, cols, false), prevDelta(cols, batch, false);
+    Matrix gradientCopy(rows, cols, false), prevDeltaCopy(cols, batch, false);
+    // Preallocated transposes, as the training workspaces kept them
+    Matrix valsT(batch, cols, false), weightsT(cols, rows, false);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            w.at(i, j) = sin(i * 3 + j * 0.7) * 0.1;
+        }
+        for (int j = 0; j < batch; j++) {
+            delta.at(i, j) = cos(i * 0.9 + j) * 0.01;
+        }
+    }
+    for (int i = 0; i < cols; i++) {
+        for (int j = 0; j < batch; j++) {
+            vals.at(i, j) = cos(i * 1.3 + j);
+        }
+    }
+
+    auto copied = [&]() {
+        vals.transposeInto(valsT);
+        Gemm::multiply(delta, valsT, gradientCopy);
+        w.transposeInto(weightsT);
+        Gemm::multiply(weightsT, delta, prevDeltaCopy);
+    };
+    auto allocated = [&]() {
+        Matrix* t = vals.transpose();
+        Gemm::multiply(delta, *t, gradientCopy);
+        delete t;
+        t = w.transpose();
+        Gemm::multiply(*t, delta, prevDeltaCopy);
+        delete t;
+    };
+    auto inPlace = [&]() {
+        Gemm::multiply(delta, vals, gradient, false, GEMM_NO_TRANSPOSE, GEMM_TRANSPOSE);
+        Gemm::multiply(w, delta, prevDelta, false, GEMM_TRANSPOSE, GEMM_NO_TRANSPOSE);
+    };
+
+    // Warm up all paths (thread pool, pack buffers, caches)
+    allocated();
+    copied();
+    inPlace();
+    const double diff = max(maxDifference(gradient, gradientCopy), maxDifference(prevDelta, prevDeltaCopy));
+
+    // Best of several alternating rounds, so every path sees the same machine noise
+    double times[3] = { 1e30, 1e30, 1e30 };
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            allocated();
+        }
+        times[0] = min(times[0], chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+        start = chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            copied();
+        }
+        times[1] = min(times[1], chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+        start = chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            inPlace();
+        }
+        times[2] = min(times[2], chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+
+    // Bytes written by the two transposes of every step, and held by their buffers
+    const size_t bytes = ((size_t)batch * cols + (size_t)cols * rows) * sizeof(double);
+    cout << rows << "x" << cols << "\t" << batch
+         << "\t" << times[0] / steps * 1e6 << "\t" << times[1] / steps * 1e6 << "\t" << times[2] / steps * 1e6
+         << "\t" << times[1] / times[2] << "x\t" << bytes / 1024.0 << "\t" << diff << endl;
+}
+
+/**
+ * @brief Runs the weight matrices of the main.cpp topology at batch sizes 1 and 64
+ * @param argc Argument count
+ * @param argv Optional number of timed steps per round
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    int steps = argc > 1 ? stoi(argv[1]) : 200;
+
+    cout << "Weights\tbatch\tallocated (us)\tcopied (us)\tin place (us)\tspeedup\tKiB saved\tmax diff" << endl;
+    const int layers[][2] = { { 256, 128 }, { 128, 5 }, { 10, 256 } };
+    const int batches[] = { 1, 64 };
+    for (int b = 0; b < 2; b++) {
+        for (int l = 0; l < 3; l++) {
+            run(layers[l][0], layers[l][1], batches[b], steps);
+        }
+    }
+    return 0;
+}
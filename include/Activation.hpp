@@ -0,0 +1,94 @@
+#ifndef _ACTIVATION_HPP_
+#define _ACTIVATION_HPP_
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Activation functions a layer can apply to its raw values
+ *
+ * The values are stored in model files and must not change.
+ */
+enum ActivationType {
+    ACTIVATION_SOFTSIGN = 0,    ///< x / (1 + |x|), the original "fast sigmoid" and the default
+    ACTIVATION_IDENTITY = 1,    ///< x, e.g. for a regression output layer
+    ACTIVATION_RELU = 2,        ///< max(x, 0)
+    ACTIVATION_LEAKY_RELU = 3,  ///< x for x > 0, ACTIVATION_LEAKY_SLOPE * x otherwise
+    ACTIVATION_TANH = 4,        ///< Hyperbolic tangent
+    ACTIVATION_SIGMOID = 5,     ///< Logistic sigmoid 1 / (1 + e^-x)
+    ACTIVATION_GELU = 6         ///< GELU, tanh approximation
+};
+
+/// Number of ActivationType values
+#define ACTIVATION_COUNT 7
+/// Slope of the leaky ReLU for negative inputs
+#define ACTIVATION_LEAKY_SLOPE 0.01
+/// sqrt(2 / pi), scale of the GELU tanh argument
+#define ACTIVATION_GELU_SCALE 0.7978845608028654
+/// Weight of the cubic term in the GELU tanh argument
+#define ACTIVATION_GELU_CUBIC 0.044715
+
+/**
+ * @class Activation
+ * @brief Activation functions and their derivatives
+ *
+ * apply runs the vectorized kernels of the active instruction set (see Kernels), which
+ * evaluate exp with a range reduction and polynomial instead of calling libm. value and
+ * derivative are the libm reference the kernels are checked against.
+ */
+class Activation {
+public:
+    /**
+     * @brief Applies an activation and its derivative to n contiguous values
+     * @param type Activation function
+     * @param vals Raw values
+     * @param activated Receives the activated values, may alias vals
+     * @param derived Receives the derivatives at vals, or null when they are not needed
+     * @param n Number of values
+     * @tparam T Element type, double or float
+     */
+    template <typename T>
+    static void apply(ActivationType type, const T* vals, T* activated, T* derived, size_t n);
+
+    /**
+     * @brief Evaluates an activation with the C library (reference)
+     * @param type Activation function
+     * @param val Raw value
+     * @return Activated value
+     */
+    static double value(ActivationType type, double val);
+
+    /**
+     * @brief Evaluates the derivative of an activation with the C library (reference)
+     * @param type Activation function
+     * @param val Raw value
+     * @param activatedVal value(type, val)
+     * @return Derivative at val
+     */
+    static double derivative(ActivationType type, double val, double activatedVal);
+
+    /**
+     * @brief Gets the printable name of an activation
+     * @param type Activation function
+     * @return Name such as "relu"
+     */
+    static const char* getName(ActivationType type);
+
+    /**
+     * @brief Looks up an activation by the name getName returns
+     * @param name Activation name
+     * @return Activation function
+     */
+    static ActivationType fromName(const string& name);
+
+    /**
+     * @brief Checks whether a stored id is a known activation
+     * @param id Value read from a model file
+     * @return True if id is an ActivationType
+     */
+    static bool isValid(long long id) { return id >= 0 && id < ACTIVATION_COUNT; }
+};
+
+#endif // _ACTIVATION_HPP_
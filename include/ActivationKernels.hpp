@@ -0,0 +1,195 @@
+#ifndef _ACTIVATIONKERNELS_HPP_
+#define _ACTIVATIONKERNELS_HPP_
+
+#include <cstring>
+#include "Activation.hpp"
+#include "Kernels.hpp"
+
+/**
+ * @struct ActivationKernels
+ * @brief Activation kernels written once against a register traits struct
+ * @tparam S Register operations of one instruction set and element type
+ * @tparam T Element type, double or float
+ *
+ * Each kernel translation unit instantiates this with its own traits (compiled with
+ * its own target flags), so nothing here may be used outside a template depending on S.
+ * S provides V and Mask, width, load, store, set1, add, sub, mul, div, min, max, abs,
+ * fmadd (a * b + c), fnmadd (c - a * b), copySign, greater, select and pow2.
+ *
+ * exp is evaluated Cephes style: x = n ln2 + r with |r| <= ln2 / 2, e^r from its Taylor
+ * polynomial (degree 12 for double, 7 for float, within an ulp or two of libm) and 2^n
+ * built directly in the exponent bits. Arguments are clamped to keep 2^n a normal number.
+ */
+template <typename S, typename T>
+struct ActivationKernels {
+    typedef typename S::V V;
+    typedef typename S::Mask Mask;
+
+    /// Whether T is double
+    static const bool wide = sizeof(T) == sizeof(double);
+    /// Degree of the polynomial for e^r
+    static const int expDegree = wide ? 12 : 7;
+
+    /**
+     * @brief Gets the Taylor coefficient 1 / i! of e^r
+     */
+    static NN_ALWAYS_INLINE T expCoefficient(int i) {
+        static const double c[] = {
+            1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320,
+            1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600
+        };
+        return (T)c[i];
+    }
+
+    /**
+     * @brief e^x of every lane
+     */
+    static NN_ALWAYS_INLINE V exp(V x) {
+        // 1.5 * 2^52 (2^23): adding it rounds to an integer held in the low mantissa bits
+        const T magic = wide ? (T)6755399441055744.0 : (T)12582912.0;
+        // ln2 split so n * ln2Hi is exact for the n that occur
+        const T ln2Hi = wide ? (T)6.93145751953125e-1 : (T)0.693359375;
+        const T ln2Lo = wide ? (T)1.42860682030941723212e-6 : (T)-2.12194440e-4;
+
+        x = S::max(S::min(x, S::set1(wide ? (T)709.0 : (T)88.0)), S::set1(wide ? (T)-708.0 : (T)-87.0));
+        const V t = S::fmadd(x, S::set1((T)1.4426950408889634), S::set1(magic));
+        const V n = S::sub(t, S::set1(magic));
+        V r = S::fnmadd(n, S::set1(ln2Hi), x);
+        r = S::fnmadd(n, S::set1(ln2Lo), r);
+
+        V p = S::set1(expCoefficient(expDegree));
+        for (int i = expDegree - 1; i >= 0; i--) {
+            p = S::fmadd(p, r, S::set1(expCoefficient(i)));
+        }
+        return S::mul(p, S::pow2(t));
+    }
+
+    /**
+     * @brief Activation (returned) and, if derive, its derivative (in d) of every lane
+     */
+    template <ActivationType type, bool derive>
+    static NN_ALWAYS_INLINE V eval(V x, V& d) {
+        const V one = S::set1((T)1);
+        switch (type) {
+            case ACTIVATION_SOFTSIGN: {
+                // One division gives both: f = x * g and f' = g * g with g = 1 / (1 + |x|)
+                const V g = S::div(one, S::add(one, S::abs(x)));
+                if (derive) {
+                    d = S::mul(g, g);
+                }
+                return S::mul(x, g);
+            }
+            case ACTIVATION_IDENTITY:
+                if (derive) {
+                    d = one;
+                }
+                return x;
+            case ACTIVATION_RELU: {
+                const V zero = S::set1((T)0);
+                if (derive) {
+                    d = S::select(S::greater(x, zero), one, zero);
+                }
+                return S::max(x, zero);
+            }
+            case ACTIVATION_LEAKY_RELU: {
+                const Mask positive = S::greater(x, S::set1((T)0));
+                const V slope = S::set1((T)ACTIVATION_LEAKY_SLOPE);
+                if (derive) {
+                    d = S::select(positive, one, slope);
+                }
+                return S::select(positive, x, S::mul(x, slope));
+            }
+            case ACTIVATION_TANH: {
+                // tanh|x| = (1 - e) / (1 + e) with e = e^-2|x|, which never overflows
+                const V e = exp(S::mul(S::abs(x), S::set1((T)-2)));
+                const V f = S::copySign(S::div(S::sub(one, e), S::add(one, e)), x);
+                if (derive) {
+                    d = S::fnmadd(f, f, one);
+                }
+                return f;
+            }
+            case ACTIVATION_SIGMOID: {
+                const V s = S::div(one, S::add(one, exp(S::sub(S::set1((T)0), x))));
+                if (derive) {
+                    d = S::fnmadd(s, s, s);
+                }
+                return s;
+            }
+            case ACTIVATION_GELU: {
+                // 0.5 x (1 + tanh(u)) = x * sigmoid(2u), without the cancellation of 1 + tanh
+                const T k0 = (T)(2 * ACTIVATION_GELU_SCALE);
+                const T k1 = (T)(2 * ACTIVATION_GELU_SCALE * ACTIVATION_GELU_CUBIC);
+                const V x2 = S::mul(x, x);
+                const V u2 = S::mul(x, S::fmadd(x2, S::set1(k1), S::set1(k0)));
+                const V s = S::div(one, S::add(one, exp(S::sub(S::set1((T)0), u2))));
+                if (derive) {
+                    // s + x s (1 - s) (2u)'
+                    const V du2 = S::fmadd(x2, S::set1(3 * k1), S::set1(k0));
+                    d = S::mul(s, S::fmadd(S::mul(x, S::sub(one, s)), du2, one));
+                }
+                return S::mul(x, s);
+            }
+        }
+        return x;
+    }
+
+    /**
+     * @brief Applies one activation to n values, a register at a time
+     *
+     * The tail goes through a register-sized buffer so every element gets exactly the
+     * vector result, wherever it sits in the array.
+     */
+    template <ActivationType type, bool derive>
+    static void loop(const T* x, T* a, T* d, size_t n) {
+        const size_t w = S::width;
+        V dv = S::set1((T)0);
+        size_t i = 0;
+        for (; i + w <= n; i += w) {
+            const V v = eval<type, derive>(S::load(x + i), dv);
+            S::store(a + i, v);
+            if (derive) {
+                S::store(d + i, dv);
+            }
+        }
+        if (i < n) {
+            T in[S::width] = {}, out[S::width], der[S::width];
+            memcpy(in, x + i, sizeof(T) * (n - i));
+            S::store(out, eval<type, derive>(S::load(in), dv));
+            memcpy(a + i, out, sizeof(T) * (n - i));
+            if (derive) {
+                S::store(der, dv);
+                memcpy(d + i, der, sizeof(T) * (n - i));
+            }
+        }
+    }
+
+    /**
+     * @brief Chooses the loop with or without derivatives
+     */
+    template <ActivationType type>
+    static void run(const T* x, T* a, T* d, size_t n) {
+        if (d != nullptr) {
+            loop<type, true>(x, a, d, n);
+        }
+        else {
+            loop<type, false>(x, a, d, n);
+        }
+    }
+
+    /**
+     * @brief Kernel entry point, see KernelOps::activate
+     */
+    static void activate(ActivationType type, const T* x, T* a, T* d, size_t n) {
+        switch (type) {
+            case ACTIVATION_SOFTSIGN: run<ACTIVATION_SOFTSIGN>(x, a, d, n); break;
+            case ACTIVATION_IDENTITY: run<ACTIVATION_IDENTITY>(x, a, d, n); break;
+            case ACTIVATION_RELU: run<ACTIVATION_RELU>(x, a, d, n); break;
+            case ACTIVATION_LEAKY_RELU: run<ACTIVATION_LEAKY_RELU>(x, a, d, n); break;
+            case ACTIVATION_TANH: run<ACTIVATION_TANH>(x, a, d, n); break;
+            case ACTIVATION_SIGMOID: run<ACTIVATION_SIGMOID>(x, a, d, n); break;
+            case ACTIVATION_GELU: run<ACTIVATION_GELU>(x, a, d, n); break;
+        }
+    }
+};
+
+#endif // _ACTIVATIONKERNELS_HPP_
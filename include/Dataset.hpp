@@ -0,0 +1,281 @@
+#ifndef _DATASET_HPP_
+#define _DATASET_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+#define DATASET_FILE_MAGIC "NNFSROW"
+#define DATASET_FILE_VERSION 1
+
+/**
+ * @brief Layouts a DatasetLoader can stream
+ */
+enum DatasetFormat {
+    DATASET_CSV,    ///< One sample per line, inputs then targets, separated by ',' (or ';' / tabs)
+    DATASET_BINARY  ///< DatasetFileHeader followed by fixed-width float32 rows
+};
+
+/**
+ * @struct DatasetFileHeader
+ * @brief First 32 bytes of a binary row file
+ *
+ * The header is followed by numRows rows of numInputs + numTargets float32 values, the
+ * inputs first, in the byte order of the writer.
+ */
+struct DatasetFileHeader {
+    char magic[8];        ///< DATASET_FILE_MAGIC, zero terminated
+    uint32_t version;     ///< DATASET_FILE_VERSION
+    uint32_t byteOrder;   ///< MODEL_FILE_BYTE_ORDER in the byte order of the writer
+    uint32_t numInputs;   ///< Input values per row
+    uint32_t numTargets;  ///< Target values per row
+    uint64_t numRows;     ///< Number of rows
+};
+
+/**
+ * @struct DatasetConfig
+ * @brief How a DatasetLoader groups and orders samples
+ */
+struct DatasetConfig {
+    size_t batchSize;       ///< Samples per batch
+    size_t shuffleWindow;   ///< Samples held back for shuffling, 0 or 1 keeps file order
+    size_t prefetch;        ///< Ready batches the reader may run ahead of training
+    int epochs;             ///< Passes over the file
+    bool dropLast;          ///< Whether to drop the short batch at the end of each epoch
+    bool skipHeader;        ///< Whether the first line of a CSV file is a header
+    unsigned int seed;      ///< Seed of the shuffle
+
+    /**
+     * @brief Constructor for DatasetConfig, unshuffled single pass in batches of 32
+     */
+    DatasetConfig()
+        : batchSize(32), shuffleWindow(0), prefetch(4), epochs(1), dropLast(false), skipHeader(false), seed(1) {}
+};
+
+/**
+ * @struct DatasetBatch
+ * @brief A batch of samples in the shape trainBatch and computeGradients take
+ */
+struct DatasetBatch {
+    vector<vector<double>> inputs;   ///< Input vectors, one per sample
+    vector<vector<double>> targets;  ///< Target vectors, one per sample
+    int epoch;                       ///< Pass over the file the samples come from
+};
+
+/**
+ * @class DatasetLoader
+ * @brief Streams training samples from a file on a background thread
+ *
+ * A reader thread parses the file a line (CSV) or a block of rows (binary) at a time,
+ * passes the samples through a shuffle window and assembles them into batches in a
+ * bounded ring of prefetch slots. Training takes batches from the other end and only
+ * waits when the reader falls behind; the reader waits when the ring is full. Memory use
+ * is bounded by the ring and the window, not the file.
+ *
+ * The shuffle keeps shuffleWindow samples: each new sample replaces a random one from the
+ * window, which is emitted, and the window is drained in random order at the end of
+ * every epoch. With a window at least as large as the file this is a full shuffle.
+ *
+ * Batches are handed over by swapping vectors with the caller, so once every slot has
+ * been used a steady state loop does not allocate.
+ */
+class DatasetLoader {
+public:
+    /**
+     * @brief Opens a dataset and starts the reader thread
+     *
+     * The format is detected from the file's magic. Binary files must have been written
+     * with the same numbers of inputs and targets.
+     * @param path Path to a CSV or binary row file
+     * @param numInputs Input values per sample
+     * @param numTargets Target values per sample
+     * @param config Batching, shuffling and prefetching
+     */
+    DatasetLoader(const string& path, int numInputs, int numTargets, const DatasetConfig& config = DatasetConfig());
+
+    /**
+     * @brief Destructor, stops and joins the reader thread
+     */
+    ~DatasetLoader();
+
+    /**
+     * @brief Takes the next batch, waiting for the reader if none is ready
+     * @param batch Receives the batch; its previous buffers are recycled by the reader
+     * @return False once every epoch has been delivered
+     */
+    bool next(DatasetBatch& batch);
+
+    /**
+     * @brief Takes the next single sample, for setCurrentInput/setCurrentTarget
+     * @param input Receives the input vector
+     * @param target Receives the target vector
+     * @return False once every epoch has been delivered
+     */
+    bool nextSample(vector<double>& input, vector<double>& target);
+
+    /**
+     * @brief Gets the format of the file
+     * @return Detected format
+     */
+    DatasetFormat getFormat() const { return this->format; }
+
+    /**
+     * @brief Gets the number of samples delivered so far
+     * @return Samples taken with next or nextSample
+     */
+    size_t getSamplesRead() const { return this->samplesRead; }
+
+    /**
+     * @brief Gets the time next spent waiting for the reader
+     * @return Seconds the training side was stalled on I/O or parsing
+     */
+    double getStallSeconds() const { return this->stallSeconds; }
+
+    /**
+     * @brief Checks whether a file is a binary row file
+     * @param path Path to check
+     * @return True if the file starts with DATASET_FILE_MAGIC
+     */
+    static bool isBinary(const string& path);
+
+private:
+    /**
+     * @brief Main loop of the reader thread
+     */
+    void readerLoop();
+
+    /**
+     * @brief Parses a CSV file, passing every row to push
+     * @return False if the loader is being destroyed
+     */
+    bool readCsv();
+
+    /**
+     * @brief Reads a binary row file, passing every row to push
+     * @return False if the loader is being destroyed
+     */
+    bool readBinary();
+
+    /**
+     * @brief Passes one row through the shuffle window
+     * @param row numInputs + numTargets values
+     * @return False if the loader is being destroyed
+     */
+    bool push(const double* row);
+
+    /**
+     * @brief Empties the shuffle window in random order and publishes the short batch
+     * @return False if the loader is being destroyed
+     */
+    bool finishEpoch();
+
+    /**
+     * @brief Copies one row into the batch being filled, publishing it when full
+     * @param row numInputs + numTargets values
+     * @return False if the loader is being destroyed
+     */
+    bool emit(const double* row);
+
+    /**
+     * @brief Hands the batch being filled to the training side and waits for a free slot
+     * @return False if the loader is being destroyed
+     */
+    bool publish();
+
+    /**
+     * @brief Reports malformed input and aborts
+     * @param message Description of the problem
+     */
+    void fail(const string& message);
+
+    string path;                  ///< Path of the dataset
+    DatasetFormat format;         ///< Format of the file
+    DatasetConfig config;         ///< Batching, shuffling and prefetching
+    int numInputs;                ///< Input values per sample
+    int numTargets;               ///< Target values per sample
+    int width;                    ///< numInputs + numTargets
+
+    // Reader thread only
+    vector<double> window;        ///< Shuffle window, width values per sample
+    size_t windowCount;           ///< Samples in the window
+    uint64_t rng;                 ///< State of the shuffle generator
+    size_t filling;               ///< Samples in the slot being filled
+    size_t fillSlot;              ///< Slot being filled, always free
+    int epoch;                    ///< Epoch being read
+    size_t line;                  ///< Line (CSV) or row (binary) being read, for errors
+
+    vector<DatasetBatch> slots;   ///< Ring of batches
+    size_t head;                  ///< Next slot to hand out
+    size_t count;                 ///< Ready slots
+    bool finished;                ///< Set by the reader after the last batch
+    bool stopping;                ///< Set by the destructor to stop the reader early
+    mutex lock;                   ///< Protects head, count, finished and stopping
+    condition_variable ready;     ///< Signals a published batch or the end
+    condition_variable space;     ///< Signals a free slot or shutdown
+    thread reader;                ///< Reader thread
+
+    // Training side only
+    DatasetBatch current;         ///< Batch nextSample takes samples from
+    size_t currentPos;            ///< Next sample of current
+    size_t samplesRead;           ///< Samples delivered
+    double stallSeconds;          ///< Time next waited for the reader
+};
+
+/**
+ * @class DatasetWriter
+ * @brief Writes samples to a binary row file one at a time
+ */
+class DatasetWriter {
+public:
+    /**
+     * @brief Creates a binary row file
+     * @param path Path to write to
+     * @param numInputs Input values per sample
+     * @param numTargets Target values per sample
+     */
+    DatasetWriter(const string& path, int numInputs, int numTargets);
+
+    /**
+     * @brief Destructor, closes the file if close was not called
+     */
+    ~DatasetWriter();
+
+    /**
+     * @brief Appends one sample
+     * @param input Input vector of numInputs values
+     * @param target Target vector of numTargets values
+     */
+    void append(const vector<double>& input, const vector<double>& target);
+
+    /**
+     * @brief Writes the row count into the header and closes the file
+     */
+    void close();
+
+    /**
+     * @brief Converts a CSV dataset to a binary row file, streaming
+     * @param csvPath CSV file to read
+     * @param path Binary file to write
+     * @param numInputs Input values per sample
+     * @param numTargets Target values per sample
+     * @param skipHeader Whether the first line of the CSV file is a header
+     * @return Number of rows written
+     */
+    static size_t fromCsv(const string& csvPath, const string& path, int numInputs, int numTargets, bool skipHeader = false);
+
+private:
+    ofstream file;          ///< Output file
+    string path;            ///< Path of the file, for error messages
+    int numInputs;          ///< Input values per sample
+    int numTargets;         ///< Target values per sample
+    uint64_t numRows;       ///< Rows written so far
+    vector<float> row;      ///< Row being written
+};
+
+#endif // _DATASET_HPP_
@@ -0,0 +1,221 @@
+#ifndef _GEMM_HPP_
+#define _GEMM_HPP_
+
+#include "Matrix.hpp"
+#include "Activation.hpp"
+
+/**
+ * @brief Matrix multiplication kernels selectable at runtime
+ */
+enum GemmKernel {
+    GEMM_NAIVE,   ///< Straight i-l-k triple loop over the operands
+    GEMM_BLOCKED  ///< Packed, cache-blocked kernel with a register-tiled micro-kernel
+};
+
+/**
+ * @brief How Gemm::multiply reads an operand
+ */
+enum GemmTranspose {
+    GEMM_NO_TRANSPOSE,  ///< As stored
+    GEMM_TRANSPOSE      ///< Transposed, read in place without a copy
+};
+
+/**
+ * @struct GemmOperand
+ * @brief Read-only view of a GEMM operand, possibly transposed, over the matrix's own storage
+ *
+ * Element (i, j) of the operand is data[i * rowStep + j * colStep]. The transpose of a
+ * row-major matrix is the same buffer with the two steps swapped, so kernels index
+ * through the view and never need a transposed copy.
+ */
+template <typename T>
+struct GemmOperand {
+    const T* data;      ///< First element
+    int rows;           ///< Rows of the operand as used in the product
+    int cols;           ///< Columns of the operand as used in the product
+    size_t rowStep;     ///< Distance between rows
+    size_t colStep;     ///< Distance between columns, 1 unless transposed
+
+    /**
+     * @brief Constructor for GemmOperand
+     * @param m Matrix
+     * @param transpose Whether the product uses the transpose of m
+     */
+    GemmOperand(const BasicMatrix<T>& m, GemmTranspose transpose)
+        : data(m.getData()),
+          rows(transpose == GEMM_TRANSPOSE ? m.getNumCols() : m.getNumRows()),
+          cols(transpose == GEMM_TRANSPOSE ? m.getNumRows() : m.getNumCols()),
+          rowStep(transpose == GEMM_TRANSPOSE ? 1 : m.getStride()),
+          colStep(transpose == GEMM_TRANSPOSE ? m.getStride() : 1) {}
+
+    /**
+     * @brief Gets an element
+     * @param i Row
+     * @param j Column
+     * @return Element (i, j)
+     */
+    T at(int i, int j) const { return this->data[(size_t)i * this->rowStep + (size_t)j * this->colStep]; }
+
+    /**
+     * @brief Gets the address of an element
+     * @param i Row
+     * @param j Column
+     * @return Pointer to element (i, j)
+     */
+    const T* ptr(int i, int j) const { return this->data + (size_t)i * this->rowStep + (size_t)j * this->colStep; }
+};
+
+/**
+ * @struct GemmEpilogue
+ * @brief Work applied to each output tile of a product once its sum is complete
+ *
+ * The bias of the row is added to c and, when activated is set, the activation is
+ * written to activated and (when derived is set) its derivative to derived. Any of the
+ * outputs may alias c.
+ */
+template <typename T>
+struct GemmEpilogue {
+    const BasicMatrix<T>* bias;  ///< Bias per row of c (M x 1)
+    ActivationType activation;   ///< Activation function
+    BasicMatrix<T>* activated;   ///< Receives the activated values, or null for bias only
+    BasicMatrix<T>* derived;     ///< Receives the derivatives, or null (inference)
+};
+
+/**
+ * @class Gemm
+ * @brief General matrix multiplication C = op(A) * op(B) behind Matrix::operator*
+ *
+ * The blocked kernel follows the classic Goto/BLIS layout: B is packed into kc x nc
+ * panels that stay in L2, A into mc x kc blocks that stay in L1/L2, and an MR x NR
+ * micro-kernel keeps its tile of C in registers for the whole kc loop. The micro-kernel
+ * and its tile shape come from the Kernels table of the host's instruction set (e.g.
+ * 6 x 8 doubles with AVX2, 12 x 16 with AVX-512). Matrix-vector
+ * (N == 1) and outer-product (K == 1) shapes skip packing and use dedicated loops.
+ *
+ * op(X) is X or its transpose. A transposed operand is read in place: packing gathers
+ * it in the order the micro-kernel wants whichever way it is stored, and the
+ * matrix-vector path for a transposed A runs over the rows of the stored matrix.
+ */
+class Gemm {
+public:
+    /**
+     * @brief Computes c = op(a) * op(b), or c += op(a) * op(b) when accumulate is set
+     * @param a Left operand, M x K once op is applied
+     * @param b Right operand, K x N once op is applied
+     * @param c Output (M x N), may be a view
+     * @param accumulate Whether to add to the existing contents of c
+     * @param transA Whether to use the transpose of a
+     * @param transB Whether to use the transpose of b
+     * @tparam T Element type, double or float
+     */
+    template <typename T>
+    static void multiply(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& c, bool accumulate = false,
+                         GemmTranspose transA = GEMM_NO_TRANSPOSE, GemmTranspose transB = GEMM_NO_TRANSPOSE);
+
+    /**
+     * @brief Computes one layer, c = a * b + bias, then its activation and derivative
+     *
+     * The epilogue runs on each output row (matrix-vector) or MR x NR tile (blocked)
+     * right after its last partial sum is stored, while it is still in L1, instead of
+     * as separate passes over the whole output. Results are identical to multiply
+     * followed by the bias add and Layer::activateValues.
+     * @param a Weights (M x K)
+     * @param b Input values (K x N), one column per sample
+     * @param bias Bias per row (M x 1)
+     * @param activation Activation function of the layer
+     * @param c Receives the raw values (M x N), may be a view
+     * @param activated Receives the activated values, or null to only add the bias
+     * @param derived Receives the derivatives, or null when they are not needed
+     * @tparam T Element type, double or float
+     */
+    template <typename T>
+    static void multiplyBiasActivate(const BasicMatrix<T>& a, const BasicMatrix<T>& b, const BasicMatrix<T>& bias,
+                                     ActivationType activation, BasicMatrix<T>& c, BasicMatrix<T>* activated,
+                                     BasicMatrix<T>* derived);
+
+    /**
+     * @brief Selects the kernel used by multiply
+     * @param kernel Kernel to use from now on
+     */
+    static void setKernel(GemmKernel kernel) { Gemm::kernel = kernel; }
+
+    /**
+     * @brief Gets the kernel used by multiply
+     * @return Active kernel
+     */
+    static GemmKernel getKernel() { return Gemm::kernel; }
+
+    /**
+     * @brief Gets a printable name for a kernel
+     * @param kernel Kernel to name
+     * @return Kernel name
+     */
+    static const char* getKernelName(GemmKernel kernel);
+
+    /**
+     * @brief Sets the cache block sizes of the blocked kernel
+     * @param mc Rows of A packed per block (L2 resident, rounded up to the tile rows)
+     * @param kc Depth of each packed panel (L1 resident)
+     * @param nc Columns of B packed per panel (L3/L2 resident, rounded up to the tile columns)
+     */
+    static void setBlockSizes(int mc, int kc, int nc);
+
+    /**
+     * @brief Gets the row block size of the blocked kernel
+     * @return mc
+     */
+    static int getBlockM() { return Gemm::mc; }
+
+    /**
+     * @brief Gets the depth block size of the blocked kernel
+     * @return kc
+     */
+    static int getBlockK() { return Gemm::kc; }
+
+    /**
+     * @brief Gets the column block size of the blocked kernel
+     * @return nc
+     */
+    static int getBlockN() { return Gemm::nc; }
+
+private:
+    /// @brief Checks the shapes and runs the kernel for them, with an optional epilogue
+    template <typename T>
+    static void dispatch(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c, bool accumulate,
+                         const GemmEpilogue<T>* epilogue);
+    /// @brief Reference i-l-k triple loop accumulating into c
+    template <typename T>
+    static void naive(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c);
+    /// @brief Packed, cache-blocked kernel accumulating into c
+    template <typename T>
+    static void blocked(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c,
+                        const GemmEpilogue<T>* epilogue = nullptr);
+    /// @brief Matrix-vector fast path (N == 1)
+    template <typename T>
+    static void gemv(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c,
+                     const GemmEpilogue<T>* epilogue = nullptr);
+    /// @brief Matrix-vector fast path for a transposed a (N == 1)
+    template <typename T>
+    static void gemvTransposed(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c,
+                               const GemmEpilogue<T>* epilogue = nullptr);
+    /// @brief Outer-product fast path (K == 1)
+    template <typename T>
+    static void outer(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c);
+
+    /// @brief Packs a block of a into MR-row panels
+    template <typename T>
+    static void packA(const GemmOperand<T>& a, int row, int depth, int rows, int depthLen, int MR, T* dst);
+    /// @brief Packs a panel of b into NR-column slivers
+    template <typename T>
+    static void packB(const GemmOperand<T>& b, int depth, int col, int depthLen, int cols, int NR, T* dst);
+    /// @brief Applies an epilogue to a rows x cols block of c
+    template <typename T>
+    static void applyEpilogue(const GemmEpilogue<T>& epilogue, BasicMatrix<T>& c, int row, int col, int rows, int cols);
+
+    static GemmKernel kernel;  ///< Kernel used by multiply
+    static int mc;             ///< Row block size
+    static int kc;             ///< Depth block size
+    static int nc;             ///< Column block size
+};
+
+#endif // _GEMM_HPP_
@@ -0,0 +1,150 @@
+#ifndef _GEMMKERNELS_HPP_
+#define _GEMMKERNELS_HPP_
+
+#include <cstddef>
+#include "Kernels.hpp"
+
+/**
+ * @struct GemmKernels
+ * @brief Blocked GEMM micro-kernel written once against a register traits struct
+ * @tparam S Register operations of one instruction set and element type
+ * @tparam T Element type, double or float
+ * @tparam MR Rows of the register tile
+ * @tparam NV Registers per row of the tile, so the tile is MR x (NV * S::width)
+ *
+ * Like ActivationKernels, each kernel translation unit instantiates this with its own
+ * traits and a tile sized for its register file: MR * NV accumulators, NV registers of
+ * packed B and one broadcast of packed A must all stay in registers for the depth loop.
+ * S provides V, width, load, store, set1, add and fmadd.
+ */
+template <typename S, typename T, int MR, int NV>
+struct GemmKernels {
+    typedef typename S::V V;
+
+    /// Rows of the tile
+    static const int rows = MR;
+    /// Columns of the tile
+    static const int cols = NV * (int)S::width;
+
+    /**
+     * @brief Gets the kernel table entry of this tile
+     * @return Tile shape and micro-kernel
+     */
+    static constexpr GemmMicroKernel<T> entry() { return { rows, cols, microKernel, fmaLoop }; }
+
+    /**
+     * @brief Accumulates one packed A panel times one packed B sliver into a tile of c
+     * @param depth Shared dimension of the panels
+     * @param a Packed A panel, MR values per step of depth
+     * @param b Packed B sliver, cols values per step of depth
+     * @param c Top-left element of the destination tile
+     * @param ldc Row stride of c
+     * @param validRows Rows of the tile inside c (<= MR)
+     * @param validCols Columns of the tile inside c (<= cols)
+     */
+    static void microKernel(size_t depth, const T* a, const T* b, T* c, size_t ldc, int validRows, int validCols) {
+        // The fixed-size loops are unrolled so every accumulator gets its own register;
+        // left rolled, -O2 keeps acc in memory and the depth loop becomes load/store bound
+        V acc[MR][NV];
+#pragma GCC unroll 32
+        for (int r = 0; r < MR; r++) {
+#pragma GCC unroll 8
+            for (int v = 0; v < NV; v++) {
+                acc[r][v] = S::set1(0);
+            }
+        }
+
+        for (size_t p = 0; p < depth; p++) {
+            V bv[NV];
+#pragma GCC unroll 8
+            for (int v = 0; v < NV; v++) {
+                bv[v] = S::load(b + v * S::width);
+            }
+#pragma GCC unroll 32
+            for (int r = 0; r < MR; r++) {
+                const V av = S::set1(a[r]);
+#pragma GCC unroll 8
+                for (int v = 0; v < NV; v++) {
+                    acc[r][v] = S::fmadd(av, bv[v], acc[r][v]);
+                }
+            }
+            a += MR;
+            b += cols;
+        }
+
+        if (validRows == MR && validCols == cols) {
+#pragma GCC unroll 32
+            for (int r = 0; r < MR; r++) {
+                T* cr = c + r * ldc;
+#pragma GCC unroll 8
+                for (int v = 0; v < NV; v++) {
+                    S::store(cr + v * S::width, S::add(S::load(cr + v * S::width), acc[r][v]));
+                }
+            }
+            return;
+        }
+
+        // Edge tile: spill the registers and add only the part inside c
+        T tile[MR * cols];
+#pragma GCC unroll 32
+        for (int r = 0; r < MR; r++) {
+#pragma GCC unroll 8
+            for (int v = 0; v < NV; v++) {
+                S::store(tile + r * cols + v * S::width, acc[r][v]);
+            }
+        }
+        for (int r = 0; r < validRows; r++) {
+            T* cr = c + r * ldc;
+            for (int j = 0; j < validCols; j++) {
+                cr[j] += tile[r * cols + j];
+            }
+        }
+    }
+
+    /**
+     * @brief Runs the depth loop's multiply-adds on registers alone, the compute ceiling of the tile
+     *
+     * Every accumulator is its own dependency chain, as in microKernel, but nothing is loaded,
+     * so the loop runs at the FMA throughput of the core. acc = acc * 0.5 + 0.5 stays near 1,
+     * clear of denormals and overflow.
+     * @param iterations Multiply-adds per accumulator
+     * @param sink Receives the sum of the accumulators, so the loop is not optimized away
+     */
+    static void fmaLoop(size_t iterations, T* sink) {
+        const V half = S::set1(0.5);
+        V acc[MR][NV];
+#pragma GCC unroll 32
+        for (int r = 0; r < MR; r++) {
+#pragma GCC unroll 8
+            for (int v = 0; v < NV; v++) {
+                acc[r][v] = S::set1(r + v);
+            }
+        }
+
+        for (size_t p = 0; p < iterations; p++) {
+#pragma GCC unroll 32
+            for (int r = 0; r < MR; r++) {
+#pragma GCC unroll 8
+                for (int v = 0; v < NV; v++) {
+                    acc[r][v] = S::fmadd(acc[r][v], half, half);
+                }
+            }
+        }
+
+        T tile[MR * cols];
+        T sum = 0;
+#pragma GCC unroll 32
+        for (int r = 0; r < MR; r++) {
+#pragma GCC unroll 8
+            for (int v = 0; v < NV; v++) {
+                S::store(tile + r * cols + v * S::width, acc[r][v]);
+            }
+        }
+        for (int i = 0; i < MR * cols; i++) {
+            sum += tile[i];
+        }
+        *sink = sum;
+    }
+};
+
+#endif // _GEMMKERNELS_HPP_
@@ -0,0 +1,131 @@
+#ifndef _INFERENCEMODEL_HPP_
+#define _INFERENCEMODEL_HPP_
+
+#include <string>
+#include <vector>
+#include "Matrix.hpp"
+#include "ModelFile.hpp"
+#include "NeuralNetwork.hpp"
+
+using namespace std;
+
+/**
+ * @class BasicInferenceModel
+ * @brief Immutable forward-only copy of a trained network
+ * @tparam T Element type, double (InferenceModel) or float
+ *
+ * The model only holds the weights and biases; every buffer a forward pass writes is
+ * supplied by the caller, so predict is const, never allocates (the GEMM packing buffers
+ * are thread-local and allocated on a thread's first call only) and any number of
+ * threads can share one model. Unlike NeuralNetwork::predict no derivatives are
+ * computed and no per-neuron state is touched.
+ *
+ * The forward pass matches NeuralNetwork::predict: the input layer feeds raw values,
+ * hidden layers activated ones (with each layer's activation function), and the raw
+ * output values are returned.
+ */
+template <typename T>
+class BasicInferenceModel {
+public:
+    /**
+     * @brief Copies the weights and biases of a trained network
+     * @param network Network to copy (later training does not affect the model)
+     */
+    BasicInferenceModel(BasicNeuralNetwork<T>& network);
+
+    /**
+     * @brief Loads a model file
+     *
+     * Binary model files of the same dtype are memory-mapped and shared read-only
+     * (see ModelFile); other files are read and converted.
+     * @param path Path to the saved model file
+     */
+    BasicInferenceModel(const string& path);
+
+    /**
+     * @brief Destructor to clean up memory
+     */
+    ~BasicInferenceModel();
+
+    /**
+     * @brief Runs one sample through the network
+     * @param input Input values, getInputSize() of them
+     * @param output Receives getOutputSize() raw output values
+     * @param scratch Caller buffer of at least getScratchSize() values, not shared
+     *                between concurrent calls
+     */
+    void predict(const T* input, T* output, T* scratch) const;
+
+    /**
+     * @brief Runs a batch of samples through the network, one sample per column
+     * @param inputs Input values (getInputSize() x count), may be a view
+     * @param outputs Receives the raw outputs (getOutputSize() x count), may be a view
+     * @param scratch Caller buffer of at least getScratchSize(count) values, not shared
+     *                between concurrent calls
+     */
+    void predictBatch(const BasicMatrix<T>& inputs, BasicMatrix<T>& outputs, T* scratch) const;
+
+    /**
+     * @brief Gets the size of the scratch buffer a forward pass needs
+     * @param count Number of samples per call
+     * @return Number of T values
+     */
+    size_t getScratchSize(int count = 1) const { return 2 * (size_t)this->widestHidden * count; }
+
+    /**
+     * @brief Gets the number of input values per sample
+     * @return Input layer size
+     */
+    int getInputSize() const { return this->topology.front(); }
+
+    /**
+     * @brief Gets the number of output values per sample
+     * @return Output layer size
+     */
+    int getOutputSize() const { return this->topology.back(); }
+
+    /**
+     * @brief Gets the network topology
+     * @return Neurons per layer
+     */
+    vector<int> getTopology() const { return this->topology; }
+
+    /**
+     * @brief Gets the activation function of a layer
+     * @param index Layer index
+     * @return Activation function
+     */
+    ActivationType getActivation(int index) const { return this->activations.at(index); }
+
+    /**
+     * @brief Gets the element type of the model
+     * @return Dtype of the weights
+     */
+    ModelDtype getDtype() const { return ModelDtypeOf<T>::value; }
+
+private:
+    /**
+     * @brief Sets up the topology bookkeeping once the weights are in place
+     */
+    void finishLoad();
+
+    /**
+     * @brief Forward pass from input to output columns
+     * @param input Input layer values (one column per sample)
+     * @param output Receives the raw output values
+     * @param scratch Two hidden-layer buffers of widestHidden x count values
+     */
+    void forward(const BasicMatrix<T>& input, BasicMatrix<T>& output, T* scratch) const;
+
+    vector<int> topology;                ///< Neurons per layer
+    vector<ActivationType> activations;  ///< Activation of each layer
+    vector<BasicMatrix<T>*> weights;     ///< Weight matrices between layers
+    vector<BasicMatrix<T>*> biases;      ///< Bias of every layer (index 0 is unused by the pass)
+    int widestHidden;                    ///< Largest hidden layer, sizes the scratch buffer
+    ModelFile* modelFile;                ///< Mapping the weights live in when loaded from a binary file
+};
+
+typedef BasicInferenceModel<double> InferenceModel;
+typedef BasicInferenceModel<float> InferenceModelF;
+
+#endif // _INFERENCEMODEL_HPP_
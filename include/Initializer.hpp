@@ -0,0 +1,151 @@
+#ifndef _INITIALIZER_HPP_
+#define _INITIALIZER_HPP_
+
+#include <cstdint>
+#include "Matrix.hpp"
+
+using namespace std;
+
+/// Seed of the global sequence before Initializer::setSeed is called
+#define INIT_DEFAULT_SEED 0x243f6a8885a308d3ull
+
+/**
+ * @brief How the weights of a layer are drawn
+ *
+ * fanIn is the number of columns of a weight matrix (neurons of the previous layer) and
+ * fanOut the number of rows.
+ */
+enum InitScheme {
+    INIT_UNIFORM = 0,         ///< Uniform in [0, 1), the original initialization
+    INIT_XAVIER_UNIFORM = 1,  ///< Glorot, uniform in +-sqrt(6 / (fanIn + fanOut)), for tanh, softsign and sigmoid
+    INIT_XAVIER_NORMAL = 2,   ///< Glorot, normal with variance 2 / (fanIn + fanOut)
+    INIT_HE_UNIFORM = 3,      ///< He, uniform in +-sqrt(6 / fanIn), for the ReLU family
+    INIT_HE_NORMAL = 4        ///< He, normal with variance 2 / fanIn
+};
+
+/**
+ * @class Philox
+ * @brief Philox4x32-10 counter-based random number generator
+ *
+ * Maps a 128-bit counter to 128 random bits under a 64-bit key, with no state between
+ * calls: block n of a stream can be computed without computing blocks 0 to n-1. That
+ * lets any thread generate any part of a matrix and still produce the same values.
+ */
+class Philox {
+public:
+    /**
+     * @brief Constructor for Philox
+     * @param key Key, i.e. the seed
+     */
+    Philox(uint64_t key) : key(key) {}
+
+    /**
+     * @brief Generates one block of random bits
+     * @param stream Independent sequence, e.g. the index of a matrix
+     * @param counter Block index within the stream
+     * @param out Receives four random 32-bit words
+     */
+    void block(uint64_t stream, uint64_t counter, uint32_t out[4]) const;
+
+    /**
+     * @brief Maps a random word to a uniform value in (0, 1)
+     * @param x Random word
+     * @return (x + 0.5) / 2^32, never exactly 0 or 1
+     */
+    static double unit(uint32_t x) { return (x + 0.5) * (1.0 / 4294967296.0); }
+
+private:
+    uint64_t key;   ///< Key
+};
+
+/**
+ * @class SplitMix64
+ * @brief splitmix64 sequential generator, for shuffles and sampling whose state is one word
+ *
+ * Unlike Philox each value depends on the previous one, which is all a shuffle needs, and
+ * the caller keeps the state (e.g. a seeded uint64_t member) so it is saved and restored
+ * with the object it belongs to.
+ */
+class SplitMix64 {
+public:
+    /**
+     * @brief Advances a splitmix64 generator
+     * @param state Generator state
+     * @return Next 64 random bits
+     */
+    static uint64_t next(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+};
+
+/**
+ * @class Initializer
+ * @brief Seeded, parallel weight initialization
+ *
+ * Element i (row-major, ignoring the stride) of a matrix is generated from block i / 4
+ * of the Philox stream given by seed and stream (normal values take the cosine or sine of
+ * the Box-Muller pair i / 2), so a seed reproduces the same values whatever the thread
+ * count and whichever thread fills which rows. Rows are filled in parallel on the global
+ * ThreadPool.
+ *
+ * Matrices constructed with isRandom draw their seed from a global sequence started by
+ * setSeed, so a program that sets the seed initializes identically on every run.
+ */
+class Initializer {
+public:
+    /**
+     * @brief Fills a matrix with uniform values
+     * @param m Matrix to fill
+     * @param low Lower bound
+     * @param high Upper bound (exclusive)
+     * @param seed Seed
+     * @param stream Independent sequence under the seed
+     */
+    template <typename T>
+    static void uniform(BasicMatrix<T>& m, double low, double high, uint64_t seed, uint64_t stream);
+
+    /**
+     * @brief Fills a matrix with normally distributed values (Box-Muller)
+     * @param m Matrix to fill
+     * @param mean Mean
+     * @param stddev Standard deviation
+     * @param seed Seed
+     * @param stream Independent sequence under the seed
+     */
+    template <typename T>
+    static void normal(BasicMatrix<T>& m, double mean, double stddev, uint64_t seed, uint64_t stream);
+
+    /**
+     * @brief Fills a weight matrix with a scheme
+     * @param weights fanOut x fanIn weight matrix
+     * @param scheme Initialization scheme
+     * @param seed Seed
+     * @param stream Independent sequence under the seed, e.g. the layer index
+     */
+    template <typename T>
+    static void initialize(BasicMatrix<T>& weights, InitScheme scheme, uint64_t seed, uint64_t stream);
+
+    /**
+     * @brief Restarts the global seed sequence
+     * @param seed Seed of the sequence
+     */
+    static void setSeed(uint64_t seed);
+
+    /**
+     * @brief Draws the next seed of the global sequence, thread-safe
+     * @return Seed
+     */
+    static uint64_t nextSeed();
+
+    /**
+     * @brief Gets the printable name of a scheme
+     * @param scheme Initialization scheme
+     * @return Name such as "he_normal"
+     */
+    static const char* getName(InitScheme scheme);
+};
+
+#endif // _INITIALIZER_HPP_
@@ -0,0 +1,167 @@
+#ifndef _KERNELS_HPP_
+#define _KERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include "Activation.hpp"
+#include "Optimizer.hpp"
+
+/**
+ * @brief Instruction set levels an element-wise kernel table can be built for
+ */
+enum KernelIsa {
+    ISA_SCALAR,  ///< Portable C++ loops
+    ISA_SSE2,    ///< 128-bit SSE2
+    ISA_AVX2,    ///< 256-bit AVX2 with FMA
+    ISA_AVX512   ///< 512-bit AVX-512F
+};
+
+/// Forces inlining of the tiny SIMD wrappers even in unoptimized builds
+#if defined(_MSC_VER)
+#define NN_ALWAYS_INLINE __forceinline
+#else
+#define NN_ALWAYS_INLINE inline __attribute__((always_inline))
+#endif
+
+/**
+ * @struct GemmMicroKernel
+ * @brief Register-tiled inner kernel of the blocked GEMM and the tile it computes
+ *
+ * kernel adds the product of an A panel packed as depth x rows and a B sliver packed as
+ * depth x cols to the validRows x validCols corner of the tile at c (see GemmKernels).
+ */
+template <typename T>
+struct GemmMicroKernel {
+    int rows;   ///< Rows of the tile (MR)
+    int cols;   ///< Columns of the tile (NR)
+    void (*kernel)(size_t depth, const T* a, const T* b, T* c, size_t ldc, int validRows, int validCols);
+    /// Register-only loop of rows x cols independent multiply-adds, 2 * rows * cols flops per iteration
+    void (*fmaLoop)(size_t iterations, T* sink);
+};
+
+/**
+ * @struct KernelOps
+ * @brief Element-wise kernels for one element type
+ *
+ * All kernels operate on n contiguous values and accept unaligned pointers. The output
+ * may alias any input.
+ */
+template <typename T>
+struct KernelOps {
+    /// out = a + b
+    void (*add)(const T* a, const T* b, T* out, size_t n);
+    /// out = a - b
+    void (*sub)(const T* a, const T* b, T* out, size_t n);
+    /// out = a * b (Hadamard product)
+    void (*mul)(const T* a, const T* b, T* out, size_t n);
+    /// y = y + alpha * x
+    void (*axpy)(T alpha, const T* x, T* y, size_t n);
+    /// x = alpha * x
+    void (*scale)(T alpha, T* x, size_t n);
+    /// out = a - scalar * b, the fused gradient descent update
+    void (*subScaled)(const T* a, const T* b, T scalar, T* out, size_t n);
+    /// activated = f(x) and, unless derived is null, derived = f'(x) (see Activation::apply)
+    void (*activate)(ActivationType type, const T* x, T* activated, T* derived, size_t n);
+    /// One fused optimizer update of w from gradient g and state m, v (see BasicOptimizer)
+    void (*optimize)(const OptimizerStep<T>& step, T* w, const T* g, T* m, T* v, size_t n);
+    /// Micro-kernel of the blocked GEMM, with a tile sized for the register file
+    GemmMicroKernel<T> gemm;
+};
+
+/**
+ * @struct KernelTable
+ * @brief Element-wise kernels for one instruction set
+ */
+struct KernelTable {
+    KernelIsa isa;           ///< Instruction set the kernels were compiled for
+    const char* name;        ///< Printable name of the instruction set
+    KernelOps<double> f64;   ///< Double precision kernels
+    KernelOps<float> f32;    ///< Single precision kernels
+
+    /// y[r] = sum_c a[r * stride + c] * x[c] for r < rows, int8 inputs with int32 accumulation
+    void (*gemvInt8)(const int8_t* a, const int8_t* x, int32_t* y, size_t rows, size_t cols, size_t stride);
+};
+
+/**
+ * @class Kernels
+ * @brief Runtime dispatch of element-wise kernels to the best instruction set of the host
+ *
+ * The CPU is probed with cpuid (and xgetbv for OS support of the wide registers) the first
+ * time a kernel is requested. One binary therefore runs the AVX-512 path on hosts that have
+ * it and falls back to AVX2, SSE2 or scalar loops elsewhere.
+ */
+class Kernels {
+public:
+    /**
+     * @brief Gets the kernel table selected for this host
+     * @return Active kernel table
+     */
+    static const KernelTable& get() { return *Kernels::active(); }
+
+    /**
+     * @brief Gets the kernels for one element type from the active table
+     * @return Active kernels for T (double or float)
+     */
+    template <typename T>
+    static const KernelOps<T>& ops();
+
+    /**
+     * @brief Gets the best instruction set supported by this host and binary
+     * @return Detected instruction set
+     */
+    static KernelIsa detect();
+
+    /**
+     * @brief Checks whether an instruction set can be used on this host
+     * @param isa Instruction set to check
+     * @return True if the kernels for isa are compiled in and the CPU supports them
+     */
+    static bool isSupported(KernelIsa isa);
+
+    /**
+     * @brief Forces a specific instruction set, e.g. to compare kernels
+     * @param isa Instruction set to use; ignored (returns false) if unsupported
+     * @return True if the instruction set was selected
+     */
+    static bool setIsa(KernelIsa isa);
+
+    /**
+     * @brief Gets the instruction set currently in use
+     * @return Active instruction set
+     */
+    static KernelIsa getIsa() { return Kernels::active()->isa; }
+
+    /**
+     * @brief Gets the printable name of the instruction set currently in use
+     * @return Name such as "avx2"
+     */
+    static const char* getIsaName() { return Kernels::active()->name; }
+
+private:
+    /**
+     * @brief Gets the kernel table for an instruction set
+     * @param isa Instruction set
+     * @return Table, or nullptr if not compiled into this binary
+     */
+    static const KernelTable* table(KernelIsa isa);
+
+    /**
+     * @brief Gets the active table, detecting the host on first use
+     * @return Active kernel table
+     */
+    static const KernelTable*& active();
+};
+
+template <>
+inline const KernelOps<double>& Kernels::ops<double>() { return Kernels::get().f64; }
+
+template <>
+inline const KernelOps<float>& Kernels::ops<float>() { return Kernels::get().f32; }
+
+// Per instruction set tables, each defined in its own translation unit compiled with
+// the matching target flags. Only referenced when NN_X86_KERNELS is defined.
+const KernelTable* getSse2KernelTable();
+const KernelTable* getAvx2KernelTable();
+const KernelTable* getAvx512KernelTable();
+
+#endif // _KERNELS_HPP_
@@ -3,72 +3,136 @@
 
 #include <iostream>
 #include <vector>
-#include "Neuron.hpp"
+#include "Activation.hpp"
 #include "Matrix.hpp"
 
 using namespace std;
 
 /**
- * @class Layer
+ * @class BasicLayer
  * @brief Represents a layer of neurons in a neural network
- * 
- * This class manages a collection of neurons that form a layer in the neural network.
- * It provides methods to access neuron values and convert them to matrix format for calculations.
+ * @tparam T Element type of the neuron values, double (Layer) or float
+ *
+ * This class manages the state of the neurons that form a layer in the neural network.
+ * The raw, activated and derived values are kept as three contiguous size x 1 matrices
+ * (structure of arrays) that the matrix code reads and writes directly. Each layer has
+ * its own activation function.
  */
-class Layer {
-public:	
+template <typename T>
+class BasicLayer {
+public:
     /**
      * @brief Constructor for Layer
      * @param size Number of neurons in the layer
+     * @param activation Activation function of the neurons
      */
-    Layer(int size); 
-    
+    BasicLayer(int size, ActivationType activation = ACTIVATION_SOFTSIGN);
+
     /**
      * @brief Sets the value of a specific neuron in the layer
      * @param index Index of the neuron
      * @param value New value for the neuron
      */
-    void setNeuronVal(int index, double value); 
-    
+    void setNeuronVal(int index, double value);
+
     /**
      * @brief Gets the raw value of a specific neuron
      * @param index Index of the neuron
      * @return Raw value of the neuron
      */
-    double getNeuronVal(int index) const { return this->neurons.at(index)->getVal(); }
-    
+    double getNeuronVal(int index) const { return this->vals.getVal(index, 0); }
+
+    /**
+     * @brief Gets the activated value of a specific neuron
+     * @param index Index of the neuron
+     * @return Activated value of the neuron
+     */
+    double getNeuronActivatedVal(int index) const { return this->activatedVals.getVal(index, 0); }
+
+    /**
+     * @brief Gets the derived value of a specific neuron
+     * @param index Index of the neuron
+     * @return Derivative of the activation at the neuron's value
+     */
+    double getNeuronDerivedVal(int index) const { return this->derivedVals.getVal(index, 0); }
+
+    /**
+     * @brief Gets the number of neurons in the layer
+     * @return Layer size
+     */
+    int getSize() const { return this->size; }
+
     /**
-     * @brief Gets all neurons in the layer
-     * @return Vector of pointers to neurons
+     * @brief Gets the activation function of the layer
+     * @return Activation applied to the raw values
      */
-    vector<Neuron*> getNeurons();
-    
+    ActivationType getActivation() const { return this->activation; }
+
+    /**
+     * @brief Changes the activation function and recomputes the activated values
+     * @param activation New activation function
+     */
+    void setActivation(ActivationType activation);
+
+    /**
+     * @brief Gets the raw values of all neurons
+     * @return size x 1 matrix owned by the layer
+     */
+    BasicMatrix<T>& getVals() { return this->vals; }
+
+    /**
+     * @brief Gets the activated values of all neurons
+     * @return size x 1 matrix owned by the layer
+     */
+    BasicMatrix<T>& getActivatedVals() { return this->activatedVals; }
+
+    /**
+     * @brief Gets the derived values of all neurons
+     * @return size x 1 matrix owned by the layer
+     */
+    BasicMatrix<T>& getDerivedVals() { return this->derivedVals; }
+
+    /**
+     * @brief Recomputes activated and derived values from the raw values in one pass
+     */
+    void activate();
+
     /**
      * @brief Converts raw neuron values to a matrix
      * @return Matrix containing raw neuron values
      */
-    Matrix* matrixifyVals();
-    
+    BasicMatrix<T>* matrixifyVals();
+
     /**
      * @brief Converts activated neuron values to a matrix
      * @return Matrix containing activated neuron values
      */
-    Matrix* matrixifyActivatedVals();
-    
+    BasicMatrix<T>* matrixifyActivatedVals();
+
     /**
      * @brief Converts derived neuron values to a matrix
      * @return Matrix containing derived neuron values
      */
-    Matrix* matrixifyDerivedVals();
-    
+    BasicMatrix<T>* matrixifyDerivedVals();
+
     /**
-     * @brief Cleans up memory by deleting all neurons
+     * @brief Applies an activation function and its derivative element-wise
+     * @param type Activation function
+     * @param vals Raw values
+     * @param activated Receives the activated values (same shape as vals)
+     * @param derived Receives the derivatives (same shape as vals)
      */
-    void cleanup();
-    
+    static void activateValues(ActivationType type, const BasicMatrix<T>& vals, BasicMatrix<T>& activated, BasicMatrix<T>& derived);
+
 private:
-    int size;                  ///< Number of neurons in the layer
-    vector<Neuron*> neurons; ///< Collection of neurons in the layer
+    int size;                     ///< Number of neurons in the layer
+    ActivationType activation;    ///< Activation function of the neurons
+    BasicMatrix<T> vals;          ///< Raw neuron values
+    BasicMatrix<T> activatedVals; ///< Neuron values after the activation function
+    BasicMatrix<T> derivedVals;   ///< Derivative of the activation at each neuron
 };
 
+/// Double precision layer
+typedef BasicLayer<double> Layer;
+
 #endif // _LAYER_HPP_
@@ -0,0 +1,202 @@
+#ifndef _MAPPEDDATASET_HPP_
+#define _MAPPEDDATASET_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Matrix.hpp"
+#include "ModelFile.hpp"
+
+using namespace std;
+
+#define MAPPED_DATASET_MAGIC "NNFSCOL"
+#define MAPPED_DATASET_VERSION 1
+
+/**
+ * @struct MappedDatasetHeader
+ * @brief First 64 bytes of a columnar dataset file
+ *
+ * The header is followed by two blocks of values of the header's dtype: numInputs rows
+ * of stride values starting at inputsOffset, then numTargets rows of stride values at
+ * targetsOffset. Row i holds value i of every sample in sample order, so samples are
+ * columns, as in the network's batch buffers. stride is numSamples rounded up to
+ * MODEL_FILE_ALIGNMENT bytes, so every row starts on an aligned boundary.
+ */
+struct MappedDatasetHeader {
+    char magic[8];           ///< MAPPED_DATASET_MAGIC, zero terminated
+    uint32_t version;        ///< MAPPED_DATASET_VERSION
+    uint32_t byteOrder;      ///< MODEL_FILE_BYTE_ORDER in the byte order of the writer
+    uint32_t dtype;          ///< ModelDtype of every value
+    uint32_t numInputs;      ///< Input values per sample
+    uint32_t numTargets;     ///< Target values per sample
+    uint32_t reserved;       ///< Zero
+    uint64_t numSamples;     ///< Number of samples
+    uint64_t stride;         ///< Values between the starts of consecutive rows
+    uint64_t inputsOffset;   ///< Offset of the input block
+    uint64_t targetsOffset;  ///< Offset of the target block, right after the input block
+};
+
+/**
+ * @class BasicMappedDataset
+ * @brief Training samples served as matrix views over a memory-mapped columnar file
+ *
+ * The file is mapped copy-on-write and never parsed: a run of consecutive samples is a
+ * numInputs x count view (and a numTargets x count view) straight into the mapping,
+ * which computeGradients and trainBatch take without copying. Pages are read by the
+ * first batch that touches them and stay in the page cache across epochs.
+ *
+ * Epochs are ordered through an index array of batch starts rather than by moving data.
+ * With shuffling the order is a fresh random permutation every epoch and the batch
+ * boundaries move by a random offset, so batches are also made of different samples;
+ * the samples before the offset and after the last full batch sit that epoch out.
+ * A file of the other dtype is converted into memory once on open.
+ */
+template <typename T>
+class BasicMappedDataset {
+public:
+    /**
+     * @brief Maps and validates a columnar dataset file
+     * @param path Path written by convert
+     */
+    BasicMappedDataset(const string& path);
+
+    /**
+     * @brief Destructor, unmaps the file
+     */
+    ~BasicMappedDataset();
+
+    /**
+     * @brief Checks whether a file starts with the columnar dataset magic
+     * @param path Path to check
+     * @return True for columnar dataset files
+     */
+    static bool isColumnar(const string& path);
+
+    /**
+     * @brief Converts a CSV or binary row file into a columnar dataset file
+     *
+     * The source is streamed twice with DatasetLoader, once to count the samples and
+     * once to write them, so memory use does not depend on the size of the file.
+     * @param sourcePath CSV or binary row file (see DatasetLoader)
+     * @param path Columnar file to write
+     * @param numInputs Input values per sample
+     * @param numTargets Target values per sample
+     * @param dtype Element type to store
+     * @param skipHeader Whether the first line of a CSV file is a header
+     * @return Number of samples written
+     */
+    static size_t convert(const string& sourcePath, const string& path, int numInputs, int numTargets,
+                          ModelDtype dtype = ModelDtypeOf<T>::value, bool skipHeader = false);
+
+    /**
+     * @brief Gets the number of samples in the file
+     * @return Number of samples
+     */
+    size_t getNumSamples() const { return this->numSamples; }
+
+    /**
+     * @brief Gets the number of input values per sample
+     * @return Input values per sample
+     */
+    int getNumInputs() const { return this->numInputs; }
+
+    /**
+     * @brief Gets the number of target values per sample
+     * @return Target values per sample
+     */
+    int getNumTargets() const { return this->numTargets; }
+
+    /**
+     * @brief Checks whether views point into the mapping rather than a converted copy
+     * @return True if the file's dtype is T
+     */
+    bool isZeroCopy() const { return this->converted == nullptr; }
+
+    /**
+     * @brief Creates a view of the inputs of consecutive samples
+     * @param first First sample
+     * @param count Number of samples
+     * @return numInputs x count view
+     */
+    BasicMatrix<T> inputs(size_t first, int count);
+
+    /**
+     * @brief Creates a view of the targets of consecutive samples
+     * @param first First sample
+     * @param count Number of samples
+     * @return numTargets x count view
+     */
+    BasicMatrix<T> targets(size_t first, int count);
+
+    /**
+     * @brief Lays out the batches of the next epoch
+     *
+     * Without shuffling the batches cover the file in order and the last one may be
+     * short. With shuffling every batch is full (see the class description).
+     * @param batchSize Samples per batch
+     * @param shuffle Whether to permute the batches
+     * @return Number of batches in the epoch
+     */
+    int beginEpoch(int batchSize, bool shuffle);
+
+    /**
+     * @brief Seeds the generator beginEpoch shuffles with
+     * @param seed Seed
+     */
+    void setSeed(uint64_t seed) { this->rng = seed; }
+
+    /**
+     * @brief Gets the number of batches laid out by beginEpoch
+     * @return Number of batches
+     */
+    int getNumBatches() const { return this->order.size(); }
+
+    /**
+     * @brief Gets the number of samples in a batch of the epoch
+     * @param index Batch index
+     * @return Samples in the batch
+     */
+    int getBatchSize(int index) const;
+
+    /**
+     * @brief Creates a view of the inputs of a batch of the epoch
+     * @param index Batch index
+     * @return numInputs x batch size view
+     */
+    BasicMatrix<T> batchInputs(int index) { return this->inputs(this->order.at(index), this->getBatchSize(index)); }
+
+    /**
+     * @brief Creates a view of the targets of a batch of the epoch
+     * @param index Batch index
+     * @return numTargets x batch size view
+     */
+    BasicMatrix<T> batchTargets(int index) { return this->targets(this->order.at(index), this->getBatchSize(index)); }
+
+private:
+    /**
+     * @brief Gets the header at the start of the mapping
+     */
+    const MappedDatasetHeader* header() const { return reinterpret_cast<const MappedDatasetHeader*>(this->base); }
+
+    /**
+     * @brief Validates the header and locates the blocks
+     */
+    void validate(const string& path);
+
+    unsigned char* base;        ///< Start of the mapping
+    size_t size;                ///< Size of the mapping in bytes
+    T* converted;               ///< Values converted from the other dtype, or null
+    T* data;                    ///< First value of the input block
+    size_t numSamples;          ///< Number of samples
+    size_t stride;              ///< Values between the starts of consecutive rows
+    int numInputs;              ///< Input values per sample
+    int numTargets;             ///< Target values per sample
+    vector<size_t> order;       ///< First sample of every batch of the epoch, in batch order
+    int batchSize;              ///< Samples per batch of the epoch
+    uint64_t rng;               ///< State of the shuffle generator
+};
+
+typedef BasicMappedDataset<double> MappedDataset;
+typedef BasicMappedDataset<float> MappedDatasetF;
+
+#endif // _MAPPEDDATASET_HPP_
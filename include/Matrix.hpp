@@ -1,119 +1,346 @@
-
 #ifndef _MATRIX_HPP_
 #define _MATRIX_HPP_
 
 #include <iostream>
 #include <vector>
+#include <cstddef>
+#include <stdexcept>
 #include "Neuron.hpp"
 
+/// Alignment in bytes of every buffer owned by a Matrix (one cache line)
+#define MATRIX_ALIGNMENT 64
+
 /**
- * @class Matrix
+ * @class BasicMatrix
  * @brief Represents a matrix for neural network calculations
- * 
+ * @tparam T Element type, double (Matrix) or float (MatrixF)
+ *
  * This class provides matrix operations needed for neural network computations,
  * including matrix multiplication, addition, subtraction, and element-wise operations.
+ *
+ * Values are stored row-major in a single aligned buffer. Element (row, col) lives at
+ * data[row * stride + col]. A matrix either owns its buffer (stride == numCols) or is a
+ * non-owning view into another matrix or external memory, in which case the stride may
+ * be larger than the number of columns. Copying any matrix, view or not, produces an
+ * owning deep copy; moving preserves ownership.
  */
-class Matrix {
-public:	
+template <typename T>
+class BasicMatrix {
+public:
     /**
-     * @brief Constructor for Matrix
+     * @brief Constructor for BasicMatrix
      * @param numRows Number of rows in the matrix
      * @param numCols Number of columns in the matrix
-     * @param isRandom Whether to initialize with random values
+     * @param isRandom Whether to fill with uniform values in [0, 1) (see Initializer), zeros otherwise
+     */
+    BasicMatrix(int numRows, int numCols, bool isRandom);
+
+    /**
+     * @brief Constructor for a non-owning view over existing memory
+     * @param data Pointer to the first element
+     * @param numRows Number of rows in the view
+     * @param numCols Number of columns in the view
+     * @param stride Distance in elements between the starts of consecutive rows
+     */
+    BasicMatrix(T* data, int numRows, int numCols, int stride);
+
+    /**
+     * @brief Copy constructor, always produces an owning contiguous copy
+     * @param m BasicMatrix to copy
      */
-    Matrix(int numRows, int numCols, bool isRandom);
-    
+    BasicMatrix(const BasicMatrix& m);
+
+    /**
+     * @brief Move constructor, takes over the buffer (and its ownership) of m
+     * @param m BasicMatrix to move from
+     */
+    BasicMatrix(BasicMatrix&& m);
+
+    /**
+     * @brief Copy assignment, copies values into this matrix
+     *
+     * If the shapes match the values are written in place (through the view when this is
+     * a view). An owning matrix of a different shape is reallocated.
+     * @param m BasicMatrix to copy values from
+     * @return Reference to this matrix
+     */
+    BasicMatrix& operator=(const BasicMatrix& m);
+
+    /**
+     * @brief Move assignment, takes over the buffer (and its ownership) of m
+     * @param m BasicMatrix to move from
+     * @return Reference to this matrix
+     */
+    BasicMatrix& operator=(BasicMatrix&& m);
+
+    /**
+     * @brief Destructor, releases the buffer if this matrix owns it
+     */
+    ~BasicMatrix();
+
     /**
      * @brief Creates a transposed version of this matrix
      * @return Pointer to the transposed matrix
      */
-    Matrix* transpose();
-    
+    BasicMatrix* transpose();
+
+    /**
+     * @brief Writes the transpose of this matrix into an existing matrix
+     * @param out numCols x numRows destination
+     */
+    void transposeInto(BasicMatrix& out) const;
+
+    /**
+     * @brief Matrix product with either operand transposed, without copying it
+     * @param b BasicMatrix to multiply with
+     * @param transposeThis Whether to use the transpose of this matrix
+     * @param transposeB Whether to use the transpose of b
+     * @return Pointer to op(this) * op(b)
+     */
+    BasicMatrix* multiply(BasicMatrix& b, bool transposeThis, bool transposeB);
+
     /**
      * @brief Performs element-wise multiplication with another matrix
      * @param m Pointer to the matrix to multiply with
      * @return Pointer to the resulting matrix
      */
-    Matrix* elementwiseMultiply(Matrix* m);
-    
+    BasicMatrix* elementwiseMultiply(BasicMatrix* m);
+
+    /**
+     * @brief Performs element-wise multiplication into an existing matrix
+     * @param m BasicMatrix to multiply with
+     * @param out Destination, may be this matrix or m
+     */
+    void elementwiseMultiply(BasicMatrix& m, BasicMatrix& out);
+
     /**
      * @brief Multiplies all elements by a scalar value
      * @param scalar The scalar value to multiply by
      */
     void scalarMultiply(double scalar);
-    
+
+    /**
+     * @brief Adds a scaled matrix to this matrix in place (this += alpha * x)
+     * @param alpha Scale factor applied to x
+     * @param x BasicMatrix to add
+     */
+    void axpy(double alpha, BasicMatrix& x);
+
+    /**
+     * @brief Computes this - scalar * b in a single pass
+     * @param b BasicMatrix to scale and subtract
+     * @param scalar Scale factor applied to b
+     * @return Pointer to the resulting matrix
+     */
+    BasicMatrix* subtractScaled(BasicMatrix& b, double scalar);
+
+    /**
+     * @brief Computes this - scalar * b into an existing matrix
+     * @param b BasicMatrix to scale and subtract
+     * @param scalar Scale factor applied to b
+     * @param out Destination, may be this matrix for an in-place update
+     */
+    void subtractScaled(BasicMatrix& b, double scalar, BasicMatrix& out);
+
+    /**
+     * @brief Adds a column vector to every column of this matrix in place
+     * @param column numRows x 1 matrix to add
+     */
+    void broadcastAddColumn(BasicMatrix& column);
+
+    /**
+     * @brief Copies the values of a same-shaped matrix of any element type into this one
+     * @param m Matrix to convert from
+     */
+    template <typename U>
+    void convertFrom(const BasicMatrix<U>& m);
+
     /**
      * @brief Converts the matrix to a vector
      * @return Vector containing all matrix elements
      */
-    std::vector<double> toVector();
-    
+    std::vector<T> toVector();
+
     /**
      * @brief Prints the matrix to the console
      */
     void printToConsole();
-    
+
     /**
      * @brief Sets a value at a specific position in the matrix
      * @param row Row index
      * @param col Column index
      * @param val Value to set
+     * @throws std::out_of_range if the position is outside the matrix
      */
-    void setVal(int row, int col, double val) { this->values.at(row).at(col) = val; }
-    
-    /**
-     * @brief Generates a random number for matrix initialization
-     * @return Random double value
-     */
-    double getRandNo();
-    
+    void setVal(int row, int col, T val) { this->checkBounds(row, col); this->at(row, col) = val; }
+
     /**
      * @brief Gets a value at a specific position in the matrix
      * @param row Row index
      * @param col Column index
      * @return Value at the specified position
+     * @throws std::out_of_range if the position is outside the matrix
+     */
+    T getVal(int row, int col) const { this->checkBounds(row, col); return this->at(row, col); }
+
+    /**
+     * @brief Unchecked element access for inner loops
+     * @param row Row index
+     * @param col Column index
+     * @return Reference to the element
+     */
+    T& at(int row, int col) { return this->data[(size_t)row * this->stride + col]; }
+
+    /**
+     * @brief Unchecked element access for inner loops
+     * @param row Row index
+     * @param col Column index
+     * @return Value of the element
      */
-    double getVal(int row, int col) const { return this->values.at(row).at(col); }
-    
+    T at(int row, int col) const { return this->data[(size_t)row * this->stride + col]; }
+
+    /**
+     * @brief Gets a pointer to the first element of a row
+     * @param row Row index (unchecked)
+     * @return Pointer to the row
+     */
+    T* rowPtr(int row) { return this->data + (size_t)row * this->stride; }
+
+    /**
+     * @brief Gets a pointer to the first element of a row
+     * @param row Row index (unchecked)
+     * @return Pointer to the row
+     */
+    const T* rowPtr(int row) const { return this->data + (size_t)row * this->stride; }
+
+    /**
+     * @brief Gets the underlying buffer
+     * @return Pointer to element (0, 0)
+     */
+    T* getData() { return this->data; }
+
+    /**
+     * @brief Gets the underlying buffer
+     * @return Pointer to element (0, 0)
+     */
+    const T* getData() const { return this->data; }
+
+    /**
+     * @brief Gets the row stride
+     * @return Distance in elements between the starts of consecutive rows
+     */
+    int getStride() const { return this->stride; }
+
+    /**
+     * @brief Checks whether rows are packed back to back with no gaps
+     * @return True when all numRows * numCols elements are contiguous
+     */
+    bool isContiguous() const { return this->stride == this->numCols || this->numRows <= 1; }
+
+    /**
+     * @brief Checks whether this matrix owns its buffer
+     * @return False for views
+     */
+    bool ownsData() const { return this->owner; }
+
+    /**
+     * @brief Creates a non-owning view of a single row
+     * @param index Row index
+     * @return 1 x numCols view sharing this matrix's memory
+     */
+    BasicMatrix row(int index);
+
+    /**
+     * @brief Creates a non-owning view of a single column
+     * @param index Column index
+     * @return numRows x 1 view sharing this matrix's memory
+     */
+    BasicMatrix col(int index);
+
+    /**
+     * @brief Creates a non-owning view of a rectangular sub-block
+     * @param row Index of the first row of the block
+     * @param col Index of the first column of the block
+     * @param numRows Number of rows in the block
+     * @param numCols Number of columns in the block
+     * @return View sharing this matrix's memory
+     */
+    BasicMatrix block(int row, int col, int numRows, int numCols);
+
     /**
      * @brief Gets the number of rows in the matrix
      * @return Number of rows
      */
     int getNumRows() const { return this->numRows; }
-    
+
     /**
      * @brief Gets the number of columns in the matrix
      * @return Number of columns
      */
     int getNumCols() const { return this->numCols; }
 
+    /**
+     * @brief Allocates a zero-initialized buffer aligned to MATRIX_ALIGNMENT
+     * @param bytes Size of the buffer in bytes
+     * @return Pointer to the buffer, to be released with alignedFree
+     */
+    static void* alignedAlloc(size_t bytes);
+
+    /**
+     * @brief Releases a buffer obtained from alignedAlloc
+     * @param ptr Pointer returned by alignedAlloc (may be null)
+     */
+    static void alignedFree(void* ptr);
+
     // Operator overloading
     /**
-     * @brief Matrix multiplication operator
-     * @param b Matrix to multiply with
+     * @brief BasicMatrix multiplication operator
+     * @param b BasicMatrix to multiply with
      * @return Pointer to the resulting matrix
      */
-    Matrix* operator*(Matrix& b);
-    
+    BasicMatrix* operator*(BasicMatrix& b);
+
     /**
-     * @brief Matrix addition operator
-     * @param b Matrix to add
+     * @brief BasicMatrix addition operator
+     * @param b BasicMatrix to add
      * @return Pointer to the resulting matrix
      */
-    Matrix* operator+(Matrix& b);
-    
+    BasicMatrix* operator+(BasicMatrix& b);
+
     /**
-     * @brief Matrix subtraction operator
-     * @param b Matrix to subtract
+     * @brief BasicMatrix subtraction operator
+     * @param b BasicMatrix to subtract
      * @return Pointer to the resulting matrix
      */
-    Matrix* operator-(Matrix& b);
-    
+    BasicMatrix* operator-(BasicMatrix& b);
+
 private:
+    /**
+     * @brief Throws std::out_of_range if (row, col) lies outside the matrix
+     */
+    void checkBounds(int row, int col) const {
+        if (row < 0 || row >= this->numRows || col < 0 || col >= this->numCols) {
+            throw std::out_of_range("BasicMatrix index out of range");
+        }
+    }
+
+    /**
+     * @brief Allocates an owning contiguous buffer for the current shape
+     */
+    void allocate();
+
     int numRows;                      ///< Number of rows in the matrix
     int numCols;                      ///< Number of columns in the matrix
-    std::vector<std::vector<double>> values; ///< Matrix values
+    int stride;                       ///< Elements between the starts of consecutive rows
+    bool owner;                       ///< Whether this matrix frees data on destruction
+    T* data;                     ///< Row-major matrix values
 };
 
-#endif // _MATRIX_HPP_
+/// Double precision matrix used throughout the network
+typedef BasicMatrix<double> Matrix;
+
+/// Single precision matrix for float32 compute
+typedef BasicMatrix<float> MatrixF;
 
+#endif // _MATRIX_HPP_
@@ -0,0 +1,221 @@
+#ifndef _MODELFILE_HPP_
+#define _MODELFILE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Matrix.hpp"
+#include "Activation.hpp"
+
+using namespace std;
+
+#define MODEL_FILE_MAGIC "NNFSMDL"
+#define MODEL_FILE_VERSION 3
+#define MODEL_FILE_BYTE_ORDER 0x01020304u
+#define MODEL_FILE_ALIGNMENT 64
+#define MODEL_FILE_CHECKSUM_SEED 14695981039346656037ull
+
+/**
+ * @brief On-disk formats understood by NeuralNetwork::saveModel
+ */
+enum ModelFormat {
+    MODEL_TEXT,   ///< Legacy ';'/',' separated text
+    MODEL_BINARY  ///< Versioned binary format read by ModelFile
+};
+
+/**
+ * @brief Element types of the tensors in a binary model file
+ */
+enum ModelDtype {
+    MODEL_FLOAT64 = 0,
+    MODEL_FLOAT32 = 1
+};
+
+/**
+ * @brief Maps an element type to its ModelDtype
+ */
+template <typename T>
+struct ModelDtypeOf;
+
+template <>
+struct ModelDtypeOf<double> { static const ModelDtype value = MODEL_FLOAT64; };
+
+template <>
+struct ModelDtypeOf<float> { static const ModelDtype value = MODEL_FLOAT32; };
+
+/**
+ * @struct ModelFileHeader
+ * @brief First 64 bytes of a binary model file
+ *
+ * The header is followed by the topology (numLayers uint32 values), the ActivationType
+ * of every layer (numLayers uint32 values, since version 2) and the byte offsets of the
+ * tensors (uint64, the weight matrices then the bias vectors). Each tensor is a
+ * row-major block of rows * cols values of the header's dtype starting on a 64-byte
+ * boundary, each tensor right after the previous one. Version 1 files have no
+ * activations and load as softsign throughout.
+ *
+ * Since version 3 the checksum covers the whole file, hashed with the checksum field
+ * zeroed, so the topology and tables are protected as well as the tensors. Older files
+ * only hash the tensors; their tables are still checked against the exact layout.
+ */
+struct ModelFileHeader {
+    char magic[8];        ///< MODEL_FILE_MAGIC, zero terminated
+    uint32_t version;     ///< MODEL_FILE_VERSION, or 1 for files without activations
+    uint32_t byteOrder;   ///< MODEL_FILE_BYTE_ORDER in the byte order of the writer
+    uint32_t dtype;       ///< ModelDtype of every tensor
+    uint32_t numLayers;   ///< Number of entries in the topology
+    uint64_t dataOffset;  ///< Offset of the first tensor
+    uint64_t fileSize;    ///< Total size of the file in bytes
+    uint64_t checksum;    ///< FNV-1a hash of the file with this field zeroed (of the tensors before version 3)
+    double learningRate;  ///< Learning rate the model was trained with
+    uint64_t reserved;    ///< Zero
+};
+
+/**
+ * @class ModelFile
+ * @brief Read-only mapping of a binary model file
+ *
+ * The file is mapped copy-on-write and the weights are used in place: the matrices
+ * handed out are views into the mapping, so loading neither copies nor parses them.
+ * Writing through a view (e.g. training a loaded model) only changes this process's
+ * copy of the page, never the file. The mapping must outlive every view.
+ */
+class ModelFile {
+public:
+    /**
+     * @brief Maps and validates a binary model file
+     * @param path Path to the model file
+     * @throws std::runtime_error if the file cannot be mapped or fails validation
+     */
+    ModelFile(const string& path);
+
+    /**
+     * @brief Destructor, unmaps the file
+     */
+    ~ModelFile();
+
+    /**
+     * @brief Checks whether a file starts with the binary model magic
+     * @param path Path to the model file
+     * @return True for binary model files
+     */
+    static bool isBinary(const string& path);
+
+    /**
+     * @brief Writes a model in the binary format
+     *
+     * The file is written to path + ".tmp" and renamed over path, so a model or dataset
+     * still mapped from path keeps reading the old file instead of faulting on truncated pages.
+     * @param path Path to write to
+     * @param topology Neurons per layer
+     * @param activations Activation of each layer
+     * @param learningRate Learning rate of the model
+     * @param weights Weight matrices between layers
+     * @param biases Bias vectors of each layer
+     * @tparam T Element type, stored as the file's dtype
+     * @throws std::runtime_error if the file cannot be written or moved into place, in which
+     *         case path is left as it was and the temporary file is removed
+     */
+    template <typename T>
+    static void write(const string& path, const vector<int>& topology, const vector<ActivationType>& activations,
+                      double learningRate, const vector<BasicMatrix<T>*>& weights, const vector<BasicMatrix<T>*>& biases);
+
+    /**
+     * @brief Renames a completely written temporary file over its target
+     * @param temp Written file, removed if it cannot be moved
+     * @param path Target path
+     * @throws std::runtime_error if the rename fails
+     */
+    static void moveIntoPlace(const string& temp, const string& path);
+
+    /**
+     * @brief Gets the topology stored in the file
+     * @return Neurons per layer
+     */
+    vector<int> getTopology() const { return this->topology; }
+
+    /**
+     * @brief Gets the activations stored in the file
+     * @return Activation of each layer
+     */
+    vector<ActivationType> getActivations() const { return this->activations; }
+
+    /**
+     * @brief Gets the learning rate stored in the file
+     * @return Learning rate
+     */
+    double getLearningRate() const { return this->header()->learningRate; }
+
+    /**
+     * @brief Gets the element type of the tensors in the file
+     * @return Stored dtype
+     */
+    ModelDtype getDtype() const { return (ModelDtype)this->header()->dtype; }
+
+    /**
+     * @brief Creates a view of a weight matrix in the mapping
+     *
+     * When T differs from the file's dtype the values are converted into a new owning
+     * matrix instead.
+     * @param index Weight matrix index
+     * @return New matrix (topology[index + 1] x topology[index])
+     */
+    template <typename T>
+    BasicMatrix<T>* weightView(int index);
+
+    /**
+     * @brief Creates a view of a bias vector in the mapping
+     *
+     * When T differs from the file's dtype the values are converted into a new owning
+     * matrix instead.
+     * @param index Layer index
+     * @return New matrix (topology[index] x 1)
+     */
+    template <typename T>
+    BasicMatrix<T>* biasView(int index);
+
+    /**
+     * @brief Continues a 64-bit FNV-1a hash over a block of bytes
+     * @param hash Hash so far, MODEL_FILE_CHECKSUM_SEED for the first block
+     * @param data Bytes to hash
+     * @param size Number of bytes
+     * @return Updated hash
+     */
+    static uint64_t checksum(uint64_t hash, const unsigned char* data, size_t size);
+
+private:
+    /**
+     * @brief Gets the header at the start of the mapping
+     */
+    const ModelFileHeader* header() const { return reinterpret_cast<const ModelFileHeader*>(this->base); }
+
+    /**
+     * @brief Creates a view (or converted copy) of tensor index of the file
+     */
+    template <typename T>
+    BasicMatrix<T>* tensorView(int index, int rows, int cols);
+
+    /**
+     * @brief Gets the size in bytes of one stored element
+     */
+    size_t elementSize() const { return this->getDtype() == MODEL_FLOAT32 ? sizeof(float) : sizeof(double); }
+
+    /**
+     * @brief Validates the header, topology and tensor table and reads them
+     * @throws std::runtime_error on the first check that fails
+     */
+    void validate(const string& path);
+
+    /**
+     * @brief Releases the mapping
+     */
+    void unmap();
+
+    unsigned char* base;       ///< Start of the mapping
+    size_t size;               ///< Size of the mapping in bytes
+    vector<int> topology;                ///< Neurons per layer
+    vector<ActivationType> activations;  ///< Activation of each layer
+    vector<uint64_t> offsets;            ///< Byte offsets of the tensors
+};
+
+#endif // _MODELFILE_HPP_
@@ -6,35 +6,70 @@
 #include <string>
 #include "Matrix.hpp"
 #include "Layer.hpp"
+#include "ModelFile.hpp"
+#include "Optimizer.hpp"
+#include "Initializer.hpp"
+#include "TextModelReader.hpp"
 
 using namespace std;
 
 /**
- * @class NeuralNetwork
+ * @struct LayerWorkspace
+ * @brief Buffers for one layer of a training step, sized once and reused every step
+ *
+ * Every buffer has one column per sample. Gradients are not part of the workspace,
+ * they accumulate in the network's gradient buffers.
+ */
+template <typename T>
+struct LayerWorkspace {
+    BasicMatrix<T>* vals;          ///< Raw values
+    BasicMatrix<T>* activated;     ///< Activated values
+    BasicMatrix<T>* derived;       ///< Derivatives of the activated values
+    BasicMatrix<T>* delta;         ///< Error signal of the layer
+};
+
+/**
+ * @class BasicNeuralNetwork
  * @brief Represents a fully connected neural network
  * 
  * This class implements a multi-layer neural network with configurable topology.
  * It supports forward propagation, backpropagation, and model saving/loading.
+ * Every layer applies its own activation function (softsign unless changed with
+ * setActivation), which is saved with the model. Weights and biases are updated by an
+ * Optimizer (plain SGD unless changed with setOptimizer) whose state is kept with the
+ * network but not saved.
+ * Weights, activations and gradients are stored as T (double or float); inputs,
+ * targets and errors are always exchanged as double.
  */
-class NeuralNetwork {
+template <typename T>
+class BasicNeuralNetwork {
 public:	
     /**
      * @brief Constructor for creating a new neural network
+     *
+     * Biases start at zero and weights are drawn with initializeWeights.
      * @param topology Vector of integers representing the number of neurons in each layer
      * @param learningRate Learning rate for training
+     * @param init Weight initialization scheme
+     * @param seed Seed of the weights, 0 to take the next seed of Initializer's global sequence
      */
-    NeuralNetwork(vector<int> topology, double learningRate);
+    BasicNeuralNetwork(vector<int> topology, double learningRate, InitScheme init = INIT_UNIFORM, uint64_t seed = 0);
     
     /**
      * @brief Constructor for loading a neural network from a file
+     *
+     * Binary model files are memory-mapped and their weights used in place (see
+     * ModelFile); anything else is read as the legacy text format. A binary file of
+     * another dtype is converted on load instead.
      * @param path Path to the saved model file
+     * @throws std::runtime_error if the file cannot be read or is malformed
      */
-    NeuralNetwork(const string& path);
+    BasicNeuralNetwork(const string& path);
     
     /**
      * @brief Destructor to clean up memory
      */
-    ~NeuralNetwork();
+    ~BasicNeuralNetwork();
     
     /**
      * @brief Prints the entire network state to the console
@@ -63,8 +98,113 @@ public:
     
     /**
      * @brief Performs backpropagation to update weights and biases
+     *
+     * Same as computeGradients followed by applyGradients, so gradients accumulated
+     * before the call are applied with this sample's. All intermediate matrices live in
+     * workspaces allocated with the network (the per-neuron values are views of the layers
+     * themselves) and the weights and biases are updated in place by the optimizer, so a
+     * feedForward/backPropogate step does not touch the heap once the error history has
+     * room (see reserveHistory).
      */
     void backPropogate();
+
+    /**
+     * @brief Backpropagates the current sample and adds its gradients to the gradient buffers
+     *
+     * Expects feedForward to have run on the current input and a target to be set. The
+     * weights are not changed, so this can be called for any number of samples before
+     * applyGradients.
+     */
+    void computeGradients();
+
+    /**
+     * @brief Runs a mini-batch forward and backward and adds its gradients to the gradient buffers
+     *
+     * The weights are not changed. getError() afterwards returns the mean per-sample
+     * error of the batch.
+     * @param inputs Input vectors, one per sample
+     * @param targets Target vectors, one per sample
+     */
+    void computeGradients(const vector<vector<double>>& inputs, const vector<vector<double>>& targets);
+
+    /**
+     * @brief Runs a mini-batch given as matrices and adds its gradients to the gradient buffers
+     *
+     * Same as the vector overload, but the samples are the columns of the matrices, which
+     * may be views (e.g. MappedDataset batches): the inputs are read in place, not copied.
+     * @param inputs Input layer size x batch size
+     * @param targets Output layer size x batch size
+     */
+    void computeGradients(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets);
+
+    /**
+     * @brief Computes the mean per-sample error of a batch without training on it
+     *
+     * Runs the batch forward only: the gradient buffers, getError() and the error
+     * history are left alone.
+     * @param inputs Input vectors, one per sample
+     * @param targets Target vectors, one per sample
+     * @return Mean per-sample error
+     */
+    double evaluate(const vector<vector<double>>& inputs, const vector<vector<double>>& targets);
+
+    /**
+     * @brief Computes the mean per-sample error of a batch given as matrices without training on it
+     * @param inputs Input layer size x batch size, may be a view
+     * @param targets Output layer size x batch size, may be a view
+     * @return Mean per-sample error
+     */
+    double evaluate(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets);
+
+    /**
+     * @brief Updates the weights and biases with the mean of the accumulated gradients
+     *
+     * Takes one optimizer step with the gradient buffers divided by the number of samples
+     * accumulated since the last apply, then clears them. Does nothing if no gradients
+     * were accumulated.
+     */
+    void applyGradients();
+
+    /**
+     * @brief Zeroes the gradient buffers and the accumulated sample count
+     */
+    void clearGradients();
+
+    /**
+     * @brief Gets the L2 norm of the mean accumulated gradient over all parameters
+     * @return Norm, 0 if nothing was accumulated
+     */
+    double getGradientNorm();
+
+    /**
+     * @brief Scales the accumulated gradients down so their mean has at most a given L2 norm
+     * @param maxNorm Largest norm of the mean gradient over all parameters
+     * @return Norm before clipping
+     */
+    double clipGradients(double maxNorm);
+
+    /**
+     * @brief Gets the number of samples whose gradients are in the gradient buffers
+     * @return Samples accumulated since the last applyGradients or clearGradients
+     */
+    int getAccumulatedSamples() const { return this->accumulatedSamples; }
+
+    /**
+     * @brief Gets the accumulated gradient of a weight matrix
+     *
+     * Sum over the accumulated samples, same shape as getWeightMatrix(index). May be
+     * modified, e.g. to all-reduce it across workers, before applyGradients.
+     * @param index Index of the weight matrix
+     * @return Gradient buffer owned by the network
+     */
+    BasicMatrix<T>* getWeightGradient(int index) { return this->weightGradients.at(index); }
+
+    /**
+     * @brief Gets the accumulated gradient of a bias matrix
+     * @param index Layer index
+     * @return Gradient buffer owned by the network, same shape as getBiasMatrix(index)
+     */
+    BasicMatrix<T>* getBiasGradient(int index) { return this->biasGradients.at(index); }
     
     /**
      * @brief Calculates error between output and target
@@ -74,50 +214,157 @@ public:
     /**
      * @brief Saves the model to a file
      * @param path Path to save the model
+     * @param format File format, binary unless the legacy text format is requested.
+     *               Binary files record the dtype of the network.
+     *
+     * Safe to call with the path the network was loaded from: the file is written aside and
+     * renamed over path, so the mapped weights stay readable.
+     * @throws std::runtime_error if the file cannot be written, leaving path unchanged
+     */
+    void saveModel(const string& path, ModelFormat format = MODEL_BINARY);
+
+    /**
+     * @brief Draws new weights and zeroes the biases, gradients and optimizer state
+     *
+     * Weight matrix i is stream i of the seed, so a seed gives the same network whatever
+     * the thread count.
+     * @param scheme Initialization scheme
+     * @param seed Seed, 0 to take the next seed of Initializer's global sequence
      */
-    void saveModel(const string& path);
+    void initializeWeights(InitScheme scheme, uint64_t seed = 0);
+
+    /**
+     * @brief Sets the activation function of a layer
+     *
+     * The input layer's activation is not used by the forward pass, which feeds it raw.
+     * @param index Layer index
+     * @param activation Activation function
+     */
+    void setActivation(int index, ActivationType activation) { this->layers.at(index)->setActivation(activation); }
+
+    /**
+     * @brief Sets the activation function of every layer
+     * @param activations One activation per layer
+     */
+    void setActivations(const vector<ActivationType>& activations);
+
+    /**
+     * @brief Gets the activation function of a layer
+     * @param index Layer index
+     * @return Activation function
+     */
+    ActivationType getActivation(int index) const { return this->layers.at(index)->getActivation(); }
+
+    /**
+     * @brief Gets the activation function of every layer
+     * @return One activation per layer
+     */
+    vector<ActivationType> getActivations() const;
+
+    /**
+     * @brief Sets the update rule used by backPropogate and trainBatch
+     *
+     * Allocates the rule's state (velocities or moments) next to every parameter and
+     * resets it; the learning rate stays getLearningRate().
+     * @param config Update rule and hyperparameters
+     */
+    void setOptimizer(const OptimizerConfig& config);
+
+    /**
+     * @brief Gets the update rule used by backPropogate and trainBatch
+     * @return Update rule and hyperparameters
+     */
+    OptimizerConfig getOptimizerConfig() const { return this->optimizer.getConfig(); }
+
+    /**
+     * @brief Keeps a double precision master copy of the weights and biases
+     *
+     * Gradients are still computed in T, but each update is applied to the master copy
+     * and rounded back into the working weights, so small steps are not lost to float
+     * rounding. Toggling it resets the optimizer state. Has no effect for double networks.
+     * @param enabled Whether to keep master weights
+     */
+    void setMasterWeights(bool enabled);
+
+    /**
+     * @brief Gets the element type of the network
+     * @return Dtype the weights are stored and saved as
+     */
+    ModelDtype getDtype() const { return ModelDtypeOf<T>::value; }
 
     /**
      * @brief Gets the matrix of raw neuron values for a layer
      * @param index Layer index
      * @return Matrix of neuron values
      */
-    Matrix* getNeuronMatrix(int index) { return this->layers.at(index)->matrixifyVals(); }
+    BasicMatrix<T>* getNeuronMatrix(int index) { return this->layers.at(index)->matrixifyVals(); }
     
     /**
      * @brief Gets the matrix of activated neuron values for a layer
      * @param index Layer index
      * @return Matrix of activated neuron values
      */
-    Matrix* getActivatedNeuronMatrix(int index) { return this->layers.at(index)->matrixifyActivatedVals(); }
+    BasicMatrix<T>* getActivatedNeuronMatrix(int index) { return this->layers.at(index)->matrixifyActivatedVals(); }
     
     /**
      * @brief Gets the matrix of derived neuron values for a layer
      * @param index Layer index
      * @return Matrix of derived neuron values
      */
-    Matrix* getDerivedNeuronMatrix(int index) { return this->layers.at(index)->matrixifyDerivedVals(); }
+    BasicMatrix<T>* getDerivedNeuronMatrix(int index) { return this->layers.at(index)->matrixifyDerivedVals(); }
     
     /**
      * @brief Gets the weight matrix between two layers
      * @param index Index of the weight matrix
      * @return Weight matrix
      */
-    Matrix* getWeightMatrix(int index) { return this->weightMatrices.at(index); }
+    BasicMatrix<T>* getWeightMatrix(int index) { return this->weightMatrices.at(index); }
     
     /**
      * @brief Gets the bias matrix for a layer
      * @param index Layer index
      * @return Bias matrix
      */
-    Matrix* getBiasMatrix(int index) { return this->biasMatrices.at(index); }
+    BasicMatrix<T>* getBiasMatrix(int index) { return this->biasMatrices.at(index); }
 
     /**
      * @brief Makes a prediction using the neural network
+     *
+     * Runs the training pass and overwrites the network's neuron values. For concurrent
+     * or allocation-free inference use BasicInferenceModel.
      * @param input Input vector
      * @return Matrix containing the output prediction
      */
-    Matrix* predict(vector<double> input);
+    BasicMatrix<T>* predict(vector<double> input);
+
+    /**
+     * @brief Trains on a mini-batch in one forward/backward pass
+     *
+     * The samples are stacked as the columns of one matrix per layer, so every layer is a
+     * single matrix-matrix product. Same as computeGradients(inputs, targets) followed by
+     * applyGradients: gradients are averaged over the batch (and anything accumulated
+     * before) and the weights are updated once. getError() afterwards returns the mean
+     * per-sample error.
+     * @param inputs Input vectors, one per sample
+     * @param targets Target vectors, one per sample
+     */
+    void trainBatch(const vector<vector<double>>& inputs, const vector<vector<double>>& targets);
+
+    /**
+     * @brief Trains on a mini-batch given as matrices, one sample per column
+     *
+     * Same as computeGradients(inputs, targets) with matrices followed by applyGradients.
+     * @param inputs Input layer size x batch size, may be a view
+     * @param targets Output layer size x batch size, may be a view
+     */
+    void trainBatch(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets);
+
+    /**
+     * @brief Makes predictions for a batch of inputs in one forward pass
+     * @param inputs Input vectors, one per sample
+     * @return Matrix with one column of output values per sample (caller deletes)
+     */
+    BasicMatrix<T>* predictBatch(const vector<vector<double>>& inputs);
 
     /**
      * @brief Sets the value of a specific neuron
@@ -146,14 +393,14 @@ public:
      * @param index Index of the weight matrix
      * @param weightMatrix New weight matrix
      */
-    void setWeightMatrix(int index, Matrix* weightMatrix);
+    void setWeightMatrix(int index, BasicMatrix<T>* weightMatrix);
     
     /**
      * @brief Sets a bias matrix
      * @param index Index of the bias matrix
      * @param biasMatrix New bias matrix
      */
-    void setBiasMatrix(int index, Matrix* biasMatrix);
+    void setBiasMatrix(int index, BasicMatrix<T>* biasMatrix);
 
     /**
      * @brief Gets the error vector
@@ -178,18 +425,171 @@ public:
      * @return Number of layers in the network
      */
     int getTopologySize() const { return this->topologySize; }
+
+    /**
+     * @brief Gets the learning rate
+     * @return Learning rate used by backPropogate
+     */
+    double getLearningRate() const { return this->learningRate; }
+
+    /**
+     * @brief Sets the learning rate, e.g. from a schedule between steps
+     * @param learningRate Learning rate used by the next update
+     */
+    void setLearningRate(double learningRate) { this->learningRate = learningRate; }
     
     /**
      * @brief Gets the historical errors
      * @return Vector of historical error values
      */
     vector<double> getHistoricalErrors() const { return this->historicalErrors; }
+
+    /**
+     * @brief Preallocates room in the error history
+     * @param steps Number of training steps to reserve room for
+     */
+    void reserveHistory(size_t steps) { this->historicalErrors.reserve(this->historicalErrors.size() + steps); }
 private:
+    /**
+     * @brief Reads topology, weights, biases, learning rate and activations from a text model
+     * @param path Path to the saved model file
+     * @param activations Receives the activations, softsign for files written without them
+     * @throws std::runtime_error on the first malformed token, after freeing what was read
+     */
+    void loadText(const string& path, vector<ActivationType>& activations);
+
+    /**
+     * @brief Parses a text model into the topology, weight and bias members
+     * @param model Reader positioned at the start of the file
+     * @param activations Receives the activations, softsign for files written without them
+     */
+    void readText(TextModelReader& model, vector<ActivationType>& activations);
+
+    /**
+     * @brief Writes the model in the legacy text format
+     * @param path Path to save the model
+     */
+    void saveText(const string& path);
+
+    /**
+     * @brief Allocates one workspace per layer
+     * @param workspaces Vector to fill
+     * @param columns Number of samples each buffer holds
+     * @param bindLayers Make vals/activated/derived views of the layers' own arrays
+     *                   (single-sample workspaces only, columns must be 1)
+     */
+    void allocateWorkspaces(vector<LayerWorkspace<T> >& workspaces, int columns, bool bindLayers);
+
+    /**
+     * @brief Releases workspaces allocated with allocateWorkspaces
+     * @param workspaces Vector to empty
+     */
+    void freeWorkspaces(vector<LayerWorkspace<T> >& workspaces);
+
+    /**
+     * @brief Backpropagates the output delta and adds the gradients to the gradient buffers
+     *
+     * Expects vals, activated and derived of every layer and delta of the output layer
+     * to be filled in.
+     * @param workspaces Workspaces of the pass
+     * @param input Values of the input layer, one column per sample
+     * @param ones Column of ones matching the number of samples, or NULL for one sample
+     */
+    void accumulateGradients(vector<LayerWorkspace<T> >& workspaces, const BasicMatrix<T>& input, BasicMatrix<T>* ones);
+
+    /**
+     * @brief Applies the optimizer's update to a parameter, through the master copy if there is one
+     * @param index Parameter index, weights first then biases
+     * @param param Working weights or biases
+     * @param gradient Gradient of param
+     * @param gradientScale Factor applied to gradient, 1 / batch size
+     */
+    void applyUpdate(int index, BasicMatrix<T>& param, BasicMatrix<T>& gradient, double gradientScale);
+
+    /**
+     * @brief Allocates zeroed gradient buffers shaped like the weights and biases
+     */
+    void allocateGradients();
+
+    /**
+     * @brief Reallocates the optimizer state for the current parameters (or master copies)
+     */
+    void resetOptimizer();
+
+    /**
+     * @brief Copies a working parameter into its master copy, if there is one
+     * @param index Parameter index, weights first then biases
+     * @param param Working weights or biases
+     */
+    void refreshMaster(int index, BasicMatrix<T>* param);
+
+    /**
+     * @brief Sizes the batch workspaces for a given number of samples
+     *
+     * The buffers are sized for the largest batch seen so far and the workspaces are
+     * views of their leading columns, so alternating batch sizes never allocate.
+     * @param size Number of samples (columns)
+     */
+    void prepareBatch(int size);
+
+    /**
+     * @brief Copies a batch of inputs into the columns of the input layer buffer
+     * @param inputs Input vectors, one per sample
+     */
+    void setBatchInput(const vector<vector<double>>& inputs);
+
+    /**
+     * @brief Copies a batch of targets into the columns of the batch target buffer
+     * @param targets Target vectors, one per sample, as many as the batch inputs
+     */
+    void setBatchTargets(const vector<vector<double>>& targets);
+
+    /**
+     * @brief Mean per-sample error of the output of the current batch
+     * @param targets Output layer size x batch size
+     * @return Mean per-sample error
+     */
+    double batchError(const BasicMatrix<T>& targets);
+
+    /**
+     * @brief Checks the shape of a batch given as matrices and uses the inputs in place
+     * @param inputs Input layer size x batch size
+     * @param targets Output layer size x batch size
+     */
+    void setBatchInput(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets);
+
+    /**
+     * @brief Forward pass over the current batch input and buffers
+     */
+    void feedForwardBatch();
+
+    /**
+     * @brief Backward pass over the current batch buffers, accumulating the gradients
+     * @param targets Output layer size x batch size
+     */
+    void backPropogateBatch(const BasicMatrix<T>& targets);
+
+    /**
+     * @brief Releases the batch workspaces and their buffers
+     */
+    void clearBatch();
+
+    /**
+     * @brief Double precision copy of one parameter and room for its gradient
+     */
+    struct MasterParameter {
+        Matrix* value;     ///< Master weights
+        Matrix* gradient;  ///< Gradient widened to double
+    };
+
     int topologySize;                   ///< Number of layers in the network
     vector<int> topology;          ///< Vector defining neurons per layer
-    vector<Layer*> layers;         ///< Vector of layer pointers
-    vector<Matrix*> weightMatrices; ///< Weight matrices between layers
-    vector<Matrix*> biasMatrices;  ///< Bias matrices for each layer
+    vector<BasicLayer<T>*> layers;         ///< Vector of layer pointers
+    vector<BasicMatrix<T>*> weightMatrices; ///< Weight matrices between layers
+    vector<BasicMatrix<T>*> biasMatrices;  ///< Bias matrices for each layer
+    vector<BasicMatrix<T>*> weightGradients; ///< Accumulated gradient of each weight matrix
+    vector<BasicMatrix<T>*> biasGradients; ///< Accumulated gradient of each bias matrix
+    int accumulatedSamples;             ///< Samples in the gradient buffers
     vector<double> input;          ///< Current input vector
     vector<double> target;         ///< Current target vector
     vector<double> errors;         ///< Current errors vector
@@ -197,6 +597,22 @@ private:
     double error;                       ///< Current total error
     double learningRate;                ///< Learning rate for training
 
-
+    vector<LayerWorkspace<T> > workspaces;      ///< Single-sample workspaces used by feedForward/backPropogate
+    vector<LayerWorkspace<T> > batchStorage;    ///< Batch buffers, batchCapacity columns each
+    vector<LayerWorkspace<T> > batchWorkspaces; ///< Views of the leading batchSize columns of batchStorage
+    int batchSize;                          ///< Number of columns in the batch workspaces
+    int batchCapacity;                      ///< Number of columns in the batch buffers
+    BasicMatrix<T>* batchOnes;              ///< Column of ones used to sum deltas over the batch
+    BasicMatrix<T>* batchTargets;           ///< Targets of a vector batch, one column per sample
+    BasicMatrix<T>* batchOnesStorage;       ///< Buffer of batchOnes, batchCapacity ones
+    BasicMatrix<T>* batchTargetsStorage;    ///< Buffer of batchTargets, batchCapacity columns
+    const BasicMatrix<T>* batchInput;       ///< Input of the current batch, the input workspace or a caller's matrix
+    ModelFile* modelFile;                   ///< Mapping the weights live in when loaded from a binary file
+    vector<MasterParameter> masters;        ///< Master weights then biases, empty unless enabled
+    BasicOptimizer<T> optimizer;            ///< Updates the working weights and biases
+    Optimizer masterOptimizer;              ///< Updates the master copies when there are any
 };
+
+typedef BasicNeuralNetwork<double> NeuralNetwork;
+typedef BasicNeuralNetwork<float> NeuralNetworkF;
 #endif
@@ -8,7 +8,8 @@
  * @brief Represents a single neuron in a neural network
  * 
  * This class implements a neuron with activation function and its derivative.
- * It uses a fast sigmoid function for activation: f(x) = x / (1 + |x|)
+ * It uses a fast sigmoid function for activation: f(x) = x / (1 + |x|), the softsign
+ * (ACTIVATION_SOFTSIGN). Layers choose their activation per layer, see Activation.
  */
 class Neuron {
 public:	
@@ -34,10 +35,24 @@ public:
     /**
      * @brief Calculates the derivative of the activation function
      * 
-     * Derivative of Sigmoid: f'(x) = f(x) * (1 - f(x))
+     * Derivative of the fast sigmoid: f'(x) = 1 / (1 + |x|)^2 = (1 - |f(x)|)^2
      */
     void derive();
 
+    /**
+     * @brief Evaluates the activation function without a Neuron object
+     * @param val Raw value
+     * @return Activated value, identical to what activate() computes
+     */
+    static double activation(double val);
+
+    /**
+     * @brief Evaluates the activation derivative without a Neuron object
+     * @param activatedVal Value returned by activation()
+     * @return Derivative, identical to what derive() computes
+     */
+    static double derivative(double activatedVal);
+
     // Getters
     /**
      * @brief Gets the raw neuron value
@@ -0,0 +1,158 @@
+#ifndef _OPTIMIZER_HPP_
+#define _OPTIMIZER_HPP_
+
+#include <cstddef>
+#include <vector>
+#include "Matrix.hpp"
+
+using namespace std;
+
+/**
+ * @brief Update rules an Optimizer can apply
+ */
+enum OptimizerType {
+    OPTIMIZER_SGD,       ///< w -= lr * g
+    OPTIMIZER_MOMENTUM,  ///< Heavy ball: m = mu * m + g, w -= lr * m
+    OPTIMIZER_NESTEROV,  ///< Nesterov momentum: m = mu * m + g, w -= lr * (g + mu * m)
+    OPTIMIZER_ADAM,      ///< Adam, weight decay added to the gradient (L2)
+    OPTIMIZER_ADAMW      ///< Adam with decoupled weight decay
+};
+
+/**
+ * @struct OptimizerConfig
+ * @brief Update rule and its hyperparameters
+ *
+ * The learning rate is not part of the config, it stays with the network.
+ */
+struct OptimizerConfig {
+    OptimizerType type;  ///< Update rule
+    double momentum;     ///< Momentum coefficient mu (momentum and Nesterov)
+    double beta1;        ///< Decay of the first moment (Adam, AdamW)
+    double beta2;        ///< Decay of the second moment (Adam, AdamW)
+    double epsilon;      ///< Added to the root of the second moment (Adam, AdamW)
+    double weightDecay;  ///< Weight decay of the weight matrices (biases are never decayed)
+
+    /**
+     * @brief Constructor for OptimizerConfig, plain SGD with the usual defaults
+     */
+    OptimizerConfig(OptimizerType type = OPTIMIZER_SGD)
+        : type(type), momentum(0.9), beta1(0.9), beta2(0.999), epsilon(1e-8), weightDecay(0.0) {}
+};
+
+/**
+ * @struct OptimizerStep
+ * @brief Scalars of one fused update, worked out once per step for every parameter
+ *
+ * For Adam the bias corrections are folded into rate and epsilon, so the kernel never
+ * divides by 1 - beta^t: w -= rate * m / (sqrt(v) + epsilon).
+ */
+template <typename T>
+struct OptimizerStep {
+    OptimizerType type;  ///< Update rule
+    T rate;              ///< Step size
+    T gradientScale;     ///< Applied to the raw gradient, e.g. 1 / batch size
+    T momentum;          ///< mu, or beta1 for Adam
+    T beta2;             ///< beta2 (Adam)
+    T epsilon;           ///< Bias corrected epsilon (Adam)
+    T l2;                ///< Weight decay added to the gradient (l2 * w)
+    T decay;             ///< Decoupled weight decay, w -= decay * w before the step (AdamW)
+};
+
+/**
+ * @class BasicOptimizer
+ * @brief Applies an update rule to the parameters of a network
+ * @tparam T Element type of the parameters, double or float
+ *
+ * Parameters are registered once with reset, which allocates each one's state (velocity
+ * or first and second moments, zeroed) as contiguous buffers of the parameter's shape.
+ * A step is beginStep followed by one update per parameter; every update is a single
+ * fused pass over the parameter, its gradient and its state (see KernelOps::optimize),
+ * so it does not allocate.
+ */
+template <typename T>
+class BasicOptimizer {
+public:
+    /**
+     * @brief Constructor for BasicOptimizer
+     * @param config Update rule and hyperparameters
+     */
+    BasicOptimizer(const OptimizerConfig& config = OptimizerConfig());
+
+    /**
+     * @brief Destructor, frees the state buffers
+     */
+    ~BasicOptimizer();
+
+    /**
+     * @brief Changes the update rule, dropping all state
+     * @param config Update rule and hyperparameters
+     */
+    void setConfig(const OptimizerConfig& config);
+
+    /**
+     * @brief Gets the update rule
+     * @return Update rule and hyperparameters
+     */
+    OptimizerConfig getConfig() const { return this->config; }
+
+    /**
+     * @brief Allocates zeroed state for a set of parameters and restarts the step count
+     * @param params Parameters in update order, weights first then biases
+     * @param numWeights Number of leading entries of params that are weight matrices
+     */
+    void reset(const vector<BasicMatrix<T>*>& params, int numWeights);
+
+    /**
+     * @brief Frees the state of every parameter and restarts the step count
+     */
+    void clear();
+
+    /**
+     * @brief Starts a new step, advancing the step count Adam's bias correction uses
+     */
+    void beginStep();
+
+    /**
+     * @brief Updates one parameter in place
+     * @param index Parameter index, as registered with reset
+     * @param param Parameter to update, same shape as at reset
+     * @param gradient Gradient of param
+     * @param learningRate Learning rate
+     * @param gradientScale Factor applied to gradient, e.g. 1 / batch size
+     */
+    void update(int index, BasicMatrix<T>& param, const BasicMatrix<T>& gradient, double learningRate, double gradientScale);
+
+    /**
+     * @brief Gets the number of steps taken since the last reset
+     * @return Step count
+     */
+    long long getStepCount() const { return this->steps; }
+
+    /**
+     * @brief Gets the printable name of an update rule
+     * @param type Update rule
+     * @return Name such as "adamw"
+     */
+    static const char* getName(OptimizerType type);
+
+private:
+    /**
+     * @brief State of one parameter, null where the rule needs none
+     */
+    struct State {
+        BasicMatrix<T>* m;  ///< Velocity or first moment
+        BasicMatrix<T>* v;  ///< Second moment
+        bool decayed;       ///< Whether weight decay applies (weight matrices only)
+    };
+
+    OptimizerConfig config;  ///< Update rule and hyperparameters
+    vector<State> states;    ///< State of every registered parameter
+    long long steps;         ///< Steps since the last reset
+    double beta1Power;       ///< beta1^steps
+    double beta2Power;       ///< beta2^steps
+};
+
+typedef BasicOptimizer<double> Optimizer;
+typedef BasicOptimizer<float> OptimizerF;
+
+#endif // _OPTIMIZER_HPP_
@@ -0,0 +1,127 @@
+#ifndef _OPTIMIZERKERNELS_HPP_
+#define _OPTIMIZERKERNELS_HPP_
+
+#include <cstring>
+#include "Optimizer.hpp"
+#include "Kernels.hpp"
+
+/**
+ * @struct OptimizerKernels
+ * @brief Fused optimizer updates written once against a register traits struct
+ * @tparam S Register operations of one instruction set and element type
+ * @tparam T Element type, double or float
+ *
+ * Like ActivationKernels, each kernel translation unit instantiates this with its own
+ * traits. Besides what ActivationKernels uses, S provides sqrt.
+ *
+ * Every rule reads the parameter, its gradient and its state once and writes the
+ * parameter and state once, so an update is one pass over memory.
+ */
+template <typename S, typename T>
+struct OptimizerKernels {
+    typedef typename S::V V;
+
+    /**
+     * @brief Updates one register of parameters w and state m, v from gradient g
+     */
+    template <OptimizerType type>
+    static NN_ALWAYS_INLINE void step(const OptimizerStep<T>& s, V& w, V g, V& m, V& v) {
+        // Decoupled decay first, then the L2 term on the (scaled) gradient
+        if (type == OPTIMIZER_ADAMW) {
+            w = S::fnmadd(S::set1(s.decay), w, w);
+        }
+        g = S::fmadd(S::set1(s.l2), w, S::mul(S::set1(s.gradientScale), g));
+
+        switch (type) {
+            case OPTIMIZER_SGD:
+                w = S::fnmadd(S::set1(s.rate), g, w);
+                break;
+            case OPTIMIZER_MOMENTUM:
+                m = S::fmadd(S::set1(s.momentum), m, g);
+                w = S::fnmadd(S::set1(s.rate), m, w);
+                break;
+            case OPTIMIZER_NESTEROV:
+                m = S::fmadd(S::set1(s.momentum), m, g);
+                w = S::fnmadd(S::set1(s.rate), S::fmadd(S::set1(s.momentum), m, g), w);
+                break;
+            case OPTIMIZER_ADAM:
+            case OPTIMIZER_ADAMW: {
+                // m += (1 - b1)(g - m), v += (1 - b2)(g^2 - v)
+                m = S::fmadd(S::set1(1 - s.momentum), S::sub(g, m), m);
+                v = S::fmadd(S::set1(1 - s.beta2), S::sub(S::mul(g, g), v), v);
+                const V denom = S::add(S::sqrt(v), S::set1(s.epsilon));
+                w = S::fnmadd(S::set1(s.rate), S::div(m, denom), w);
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Applies one rule to n values, a register at a time
+     *
+     * The tail goes through register-sized buffers, as in ActivationKernels. m and v are
+     * only touched by the rules that have them.
+     */
+    template <OptimizerType type>
+    static void loop(const OptimizerStep<T>& s, T* w, const T* g, T* m, T* v, size_t n) {
+        const bool hasM = type != OPTIMIZER_SGD;
+        const bool hasV = type == OPTIMIZER_ADAM || type == OPTIMIZER_ADAMW;
+        const size_t width = S::width;
+        const V zero = S::set1((T)0);
+        size_t i = 0;
+        for (; i + width <= n; i += width) {
+            V vw = S::load(w + i);
+            V vm = hasM ? S::load(m + i) : zero;
+            V vv = hasV ? S::load(v + i) : zero;
+            step<type>(s, vw, S::load(g + i), vm, vv);
+            S::store(w + i, vw);
+            if (hasM) {
+                S::store(m + i, vm);
+            }
+            if (hasV) {
+                S::store(v + i, vv);
+            }
+        }
+        if (i < n) {
+            const size_t rest = sizeof(T) * (n - i);
+            T bw[S::width] = {}, bg[S::width] = {}, bm[S::width] = {}, bv[S::width] = {};
+            memcpy(bw, w + i, rest);
+            memcpy(bg, g + i, rest);
+            if (hasM) {
+                memcpy(bm, m + i, rest);
+            }
+            if (hasV) {
+                memcpy(bv, v + i, rest);
+            }
+            V vw = S::load(bw);
+            V vm = S::load(bm);
+            V vv = S::load(bv);
+            step<type>(s, vw, S::load(bg), vm, vv);
+            S::store(bw, vw);
+            S::store(bm, vm);
+            S::store(bv, vv);
+            memcpy(w + i, bw, rest);
+            if (hasM) {
+                memcpy(m + i, bm, rest);
+            }
+            if (hasV) {
+                memcpy(v + i, bv, rest);
+            }
+        }
+    }
+
+    /**
+     * @brief Kernel entry point, see KernelOps::optimize
+     */
+    static void optimize(const OptimizerStep<T>& s, T* w, const T* g, T* m, T* v, size_t n) {
+        switch (s.type) {
+            case OPTIMIZER_SGD: loop<OPTIMIZER_SGD>(s, w, g, m, v, n); break;
+            case OPTIMIZER_MOMENTUM: loop<OPTIMIZER_MOMENTUM>(s, w, g, m, v, n); break;
+            case OPTIMIZER_NESTEROV: loop<OPTIMIZER_NESTEROV>(s, w, g, m, v, n); break;
+            case OPTIMIZER_ADAM: loop<OPTIMIZER_ADAM>(s, w, g, m, v, n); break;
+            case OPTIMIZER_ADAMW: loop<OPTIMIZER_ADAMW>(s, w, g, m, v, n); break;
+        }
+    }
+};
+
+#endif // _OPTIMIZERKERNELS_HPP_
@@ -0,0 +1,109 @@
+#ifndef _PERF_COUNTERS_HPP_
+#define _PERF_COUNTERS_HPP_
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Events counted by PerfCounters
+ */
+enum PerfEvent {
+    PERF_TASK_CLOCK = 0,    ///< CPU time of the thread in nanoseconds (software, usually permitted)
+    PERF_CYCLES,            ///< Core cycles
+    PERF_INSTRUCTIONS,      ///< Retired instructions
+    PERF_L1D_MISSES,        ///< L1 data cache read misses
+    PERF_LLC_MISSES,        ///< Last level cache misses
+    PERF_BRANCH_MISSES,     ///< Mispredicted branches
+    PERF_EVENT_COUNT
+};
+
+/**
+ * @struct MachinePeak
+ * @brief Measured ceilings of the roofline model
+ */
+struct MachinePeak {
+    double gflops;          ///< Best GFLOP/s of the FMA loop on every pool thread or of a large GEMM
+    double gbytesPerSecond; ///< Best GB/s of an axpy over arrays larger than the caches
+};
+
+/**
+ * @class PerfCounters
+ * @brief Hardware performance counters of the calling thread, via Linux perf_event_open
+ *
+ * All events are opened as one group led by the task clock, so a single read returns
+ * consistent values, scaled up if the kernel had to multiplex the counters. Events the
+ * machine or container does not allow (no PMU in a VM, perf_event_paranoid, seccomp) are
+ * left out: isCounting tells which ones are live, and if not even the task clock can be
+ * opened the counters are simply closed and read returns false. On other platforms the
+ * counters are never open.
+ *
+ * Counters follow the thread that opened them, so work handed to other ThreadPool
+ * threads is not included; run with ThreadPool::setNumThreads(1) for complete counts.
+ */
+class PerfCounters {
+public:
+    /**
+     * @brief Constructor for PerfCounters, opens the counters for the calling thread
+     */
+    PerfCounters();
+
+    /**
+     * @brief Destructor, closes the counters
+     */
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * @brief Tells whether at least the task clock could be opened
+     * @return True if read can succeed
+     */
+    bool isOpen() const { return this->fds[PERF_TASK_CLOCK] >= 0; }
+
+    /**
+     * @brief Tells whether an event is being counted
+     * @param event Event
+     * @return True if the event was opened
+     */
+    bool isCounting(PerfEvent event) const { return this->fds[event] >= 0; }
+
+    /**
+     * @brief Reads all events
+     * @param values Receives the running totals, 0 for events not counted
+     * @return Whether the counters could be read
+     */
+    bool read(uint64_t values[PERF_EVENT_COUNT]) const;
+
+    /**
+     * @brief Why the first event that could not be opened failed
+     * @return Description, empty if every event opened
+     */
+    const string& getError() const { return this->error; }
+
+    /**
+     * @brief Gets the printable name of an event
+     * @param event Event
+     * @return Name such as "cycles"
+     */
+    static const char* getName(PerfEvent event);
+
+    /**
+     * @brief Measures the compute and memory ceilings of this machine
+     *
+     * The compute ceiling is the larger of a register-only multiply-add loop of the dispatched
+     * instruction set (Kernels) run on every thread of the global pool, and a large GEMM.
+     * @return Peak GFLOP/s and GB/s
+     */
+    static MachinePeak measurePeak();
+
+private:
+    int fds[PERF_EVENT_COUNT];  ///< File descriptor per event, -1 if not counted
+    int slots[PERF_EVENT_COUNT];///< Position of each event in a group read
+    int numOpen;                ///< Events in the group
+    string error;               ///< First open failure
+};
+
+#endif // _PERF_COUNTERS_HPP_
@@ -0,0 +1,182 @@
+#ifndef _PROFILER_HPP_
+#define _PROFILER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "PerfCounters.hpp"
+
+using namespace std;
+
+/// Trace events kept per thread; further scopes are still counted in the summary
+#define PROFILER_MAX_EVENTS (1 << 20)
+/// Nesting depth of scopes reserved per thread, deeper nesting still works but allocates
+#define PROFILER_MAX_DEPTH 64
+
+/**
+ * Instrumentation macros. Unless the library is built with NN_PROFILE (cmake -DNN_PROFILE=ON)
+ * they expand to nothing and their arguments are not evaluated, so instrumented code costs
+ * nothing in normal builds.
+ *
+ * NN_PROFILE_SCOPE(name, layer, flops) times the rest of the enclosing block. name must be
+ * a string literal, layer is the network layer the work belongs to or -1 to inherit the
+ * layer of the enclosing scope, flops the floating point operations of the block.
+ *
+ * NN_PROFILE_ALLOC(bytes) charges an allocation to the innermost open scope of the thread.
+ */
+#ifdef NN_PROFILE
+#define NN_PROFILE_CONCAT_(a, b) a##b
+#define NN_PROFILE_CONCAT(a, b) NN_PROFILE_CONCAT_(a, b)
+#define NN_PROFILE_SCOPE(name, layer, flops) ProfileScope NN_PROFILE_CONCAT(nnProfileScope, __LINE__)(name, layer, flops)
+#define NN_PROFILE_ALLOC(bytes) Profiler::recordAlloc(bytes)
+#else
+#define NN_PROFILE_SCOPE(name, layer, flops) ((void)0)
+#define NN_PROFILE_ALLOC(bytes) ((void)0)
+#endif
+
+/**
+ * @struct ProfileStat
+ * @brief Totals of one operation on one layer
+ */
+struct ProfileStat {
+    const char* name;       ///< Operation, e.g. "gemm" or "forward"
+    int layer;              ///< Layer index, -1 outside any layer
+    uint64_t calls;         ///< Number of scopes
+    double seconds;         ///< Inclusive time
+    double selfSeconds;     ///< Time not spent in nested scopes
+    double flops;           ///< Floating point operations
+    uint64_t bytes;         ///< Bytes allocated inside the scopes, nested ones excluded
+    uint64_t countedCalls;  ///< Scopes that also read the hardware counters
+    uint64_t counters[PERF_EVENT_COUNT]; ///< Hardware counter totals, nested scopes included
+};
+
+/**
+ * @class Profiler
+ * @brief Per-layer, per-operation timings with Chrome trace export
+ *
+ * Every thread records into its own buffer, so a scope costs two clock reads and a few
+ * stores with no locking. Scopes nest: the time of inner scopes is subtracted from the
+ * self time of the outer one, and the trace viewer shows them as a call stack.
+ *
+ * With setHardwareCounters, each scope also reads the PerfCounters of its thread, which
+ * costs a system call per scope boundary; printCounters then reports IPC, cache and branch
+ * misses and a roofline comparison per operation and layer.
+ *
+ * reset, getStats, printSummary, printCounters and writeChromeTrace must not run while
+ * instrumented code is running on another thread.
+ */
+class Profiler {
+public:
+    /**
+     * @brief Starts or pauses recording, enabled by default
+     * @param enabled Whether scopes are recorded
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief Tells whether scopes are recorded
+     * @return True if recording
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Tells whether the library was built with NN_PROFILE
+     * @return True if the instrumentation is compiled in
+     */
+    static bool isCompiledIn();
+
+    /**
+     * @brief Turns the hardware counters on or off for the scopes opened from now on
+     * @param enabled Whether scopes read the PerfCounters of their thread, off by default
+     * @return Whether the counters could be opened on the calling thread (always true when disabling)
+     */
+    static bool setHardwareCounters(bool enabled);
+
+    /**
+     * @brief Tells whether scopes read the hardware counters
+     * @return True if enabled
+     */
+    static bool hasHardwareCounters();
+
+    /**
+     * @brief Discards everything recorded so far
+     */
+    static void reset();
+
+    /**
+     * @brief Opens a scope on the calling thread, use NN_PROFILE_SCOPE instead
+     * @param name Operation, a string literal
+     * @param layer Layer index, -1 to inherit the enclosing scope's
+     * @param flops Floating point operations of the scope
+     */
+    static void begin(const char* name, int layer, double flops);
+
+    /**
+     * @brief Closes the innermost scope of the calling thread
+     */
+    static void end();
+
+    /**
+     * @brief Charges an allocation to the innermost scope of the calling thread
+     * @param bytes Size of the allocation
+     */
+    static void recordAlloc(size_t bytes);
+
+    /**
+     * @brief Totals per operation and layer over all threads
+     * @return Statistics sorted by layer, then by decreasing time
+     */
+    static vector<ProfileStat> getStats();
+
+    /**
+     * @brief Prints the totals as a table
+     * @param out Stream
+     */
+    static void printSummary(ostream& out);
+
+    /**
+     * @brief Prints the hardware counters per operation and layer against the machine's roofline
+     *
+     * Arithmetic intensity is estimated from the LLC misses (64 bytes each), so an operation
+     * whose GFLOP/s sits near min(peak GFLOP/s, intensity * peak GB/s) is at the roofline.
+     * @param out Stream
+     * @param peak Ceilings, see PerfCounters::measurePeak
+     */
+    static void printCounters(ostream& out, const MachinePeak& peak);
+
+    /**
+     * @brief Writes the recorded scopes in the Chrome trace event format
+     *
+     * The file opens in chrome://tracing or https://ui.perfetto.dev, one track per thread.
+     * @param path Output file
+     * @return Whether the file was written
+     */
+    static bool writeChromeTrace(const string& path);
+};
+
+/**
+ * @class ProfileScope
+ * @brief Times its own lifetime, see NN_PROFILE_SCOPE
+ */
+class ProfileScope {
+public:
+    /**
+     * @brief Constructor for ProfileScope, opens the scope
+     * @param name Operation, a string literal
+     * @param layer Layer index, -1 to inherit the enclosing scope's
+     * @param flops Floating point operations of the scope
+     */
+    ProfileScope(const char* name, int layer, double flops) { Profiler::begin(name, layer, flops); }
+
+    /**
+     * @brief Destructor, closes the scope
+     */
+    ~ProfileScope() { Profiler::end(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#endif // _PROFILER_HPP_
@@ -0,0 +1,172 @@
+#ifndef _QUANTIZEDNETWORK_HPP_
+#define _QUANTIZEDNETWORK_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Matrix.hpp"
+#include "NeuralNetwork.hpp"
+
+using namespace std;
+
+#define QUANTIZED_FILE_MAGIC "NNFSQ8"
+#define QUANTIZED_FILE_VERSION 2
+#define QUANTIZED_MAX 127
+
+/**
+ * @struct QuantizedFileHeader
+ * @brief First 64 bytes of a quantized model file
+ *
+ * The header is followed by the topology (numLayers uint32 values), the ActivationType
+ * of every layer (numLayers uint32 values, since version 2) and, for each weight matrix,
+ * its input scale (float), row scales (float[rows]), biases of the next layer
+ * (float[rows]) and row-major int8 weights (rows * cols bytes). Version 1 files have no
+ * activations and load as softsign throughout.
+ */
+struct QuantizedFileHeader {
+    char magic[8];        ///< QUANTIZED_FILE_MAGIC, zero padded
+    uint32_t version;     ///< QUANTIZED_FILE_VERSION, or 1 for files without activations
+    uint32_t byteOrder;   ///< MODEL_FILE_BYTE_ORDER in the byte order of the writer
+    uint32_t numLayers;   ///< Number of entries in the topology
+    uint32_t reserved0;   ///< Zero
+    uint64_t payloadSize; ///< Bytes following the header
+    uint64_t checksum;    ///< FNV-1a hash of the payload
+    uint64_t reserved[3]; ///< Zero
+};
+
+/**
+ * @struct QuantizationReport
+ * @brief Differences between the int8 and double precision outputs on a set of inputs
+ */
+struct QuantizationReport {
+    int samples;             ///< Number of inputs compared
+    double maxAbsError;      ///< Largest absolute difference of any output
+    double meanAbsError;     ///< Mean absolute difference over all outputs
+    double rmsError;         ///< Root mean square difference over all outputs
+    double maxRelativeError; ///< Largest difference relative to the double output's largest magnitude
+    double argmaxAgreement;  ///< Fraction of inputs whose largest output is the same neuron
+};
+
+/**
+ * @class QuantizedNetwork
+ * @brief Int8 inference engine built from a trained network
+ *
+ * Weights are quantized symmetrically per row (scale = max |w| / 127) and the input of
+ * every weight matrix per layer, with a scale calibrated from the largest magnitude seen
+ * on a set of sample inputs. A layer is one int8 GEMV with int32 accumulation, rescaled
+ * to float and followed by the bias and the layer's activation, mirroring NeuralNetwork::predict:
+ * the input layer feeds raw values, hidden layers activated ones, and the raw output
+ * values are returned.
+ */
+class QuantizedNetwork {
+public:
+    /**
+     * @brief Quantizes a trained network
+     * @param network Network to quantize (its weights are not modified)
+     * @param calibration Sample inputs used to choose the activation scales
+     */
+    QuantizedNetwork(NeuralNetwork& network, const vector<vector<double>>& calibration);
+
+    /**
+     * @brief Loads a quantized model written by save
+     * @param path Path to the quantized model file
+     */
+    QuantizedNetwork(const string& path);
+
+    /**
+     * @brief Destructor to clean up memory
+     */
+    ~QuantizedNetwork();
+
+    /**
+     * @brief Writes the quantized model, e.g. next to the model saved by NeuralNetwork::saveModel
+     * @param path Path to save the quantized model
+     */
+    void save(const string& path);
+
+    /**
+     * @brief Makes a prediction with the int8 engine
+     * @param input Input vector
+     * @return Matrix containing the output prediction (caller deletes)
+     */
+    Matrix* predict(const vector<double>& input);
+
+    /**
+     * @brief Makes a prediction into a caller buffer without allocating
+     * @param input Input values, one per input neuron
+     * @param output Receives one value per output neuron
+     */
+    void predictInto(const double* input, double* output);
+
+    /**
+     * @brief Compares the int8 outputs with the double precision predict on the same inputs
+     * @param network Network the engine was quantized from
+     * @param inputs Inputs to compare on
+     * @return Error statistics
+     */
+    QuantizationReport evaluate(NeuralNetwork& network, const vector<vector<double>>& inputs);
+
+    /**
+     * @brief Prints an accuracy report to the console
+     * @param report Report returned by evaluate
+     */
+    static void printReport(const QuantizationReport& report);
+
+    /**
+     * @brief Checks whether a file starts with the quantized model magic
+     * @param path Path to the file
+     * @return True for quantized model files
+     */
+    static bool isQuantized(const string& path);
+
+    /**
+     * @brief Gets the network topology
+     * @return Neurons per layer
+     */
+    vector<int> getTopology() const { return this->topology; }
+
+    /**
+     * @brief Gets the scale of the input of a weight matrix
+     * @param index Weight matrix index
+     * @return Value of one int8 step of the layer's input
+     */
+    float getInputScale(int index) const { return this->layers.at(index).inputScale; }
+
+private:
+    /**
+     * @brief One quantized weight matrix and what is needed to rescale its output
+     */
+    struct QuantizedLayer {
+        int rows;          ///< Neurons of the next layer
+        int cols;          ///< Neurons of this layer
+        int stride;        ///< Bytes between weight rows, cols rounded up to MATRIX_ALIGNMENT
+        int8_t* weights;   ///< rows x stride int8 weights, zero padded
+        float* rowScales;  ///< Value of one int8 step of each weight row
+        float* biases;     ///< Biases of the next layer
+        float inputScale;  ///< Value of one int8 step of the input
+        ActivationType activation;  ///< Activation of the next layer
+    };
+
+    /**
+     * @brief Allocates the layers and scratch buffers for the topology
+     */
+    void allocate();
+
+    /**
+     * @brief Quantizes values to int8 with a given scale
+     * @param in Values to quantize
+     * @param out Receives the int8 values
+     * @param n Number of values
+     * @param scale Value of one int8 step
+     */
+    static void quantize(const float* in, int8_t* out, int n, float scale);
+
+    vector<int> topology;            ///< Neurons per layer
+    vector<QuantizedLayer> layers;   ///< One entry per weight matrix
+    int8_t* inputBuffer;             ///< Quantized input of the current layer
+    int32_t* accumulators;           ///< Int32 GEMV results of the current layer
+    float* values;                   ///< Float input of the current layer
+    float* nextValues;               ///< Float output of the current layer
+};
+
+#endif // _QUANTIZEDNETWORK_HPP_
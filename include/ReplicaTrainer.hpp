@@ -0,0 +1,125 @@
+#ifndef _REPLICATRAINER_HPP_
+#define _REPLICATRAINER_HPP_
+
+#include <iostream>
+#include <vector>
+#include "Matrix.hpp"
+#include "NeuralNetwork.hpp"
+
+using namespace std;
+
+/**
+ * @brief How replicas combine their updates
+ */
+enum ReplicaMode {
+    REPLICA_SYNC,    ///< Private weights, averaged across replicas every syncInterval steps
+    REPLICA_HOGWILD  ///< Weights shared by all replicas and updated without locks
+};
+
+/**
+ * @struct ReplicaStats
+ * @brief Throughput and error of one replica over the last call to train
+ */
+struct ReplicaStats {
+    int replica;              ///< Replica index
+    size_t samples;           ///< Samples processed
+    double seconds;           ///< Wall time of the replica thread
+    double samplesPerSecond;  ///< samples / seconds
+    double meanError;         ///< Mean per-sample error over the last epoch
+};
+
+/**
+ * @class ReplicaTrainer
+ * @brief Data-parallel training of one model with N replicas on N threads
+ *
+ * The dataset is split into N disjoint contiguous shards and replica r trains on shard r
+ * with the ordinary feedForward/backPropogate loop on its own thread.
+ *
+ * In REPLICA_SYNC mode every replica has private weights. Every syncInterval steps all
+ * replicas meet at a barrier and average their parameters, each replica reducing a fixed
+ * slice in replica order, so the result is deterministic. With plain SGD and an interval
+ * of 1 this is exactly synchronous SGD with an all-reduced gradient.
+ *
+ * In REPLICA_HOGWILD mode the replicas' weight and bias matrices are views onto the
+ * model's own, and each replica applies its updates in place without any locking. The
+ * occasional lost or torn update is accepted by design (Hogwild), so results are not
+ * reproducible in this mode.
+ */
+class ReplicaTrainer {
+public:
+    /**
+     * @brief Constructor for ReplicaTrainer
+     * @param model Network to train; receives the trained weights
+     * @param numReplicas Number of replicas and threads
+     * @param mode How replicas combine their updates
+     * @param syncInterval Steps between parameter averaging (REPLICA_SYNC only)
+     */
+    ReplicaTrainer(NeuralNetwork* model, int numReplicas, ReplicaMode mode, int syncInterval = 1);
+
+    /**
+     * @brief Destructor, deletes the replicas (not the model)
+     */
+    ~ReplicaTrainer();
+
+    /**
+     * @brief Trains the model on a dataset
+     * @param inputs Input vectors, one per sample
+     * @param targets Target vectors, one per sample
+     * @param epochs Number of passes over every shard
+     */
+    void train(const vector<vector<double>>& inputs, const vector<vector<double>>& targets, int epochs);
+
+    /**
+     * @brief Gets per-replica statistics of the last call to train
+     * @return One entry per replica
+     */
+    vector<ReplicaStats> getStats() const { return this->stats; }
+
+    /**
+     * @brief Gets the aggregate throughput of the last call to train
+     * @return Samples per second over all replicas
+     */
+    double getSamplesPerSecond() const { return this->samplesPerSecond; }
+
+    /**
+     * @brief Prints the per-replica and aggregate statistics to the console
+     */
+    void printStats();
+
+private:
+    /**
+     * @brief Training loop of one replica thread
+     */
+    void runReplica(int index, const vector<vector<double>>& inputs, const vector<vector<double>>& targets,
+                    int epochs, size_t stepsPerEpoch);
+
+    /**
+     * @brief Averages slice index of the parameters across replicas (REPLICA_SYNC)
+     */
+    void averageSlice(int index);
+
+    /**
+     * @brief Blocks until every replica thread has arrived
+     */
+    void barrier();
+
+    /**
+     * @brief Gets parameter matrix p (weights first, then biases) of a network
+     */
+    Matrix* getParameter(NeuralNetwork* network, int p);
+
+    NeuralNetwork* model;            ///< Network being trained
+    vector<NeuralNetwork*> replicas; ///< One network per thread
+    ReplicaMode mode;                ///< How replicas combine their updates
+    int syncInterval;                ///< Steps between averaging in REPLICA_SYNC
+    int numParameters;               ///< Number of weight and bias matrices
+    size_t parameterSize;            ///< Total number of parameter values
+
+    vector<ReplicaStats> stats;      ///< Statistics of the last call to train
+    double samplesPerSecond;         ///< Aggregate throughput of the last call to train
+
+    struct Barrier;
+    Barrier* sync;                   ///< Barrier shared by the replica threads
+};
+
+#endif // _REPLICATRAINER_HPP_
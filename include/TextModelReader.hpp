@@ -0,0 +1,116 @@
+#ifndef _TEXTMODELREADER_HPP_
+#define _TEXTMODELREADER_HPP_
+
+#include <fstream>
+#include <string>
+#include "Matrix.hpp"
+
+using namespace std;
+
+#define TEXT_MODEL_MAX_TOKEN 128
+
+/**
+ * @class TextModelReader
+ * @brief Single-pass reader for the legacy ';'/',' separated text model format
+ *
+ * The file is read through one fixed-size buffer and numbers are parsed straight out of
+ * it into their destination, so memory use does not depend on the size of the file.
+ * Malformed input stops the load with a std::runtime_error carrying the byte offset of
+ * the offending token.
+ */
+class TextModelReader {
+public:
+    /**
+     * @brief Opens a text model file
+     * @param path Path to the model file
+     * @param bufferSize Size of the read buffer in bytes
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    TextModelReader(const string& path, size_t bufferSize = 1 << 16);
+
+    /**
+     * @brief Destructor, releases the buffer
+     */
+    ~TextModelReader();
+
+    /**
+     * @brief Reads the next number and the delimiter after it
+     * @param delimiter Receives the delimiter, ',' or ';'
+     * @return Parsed value
+     */
+    double next(char& delimiter);
+
+    /**
+     * @brief Reads the next number, which must be followed by a given delimiter
+     * @param delimiter Expected delimiter, ',' or ';'
+     * @return Parsed value
+     */
+    double nextBefore(char delimiter);
+
+    /**
+     * @brief Reads one ';' terminated block of values into a matrix, row by row
+     * @param m Destination, its shape determines how many values are read
+     */
+    template <typename T>
+    void readMatrix(BasicMatrix<T>& m);
+
+    /**
+     * @brief Checks whether only whitespace is left in the file
+     * @return True at the end of the model
+     */
+    bool atEnd() { return !this->skipWhitespace(); }
+
+    /**
+     * @brief Fails unless only whitespace is left in the file
+     */
+    void expectEnd();
+
+    /**
+     * @brief Stops the load, reporting malformed input at the current token
+     * @param message Description of the problem
+     * @throws std::runtime_error always, with the byte offset of the token
+     */
+    [[noreturn]] void fail(const string& message);
+
+    /**
+     * @brief Gets the byte offset of the start of the current token
+     * @return Offset from the start of the file
+     */
+    size_t getOffset() const { return this->tokenOffset; }
+
+    /**
+     * @brief Parses a decimal floating point number, in the manner of std::from_chars
+     *
+     * Numbers with at most 15 significant digits and a small exponent are converted
+     * exactly with one multiplication or division; anything else goes through strtod.
+     * @param first Start of the text
+     * @param last End of the text
+     * @param value Receives the parsed value
+     * @return Pointer past the last character consumed, first if no number was found
+     */
+    static const char* parseDouble(const char* first, const char* last, double& value);
+
+private:
+    /**
+     * @brief Moves the unread bytes to the front of the buffer and fills the rest
+     */
+    void refill();
+
+    /**
+     * @brief Skips whitespace, refilling the buffer as needed
+     * @return False at the end of the file
+     */
+    bool skipWhitespace();
+
+    ifstream file;       ///< Model file
+    string path;         ///< Path of the model file, for error messages
+    char* buffer;        ///< Read buffer
+    size_t bufferSize;   ///< Capacity of the buffer
+    size_t pos;          ///< Next unread byte in the buffer
+    size_t end;          ///< End of the valid bytes in the buffer
+    size_t consumed;     ///< File offset of buffer[0]
+    size_t tokenOffset;  ///< File offset of the current token
+    bool eof;            ///< Whether the whole file has been read into the buffer
+};
+
+#endif // _TEXTMODELREADER_HPP_
@@ -0,0 +1,161 @@
+#ifndef _THREADPOOL_HPP_
+#define _THREADPOOL_HPP_
+
+#include <cstddef>
+#include <exception>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @class ThreadPool
+ * @brief Persistent worker threads for data-parallel loops
+ *
+ * parallelFor splits an index range into one contiguous chunk per thread, always at the
+ * same boundaries for a given thread count, and the calling thread works on the first
+ * chunk itself. Kernels built on it partition their outputs, never reduce across chunks,
+ * so results do not depend on the thread count.
+ *
+ * Loops whose estimated work is below the parallel threshold, loops started from inside
+ * another parallel loop, and loops started while the pool is busy with another caller run
+ * inline on the calling thread.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Constructor for ThreadPool
+     * @param numThreads Total number of threads including the caller (at least 1)
+     */
+    ThreadPool(int numThreads);
+
+    /**
+     * @brief Destructor, stops and joins the workers
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Gets the number of threads including the caller
+     * @return Thread count
+     */
+    int getNumThreads() const { return this->numThreads; }
+
+    /**
+     * @brief Changes the number of threads, restarting the workers
+     * @param numThreads Total number of threads including the caller (at least 1)
+     */
+    void resize(int numThreads);
+
+    /**
+     * @brief Runs body(chunkBegin, chunkEnd) over [begin, end) split across the threads
+     * @param begin First index
+     * @param end One past the last index
+     * @param work Estimated cost of the whole loop (e.g. flops), compared to the threshold
+     * @param body Callable taking (size_t begin, size_t end)
+     * @throws The first exception thrown by any chunk, once every chunk has finished
+     */
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, size_t work, F& body) {
+        if (end <= begin) {
+            return;
+        }
+        if (this->numThreads == 1 || end - begin < 2 || work < ThreadPool::threshold || ThreadPool::insideTask()) {
+            body(begin, end);
+            return;
+        }
+        this->run(begin, end, &ThreadPool::invoke<F>, &body);
+    }
+
+    /**
+     * @brief Gets the process-wide pool used by the matrix kernels
+     * @return Global pool, sized to the hardware concurrency on first use
+     */
+    static ThreadPool& global();
+
+    /**
+     * @brief Sets the number of threads of the global pool
+     * @param numThreads Total number of threads including the caller (at least 1)
+     */
+    static void setNumThreads(int numThreads) { ThreadPool::global().resize(numThreads); }
+
+    /**
+     * @brief Sets the minimum estimated work for a loop to be split across threads
+     * @param work Threshold, in the same units the callers estimate work in (flops)
+     */
+    static void setParallelThreshold(size_t work) { ThreadPool::threshold = work; }
+
+    /**
+     * @brief Gets the minimum estimated work for a loop to be split across threads
+     * @return Threshold
+     */
+    static size_t getParallelThreshold() { return ThreadPool::threshold; }
+
+    /**
+     * @brief Makes every parallel loop started from the calling thread run inline
+     *
+     * Used by threads that are themselves one of many parallel workers (e.g. training
+     * replicas), so they do not compete for the shared pool.
+     * @param inlineOnly Whether loops from this thread should run inline
+     */
+    static void setThreadInline(bool inlineOnly) { ThreadPool::insideTask() = inlineOnly; }
+
+private:
+    typedef void (*Task)(void* ctx, size_t begin, size_t end);
+
+    template <typename F>
+    static void invoke(void* ctx, size_t begin, size_t end) {
+        (*static_cast<F*>(ctx))(begin, end);
+    }
+
+    /**
+     * @brief Dispatches a loop to the workers and runs the first chunk on the caller
+     */
+    void run(size_t begin, size_t end, Task task, void* ctx);
+
+    /**
+     * @brief Runs chunk index of the current job, keeping its exception for the caller
+     */
+    void runChunk(int index);
+
+    /**
+     * @brief Main loop of worker thread index
+     * @param index Chunk index this worker runs
+     * @param seen Last job generation posted before the worker was started
+     */
+    void workerLoop(int index, unsigned long seen);
+
+    /**
+     * @brief Starts numThreads - 1 workers
+     */
+    void start();
+
+    /**
+     * @brief Stops and joins all workers
+     */
+    void stop();
+
+    /**
+     * @brief Flag set on threads currently executing a chunk, to serialize nested loops
+     */
+    static bool& insideTask();
+
+    int numThreads;                     ///< Threads including the caller
+    std::vector<std::thread> workers;   ///< Worker threads (numThreads - 1)
+    std::mutex callerMutex;             ///< Held by the thread that owns the current job
+    std::mutex mutex;                   ///< Protects the job state below
+    std::condition_variable wake;       ///< Signals a new job or shutdown to the workers
+    std::condition_variable done;       ///< Signals the caller that all chunks finished
+    unsigned long generation;           ///< Incremented for every job
+    bool stopping;                      ///< Set to shut the workers down
+    Task task;                          ///< Body of the current job
+    void* ctx;                          ///< Context passed to task
+    size_t begin;                       ///< Start of the current range
+    size_t end;                         ///< End of the current range
+    int chunks;                         ///< Number of chunks in the current job
+    int pending;                        ///< Worker chunks not yet finished
+    std::exception_ptr error;           ///< First exception thrown by a chunk of the current job
+
+    static size_t threshold;            ///< Minimum work to go parallel
+};
+
+#endif // _THREADPOOL_HPP_
@@ -0,0 +1,261 @@
+#ifndef _TRAINER_HPP_
+#define _TRAINER_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Matrix.hpp"
+#include "NeuralNetwork.hpp"
+#include "MappedDataset.hpp"
+
+using namespace std;
+
+/**
+ * @brief How the learning rate changes over a training run
+ *
+ * Every schedule starts from the network's learning rate when the Trainer is created
+ * and may be preceded by a linear warmup (TrainerConfig::warmupSteps).
+ */
+enum LearningRateSchedule {
+    SCHEDULE_CONSTANT,  ///< Base rate throughout
+    SCHEDULE_STEP,      ///< Base rate times stepFactor every stepEpochs epochs
+    SCHEDULE_COSINE     ///< Cosine decay from the base rate to minLearningRate over all steps
+};
+
+/**
+ * @struct TrainerConfig
+ * @brief Epochs, batching, schedule, early stopping and checkpointing of a Trainer
+ */
+struct TrainerConfig {
+    int epochs;                     ///< Maximum number of passes over the training set
+    int batchSize;                  ///< Samples per step
+    bool shuffle;                   ///< Whether to reorder the samples every epoch
+    uint64_t seed;                  ///< Seed of the shuffle
+    LearningRateSchedule schedule;  ///< Learning rate schedule
+    int stepEpochs;                 ///< Epochs between decays of SCHEDULE_STEP
+    double stepFactor;              ///< Decay factor of SCHEDULE_STEP
+    double minLearningRate;         ///< Final learning rate of SCHEDULE_COSINE
+    int warmupSteps;                ///< Steps of linear warmup from 0 to the base rate, 0 for none
+    int validateEvery;              ///< Epochs between validation passes
+    int patience;                   ///< Validations without improvement before stopping, 0 to never stop early
+    double minDelta;                ///< Smallest drop of the validation loss that counts as an improvement
+    bool restoreBest;               ///< Whether to end with the weights of the best validation
+    string checkpointPath;          ///< Model file checkpoints are written to, empty for none
+    int checkpointEvery;            ///< Epochs between checkpoints
+    bool checkpointBestOnly;        ///< Whether to checkpoint only when the validation loss improves
+    int logEvery;                   ///< Epochs between progress lines on stdout, 0 for none
+
+    /**
+     * @brief Constructor for TrainerConfig, 10 shuffled epochs in batches of 32 at a constant rate
+     */
+    TrainerConfig()
+        : epochs(10), batchSize(32), shuffle(true), seed(1), schedule(SCHEDULE_CONSTANT), stepEpochs(10),
+          stepFactor(0.1), minLearningRate(0.0), warmupSteps(0), validateEvery(1), patience(0), minDelta(0.0),
+          restoreBest(true), checkpointPath(""), checkpointEvery(1), checkpointBestOnly(false), logEvery(1) {}
+};
+
+/**
+ * @struct TrainerEpoch
+ * @brief What happened in one epoch of a training run
+ */
+struct TrainerEpoch {
+    int epoch;              ///< Epoch number, from 1
+    double trainLoss;       ///< Mean per-sample error of the epoch's steps
+    double validationLoss;  ///< Mean per-sample validation error, NaN if not validated
+    double learningRate;    ///< Learning rate of the epoch's last step
+    double seconds;         ///< Wall time of the epoch including validation
+};
+
+/**
+ * @class BasicTrainer
+ * @brief Runs epochs of mini-batch training on a network
+ *
+ * Each epoch trains on every batch of the training set with the scheduled learning rate,
+ * then every validateEvery epochs measures the validation loss with evaluate. When the
+ * loss has not improved by minDelta for patience validations training stops; with
+ * restoreBest the weights of the best validation are put back at the end.
+ *
+ * Checkpoints are written on a background thread: the training thread only copies the
+ * weights and hands the copy over, then carries on. If a checkpoint is still being
+ * written when the next one is due, the older pending copy is dropped in favour of the
+ * newer, so training never waits for the disk. Files are written next to the target and
+ * renamed into place only once fully written, so the checkpoint on disk is always complete:
+ * a failed write (e.g. a full disk) leaves the previous checkpoint and is counted by
+ * getCheckpointsFailed.
+ */
+template <typename T>
+class BasicTrainer {
+public:
+    /**
+     * @brief Constructor for BasicTrainer
+     * @param network Network to train, must outlive the trainer
+     * @param config Epochs, batching, schedule, early stopping and checkpointing
+     */
+    BasicTrainer(BasicNeuralNetwork<T>& network, const TrainerConfig& config = TrainerConfig());
+
+    /**
+     * @brief Destructor, finishes the pending checkpoint and joins the checkpoint thread
+     */
+    ~BasicTrainer();
+
+    /**
+     * @brief Trains on a mapped dataset, passing batch views straight to the network
+     * @param train Training set
+     * @param validation Validation set, or NULL to skip validation
+     * @return History, one entry per epoch run
+     */
+    const vector<TrainerEpoch>& fit(BasicMappedDataset<T>& train, BasicMappedDataset<T>* validation = NULL);
+
+    /**
+     * @brief Trains on samples held in memory
+     *
+     * Shuffling permutes an index array; the samples themselves are not moved.
+     * @param inputs Training input vectors, one per sample
+     * @param targets Training target vectors, one per sample
+     * @param validationInputs Validation input vectors, empty to skip validation
+     * @param validationTargets Validation target vectors
+     * @return History, one entry per epoch run
+     */
+    const vector<TrainerEpoch>& fit(const vector<vector<double>>& inputs, const vector<vector<double>>& targets,
+                                    const vector<vector<double>>& validationInputs = vector<vector<double>>(),
+                                    const vector<vector<double>>& validationTargets = vector<vector<double>>());
+
+    /**
+     * @brief Gets the scheduled learning rate of a step
+     * @param step Step number over the whole run, from 0
+     * @param epoch Epoch number, from 0
+     * @param totalSteps Steps in the whole run
+     * @return Learning rate
+     */
+    double getScheduledRate(int step, int epoch, int totalSteps) const;
+
+    /**
+     * @brief Writes a checkpoint of the network on the background thread
+     * @param path Model file to write
+     */
+    void checkpoint(const string& path);
+
+    /**
+     * @brief Waits until every requested checkpoint is on disk
+     */
+    void waitForCheckpoints();
+
+    /**
+     * @brief Gets the history of the last fit
+     * @return One entry per epoch run
+     */
+    const vector<TrainerEpoch>& getHistory() const { return this->history; }
+
+    /**
+     * @brief Gets the epoch with the lowest validation loss
+     * @return Epoch number, 0 if nothing was validated
+     */
+    int getBestEpoch() const { return this->bestEpoch; }
+
+    /**
+     * @brief Gets the lowest validation loss
+     * @return Loss of getBestEpoch
+     */
+    double getBestValidationLoss() const { return this->bestLoss; }
+
+    /**
+     * @brief Checks whether the last fit was stopped by early stopping
+     * @return True if it ran fewer than config.epochs epochs
+     */
+    bool stoppedEarly() const { return this->stopped; }
+
+    /**
+     * @brief Gets the number of checkpoints written to disk
+     * @return Completed checkpoints
+     */
+    int getCheckpointsWritten();
+
+    /**
+     * @brief Gets the number of checkpoints that could not be written
+     * @return Failed checkpoints, whose previous file was left in place
+     */
+    int getCheckpointsFailed();
+
+    /**
+     * @brief Gets the reason the last checkpoint failed
+     * @return Error message, empty if no checkpoint failed
+     */
+    string getCheckpointError();
+
+    /**
+     * @brief Gets the time the training thread spent on checkpoints
+     * @return Seconds spent copying weights for the checkpoint thread
+     */
+    double getCheckpointSeconds() const { return this->checkpointSeconds; }
+
+private:
+    /**
+     * @brief Weights and biases copied for the checkpoint thread
+     */
+    struct Snapshot {
+        string path;                      ///< File to write
+        vector<int> topology;             ///< Neurons per layer
+        vector<ActivationType> activations; ///< Activation of each layer
+        vector<BasicMatrix<T>*> weights;  ///< Copies of the weight matrices
+        vector<BasicMatrix<T>*> biases;   ///< Copies of the bias matrices
+        double learningRate;              ///< Learning rate to record
+    };
+
+    /**
+     * @brief Epoch loop shared by both fit overloads
+     * @param beginEpoch Lays out the epoch's batches and returns how many there are
+     * @param trainStep Trains on one batch and returns its number of samples
+     * @param validate Returns the validation loss, empty if there is no validation set
+     */
+    void run(const function<int()>& beginEpoch, const function<int(int)>& trainStep, const function<double()>& validate);
+
+    /**
+     * @brief Copies the current weights and biases
+     * @param weights Receives new copies of the weight matrices
+     * @param biases Receives new copies of the bias matrices
+     */
+    void copyParameters(vector<BasicMatrix<T>*>& weights, vector<BasicMatrix<T>*>& biases);
+
+    /**
+     * @brief Frees a list of copied matrices
+     * @param matrices Matrices to delete, cleared afterwards
+     */
+    static void freeParameters(vector<BasicMatrix<T>*>& matrices);
+
+    /**
+     * @brief Main loop of the checkpoint thread
+     */
+    void writerLoop();
+
+    BasicNeuralNetwork<T>& network;     ///< Network being trained
+    TrainerConfig config;               ///< Epochs, batching, schedule, early stopping and checkpointing
+    double baseRate;                    ///< Learning rate the schedule starts from
+    uint64_t rng;                       ///< State of the shuffle generator
+    vector<TrainerEpoch> history;       ///< One entry per epoch of the last fit
+    int bestEpoch;                      ///< Epoch of the lowest validation loss
+    double bestLoss;                    ///< Lowest validation loss
+    bool stopped;                       ///< Whether the last fit stopped early
+    vector<BasicMatrix<T>*> bestWeights; ///< Weights of the best validation, for restoreBest
+    vector<BasicMatrix<T>*> bestBiases;  ///< Biases of the best validation, for restoreBest
+    double checkpointSeconds;           ///< Training thread time spent on checkpoints
+
+    Snapshot* pending;                  ///< Next checkpoint to write, or NULL
+    bool writing;                       ///< Whether the thread is writing a checkpoint
+    bool stopping;                      ///< Set by the destructor to end the thread
+    int written;                        ///< Checkpoints written
+    int failed;                         ///< Checkpoints that could not be written
+    string checkpointError;             ///< Message of the last failed checkpoint
+    mutex lock;                         ///< Protects pending, writing, stopping, written and the failures
+    condition_variable wake;            ///< Signals a pending checkpoint or shutdown
+    condition_variable idle;            ///< Signals that the thread has nothing left to write
+    thread writer;                      ///< Checkpoint thread, started by the first checkpoint
+};
+
+typedef BasicTrainer<double> Trainer;
+typedef BasicTrainer<float> TrainerF;
+
+#endif // _TRAINER_HPP_
@@ -0,0 +1,103 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+#include "../include/Activation.hpp"
+#include "../include/Kernels.hpp"
+
+using namespace std;
+
+/**
+ * @brief Names of the activations, indexed by ActivationType
+ */
+static const char* const activationNames[ACTIVATION_COUNT] = {
+    "softsign", "identity", "relu", "leaky_relu", "tanh", "sigmoid", "gelu"
+};
+
+/**
+ * @brief Applies an activation and its derivative to n contiguous values
+ * @param type Activation function
+ * @param vals Raw values
+ * @param activated Receives the activated values, may alias vals
+ * @param derived Receives the derivatives at vals, or null when they are not needed
+ * @param n Number of values
+ */
+template <typename T>
+void Activation::apply(ActivationType type, const T* vals, T* activated, T* derived, size_t n) {
+    Kernels::ops<T>().activate(type, vals, activated, derived, n);
+}
+
+/**
+ * @brief Evaluates an activation with the C library (reference)
+ * @param type Activation function
+ * @param val Raw value
+ * @return Activated value
+ */
+double Activation::value(ActivationType type, double val) {
+    switch (type) {
+        case ACTIVATION_SOFTSIGN: return val / (1 + fabs(val));
+        case ACTIVATION_IDENTITY: return val;
+        case ACTIVATION_RELU: return val > 0 ? val : 0.0;
+        case ACTIVATION_LEAKY_RELU: return val > 0 ? val : ACTIVATION_LEAKY_SLOPE * val;
+        case ACTIVATION_TANH: return tanh(val);
+        case ACTIVATION_SIGMOID: return 1 / (1 + exp(-val));
+        case ACTIVATION_GELU: return 0.5 * val * (1 + tanh(ACTIVATION_GELU_SCALE * (val + ACTIVATION_GELU_CUBIC * val * val * val)));
+    }
+    cerr << "Unknown activation " << (int)type << endl;
+    assert(false);
+    return val;
+}
+
+/**
+ * @brief Evaluates the derivative of an activation with the C library (reference)
+ * @param type Activation function
+ * @param val Raw value
+ * @param activatedVal value(type, val)
+ * @return Derivative at val
+ */
+double Activation::derivative(ActivationType type, double val, double activatedVal) {
+    switch (type) {
+        case ACTIVATION_SOFTSIGN: return 1 / ((1 + fabs(val)) * (1 + fabs(val)));
+        case ACTIVATION_IDENTITY: return 1.0;
+        case ACTIVATION_RELU: return val > 0 ? 1.0 : 0.0;
+        case ACTIVATION_LEAKY_RELU: return val > 0 ? 1.0 : ACTIVATION_LEAKY_SLOPE;
+        case ACTIVATION_TANH: return 1 - activatedVal * activatedVal;
+        case ACTIVATION_SIGMOID: return activatedVal * (1 - activatedVal);
+        case ACTIVATION_GELU: {
+            const double t = tanh(ACTIVATION_GELU_SCALE * (val + ACTIVATION_GELU_CUBIC * val * val * val));
+            const double dt = ACTIVATION_GELU_SCALE * (1 + 3 * ACTIVATION_GELU_CUBIC * val * val);
+            return 0.5 * (1 + t) + 0.5 * val * (1 - t * t) * dt;
+        }
+    }
+    cerr << "Unknown activation " << (int)type << endl;
+    assert(false);
+    return 0.0;
+}
+
+/**
+ * @brief Gets the printable name of an activation
+ * @param type Activation function
+ * @return Name such as "relu"
+ */
+const char* Activation::getName(ActivationType type) {
+    return isValid(type) ? activationNames[type] : "unknown";
+}
+
+/**
+ * @brief Looks up an activation by the name getName returns
+ * @param name Activation name
+ * @return Activation function
+ */
+ActivationType Activation::fromName(const string& name) {
+    for (int i = 0; i < ACTIVATION_COUNT; i++) {
+        if (name == activationNames[i]) {
+            return (ActivationType)i;
+        }
+    }
+    cerr << "Unknown activation: " << name << endl;
+    assert(false);
+    return ACTIVATION_SOFTSIGN;
+}
+
+template void Activation::apply(ActivationType, const double*, double*, double*, size_t);
+template void Activation::apply(ActivationType, const float*, float*, float*, size_t);
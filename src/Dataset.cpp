@@ -0,0 +1,458 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+#include "../include/Dataset.hpp"
+#include "../include/Initializer.hpp"
+#include "../include/ModelFile.hpp"
+#include "../include/TextModelReader.hpp"
+
+using namespace std;
+
+/// Rows a binary file is read in at a time
+#define DATASET_BLOCK_ROWS 1024
+
+static_assert(sizeof(DatasetFileHeader) == 32, "DatasetFileHeader must stay 32 bytes");
+
+/**
+ * @brief Whether a character separates values in a CSV line
+ */
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Opens a dataset and starts the reader thread
+ * @param path Path to a CSV or binary row file
+ * @param numInputs Input values per sample
+ * @param numTargets Target values per sample
+ * @param config Batching, shuffling and prefetching
+ */
+DatasetLoader::DatasetLoader(const string& path, int numInputs, int numTargets, const DatasetConfig& config) {
+    if (numInputs < 1 || numTargets < 0 || config.batchSize < 1 || config.prefetch < 1) {
+        cerr << "Invalid dataset configuration for " << path << endl;
+        assert(false);
+    }
+    if (!ifstream(path, ios::binary).is_open()) {
+        cerr << "Could not open dataset: " << path << endl;
+        assert(false);
+    }
+
+    this->path = path;
+    this->format = DatasetLoader::isBinary(path) ? DATASET_BINARY : DATASET_CSV;
+    this->config = config;
+    this->numInputs = numInputs;
+    this->numTargets = numTargets;
+    this->width = numInputs + numTargets;
+
+    if (config.shuffleWindow > 1) {
+        this->window.resize(config.shuffleWindow * this->width);
+    }
+    this->windowCount = 0;
+    this->rng = config.seed;
+    this->filling = 0;
+    this->fillSlot = 0;
+    this->epoch = 0;
+    this->line = 0;
+
+    this->slots.resize(config.prefetch);
+    this->head = 0;
+    this->count = 0;
+    this->finished = false;
+    this->stopping = false;
+
+    this->currentPos = 0;
+    this->samplesRead = 0;
+    this->stallSeconds = 0.0;
+
+    this->reader = thread(&DatasetLoader::readerLoop, this);
+}
+
+/**
+ * @brief Destructor, stops and joins the reader thread
+ */
+DatasetLoader::~DatasetLoader() {
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->space.notify_all();
+    this->reader.join();
+}
+
+/**
+ * @brief Checks whether a file is a binary row file
+ * @param path Path to check
+ * @return True if the file starts with DATASET_FILE_MAGIC
+ */
+bool DatasetLoader::isBinary(const string& path) {
+    ifstream file(path, ios::binary);
+    char magic[sizeof(DATASET_FILE_MAGIC)];
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return memcmp(magic, DATASET_FILE_MAGIC, sizeof(DATASET_FILE_MAGIC)) == 0;
+}
+
+/**
+ * @brief Takes the next batch, waiting for the reader if none is ready
+ * @param batch Receives the batch; its previous buffers are recycled by the reader
+ * @return False once every epoch has been delivered
+ */
+bool DatasetLoader::next(DatasetBatch& batch) {
+    unique_lock<mutex> guard(this->lock);
+    if (this->count == 0 && !this->finished) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        this->ready.wait(guard, [this] { return this->count > 0 || this->finished; });
+        this->stallSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    if (this->count == 0) {
+        return false;
+    }
+
+    // Swap rather than copy: the slot takes the caller's old buffers for the reader to reuse
+    DatasetBatch& slot = this->slots.at(this->head);
+    batch.inputs.swap(slot.inputs);
+    batch.targets.swap(slot.targets);
+    batch.epoch = slot.epoch;
+    this->head = (this->head + 1) % this->slots.size();
+    this->count--;
+    guard.unlock();
+    this->space.notify_one();
+
+    this->samplesRead += batch.inputs.size();
+    return true;
+}
+
+/**
+ * @brief Takes the next single sample, for setCurrentInput/setCurrentTarget
+ * @param input Receives the input vector
+ * @param target Receives the target vector
+ * @return False once every epoch has been delivered
+ */
+bool DatasetLoader::nextSample(vector<double>& input, vector<double>& target) {
+    if (this->currentPos >= this->current.inputs.size()) {
+        if (!this->next(this->current)) {
+            return false;
+        }
+        this->currentPos = 0;
+    }
+    input = this->current.inputs.at(this->currentPos);
+    target = this->current.targets.at(this->currentPos);
+    this->currentPos++;
+    return true;
+}
+
+/**
+ * @brief Main loop of the reader thread
+ */
+void DatasetLoader::readerLoop() {
+    for (this->epoch = 0; this->epoch < this->config.epochs; this->epoch++) {
+        const bool read = this->format == DATASET_BINARY ? this->readBinary() : this->readCsv();
+        if (!read || !this->finishEpoch()) {
+            break;
+        }
+    }
+
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->finished = true;
+    }
+    this->ready.notify_all();
+}
+
+/**
+ * @brief Parses a CSV file, passing every row to push
+ * @return False if the loader is being destroyed
+ */
+bool DatasetLoader::readCsv() {
+    ifstream file(this->path);
+    string text;
+    vector<double> row(this->width);
+
+    for (this->line = 1; getline(file, text); this->line++) {
+        if (this->line == 1 && this->config.skipHeader) {
+            continue;
+        }
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        if (p == end) {
+            continue;
+        }
+
+        for (int k = 0; k < this->width; k++) {
+            while (p < end && isSpace(*p)) {
+                p++;
+            }
+            const char* last = TextModelReader::parseDouble(p, end, row[k]);
+            if (last == p) {
+                this->fail("expected " + to_string(this->width) + " numbers, got " + to_string(k));
+            }
+            p = last;
+            while (p < end && isSpace(*p)) {
+                p++;
+            }
+            if (p < end && (*p == ',' || *p == ';')) {
+                p++;
+            }
+        }
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        if (p != end) {
+            this->fail("expected " + to_string(this->width) + " numbers, got more");
+        }
+
+        if (!this->push(row.data())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a binary row file, passing every row to push
+ * @return False if the loader is being destroyed
+ */
+bool DatasetLoader::readBinary() {
+    ifstream file(this->path, ios::binary);
+    DatasetFileHeader h;
+    this->line = 0;
+    if (!file.read(reinterpret_cast<char*>(&h), sizeof(h))) {
+        this->fail("file is too small to be a binary dataset");
+    }
+    if (h.byteOrder != MODEL_FILE_BYTE_ORDER) {
+        this->fail("file was written with a different byte order");
+    }
+    if (h.version != DATASET_FILE_VERSION) {
+        this->fail("unsupported version " + to_string(h.version));
+    }
+    if (h.numInputs != (uint32_t)this->numInputs || h.numTargets != (uint32_t)this->numTargets) {
+        this->fail("file has " + to_string(h.numInputs) + " inputs and " + to_string(h.numTargets) + " targets per row");
+    }
+
+    vector<float> block((size_t)DATASET_BLOCK_ROWS * this->width);
+    vector<double> row(this->width);
+    while (this->line < h.numRows) {
+        const size_t rows = (size_t)min<uint64_t>(DATASET_BLOCK_ROWS, h.numRows - this->line);
+        if (!file.read(reinterpret_cast<char*>(block.data()), sizeof(float) * rows * this->width)) {
+            this->fail("file is truncated");
+        }
+        for (size_t r = 0; r < rows; r++, this->line++) {
+            const float* src = block.data() + r * this->width;
+            for (int k = 0; k < this->width; k++) {
+                row[k] = src[k];
+            }
+            if (!this->push(row.data())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Passes one row through the shuffle window
+ * @param row numInputs + numTargets values
+ * @return False if the loader is being destroyed
+ */
+bool DatasetLoader::push(const double* row) {
+    const size_t size = this->config.shuffleWindow;
+    if (size <= 1) {
+        return this->emit(row);
+    }
+    if (this->windowCount < size) {
+        memcpy(&this->window[this->windowCount * this->width], row, sizeof(double) * this->width);
+        this->windowCount++;
+        return true;
+    }
+
+    // Emit a random sample of the window and put the new one in its place
+    double* slot = &this->window[(SplitMix64::next(this->rng) % size) * this->width];
+    if (!this->emit(slot)) {
+        return false;
+    }
+    memcpy(slot, row, sizeof(double) * this->width);
+    return true;
+}
+
+/**
+ * @brief Empties the shuffle window in random order and publishes the short batch
+ * @return False if the loader is being destroyed
+ */
+bool DatasetLoader::finishEpoch() {
+    while (this->windowCount > 0) {
+        double* slot = &this->window[(SplitMix64::next(this->rng) % this->windowCount) * this->width];
+        if (!this->emit(slot)) {
+            return false;
+        }
+        this->windowCount--;
+        memcpy(slot, &this->window[this->windowCount * this->width], sizeof(double) * this->width);
+    }
+
+    if (this->filling > 0 && this->config.dropLast) {
+        this->filling = 0;
+    }
+    if (this->filling > 0) {
+        return this->publish();
+    }
+    return true;
+}
+
+/**
+ * @brief Copies one row into the batch being filled, publishing it when full
+ * @param row numInputs + numTargets values
+ * @return False if the loader is being destroyed
+ */
+bool DatasetLoader::emit(const double* row) {
+    // The slot after the ready ones is free (publish waits for that), no lock needed
+    DatasetBatch& slot = this->slots.at(this->fillSlot);
+    if (slot.inputs.size() <= this->filling) {
+        slot.inputs.resize(this->config.batchSize);
+        slot.targets.resize(this->config.batchSize);
+    }
+    slot.inputs[this->filling].assign(row, row + this->numInputs);
+    slot.targets[this->filling].assign(row + this->numInputs, row + this->width);
+    this->filling++;
+
+    if (this->filling == this->config.batchSize) {
+        return this->publish();
+    }
+    return true;
+}
+
+/**
+ * @brief Hands the batch being filled to the training side
+ * @return False if the loader is being destroyed
+ */
+bool DatasetLoader::publish() {
+    DatasetBatch& slot = this->slots.at(this->fillSlot);
+    slot.inputs.resize(this->filling);
+    slot.targets.resize(this->filling);
+    slot.epoch = this->epoch;
+    this->filling = 0;
+    this->fillSlot = (this->fillSlot + 1) % this->slots.size();
+
+    unique_lock<mutex> guard(this->lock);
+    this->count++;
+    this->ready.notify_one();
+
+    // Wait for a free slot to fill next
+    this->space.wait(guard, [this] { return this->count < this->slots.size() || this->stopping; });
+    return !this->stopping;
+}
+
+/**
+ * @brief Reports malformed input and aborts
+ * @param message Description of the problem
+ */
+void DatasetLoader::fail(const string& message) {
+    cerr << "Malformed dataset " << this->path << " at " << (this->format == DATASET_CSV ? "line " : "row ")
+         << this->line << ": " << message << endl;
+    assert(false);
+}
+
+/**
+ * @brief Creates a binary row file
+ * @param path Path to write to
+ * @param numInputs Input values per sample
+ * @param numTargets Target values per sample
+ */
+DatasetWriter::DatasetWriter(const string& path, int numInputs, int numTargets) : file(path, ios::binary) {
+    if (!this->file.is_open()) {
+        cerr << "Could not create dataset: " << path << endl;
+        assert(false);
+    }
+
+    this->path = path;
+    this->numInputs = numInputs;
+    this->numTargets = numTargets;
+    this->numRows = 0;
+    this->row.resize(numInputs + numTargets);
+
+    // Row count is filled in by close
+    DatasetFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, DATASET_FILE_MAGIC, sizeof(DATASET_FILE_MAGIC));
+    h.version = DATASET_FILE_VERSION;
+    h.byteOrder = MODEL_FILE_BYTE_ORDER;
+    h.numInputs = numInputs;
+    h.numTargets = numTargets;
+    this->file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+}
+
+/**
+ * @brief Destructor, closes the file if close was not called
+ */
+DatasetWriter::~DatasetWriter() {
+    if (this->file.is_open()) {
+        this->close();
+    }
+}
+
+/**
+ * @brief Appends one sample
+ * @param input Input vector of numInputs values
+ * @param target Target vector of numTargets values
+ */
+void DatasetWriter::append(const vector<double>& input, const vector<double>& target) {
+    if (input.size() != this->numInputs || target.size() != this->numTargets) {
+        cerr << "Sample does not match the " << this->numInputs << " inputs and " << this->numTargets
+             << " targets of dataset " << this->path << endl;
+        assert(false);
+    }
+    for (int k = 0; k < this->numInputs; k++) {
+        this->row[k] = (float)input[k];
+    }
+    for (int k = 0; k < this->numTargets; k++) {
+        this->row[this->numInputs + k] = (float)target[k];
+    }
+    this->file.write(reinterpret_cast<const char*>(this->row.data()), sizeof(float) * this->row.size());
+    this->numRows++;
+}
+
+/**
+ * @brief Writes the row count into the header and closes the file
+ */
+void DatasetWriter::close() {
+    this->file.seekp(offsetof(DatasetFileHeader, numRows));
+    this->file.write(reinterpret_cast<const char*>(&this->numRows), sizeof(this->numRows));
+    this->file.close();
+    if (!this->file) {
+        cerr << "Could not write dataset: " << this->path << endl;
+        assert(false);
+    }
+}
+
+/**
+ * @brief Converts a CSV dataset to a binary row file, streaming
+ * @param csvPath CSV file to read
+ * @param path Binary file to write
+ * @param numInputs Input values per sample
+ * @param numTargets Target values per sample
+ * @param skipHeader Whether the first line of the CSV file is a header
+ * @return Number of rows written
+ */
+size_t DatasetWriter::fromCsv(const string& csvPath, const string& path, int numInputs, int numTargets, bool skipHeader) {
+    DatasetConfig config;
+    config.batchSize = 1024;
+    config.skipHeader = skipHeader;
+    DatasetLoader loader(csvPath, numInputs, numTargets, config);
+    DatasetWriter writer(path, numInputs, numTargets);
+
+    DatasetBatch batch;
+    size_t rows = 0;
+    while (loader.next(batch)) {
+        for (size_t i = 0; i < batch.inputs.size(); i++) {
+            writer.append(batch.inputs[i], batch.targets[i]);
+        }
+        rows += batch.inputs.size();
+    }
+    writer.close();
+    return rows;
+}
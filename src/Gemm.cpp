@@ -0,0 +1,480 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+
+#include "../include/Gemm.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/ThreadPool.hpp"
+
+#define GEMV_EPILOGUE_ROWS 64
+
+GemmKernel Gemm::kernel = GEMM_BLOCKED;
+int Gemm::mc = 128;
+int Gemm::kc = 256;
+int Gemm::nc = 2048;
+
+/**
+ * @brief Per-thread scratch buffers for the packed operands, grown on demand and reused
+ */
+template <typename T>
+struct GemmPackBuffers {
+    T* a = nullptr;
+    T* b = nullptr;
+    size_t aSize = 0;
+    size_t bSize = 0;
+
+    ~GemmPackBuffers() {
+        Matrix::alignedFree(this->a);
+        Matrix::alignedFree(this->b);
+    }
+
+    static T* reserve(T*& buf, size_t& size, size_t needed) {
+        if (needed > size) {
+            Matrix::alignedFree(buf);
+            buf = static_cast<T*>(Matrix::alignedAlloc(sizeof(T) * needed));
+            size = needed;
+        }
+        return buf;
+    }
+};
+
+/**
+ * @brief Gets the calling thread's pack buffers for one element type
+ */
+template <typename T>
+static GemmPackBuffers<T>& packBuffers() {
+    static thread_local GemmPackBuffers<T> buffers;
+    return buffers;
+}
+
+/**
+ * @brief Gets a printable name for a kernel
+ * @param kernel Kernel to name
+ * @return Kernel name
+ */
+const char* Gemm::getKernelName(GemmKernel kernel) {
+    switch (kernel) {
+        case GEMM_NAIVE: return "naive";
+        case GEMM_BLOCKED: return "blocked";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Sets the cache block sizes of the blocked kernel
+ * @param mc Rows of A packed per block (rounded up to the micro-kernel's rows when used)
+ * @param kc Depth of each packed panel
+ * @param nc Columns of B packed per panel (rounded up to the micro-kernel's columns when used)
+ */
+void Gemm::setBlockSizes(int mc, int kc, int nc) {
+    if (mc <= 0 || kc <= 0 || nc <= 0) {
+        std::cerr << "GEMM block sizes must be positive: " << std::endl;
+        assert(false);
+    }
+    Gemm::mc = mc;
+    Gemm::kc = kc;
+    Gemm::nc = nc;
+}
+
+/**
+ * @brief Computes c = op(a) * op(b), or c += op(a) * op(b) when accumulate is set
+ * @param a Left operand, M x K once op is applied
+ * @param b Right operand, K x N once op is applied
+ * @param c Output (M x N), may be a view
+ * @param accumulate Whether to add to the existing contents of c
+ * @param transA Whether to use the transpose of a
+ * @param transB Whether to use the transpose of b
+ */
+template <typename T>
+void Gemm::multiply(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& c, bool accumulate,
+                    GemmTranspose transA, GemmTranspose transB) {
+    const GemmOperand<T> opA(a, transA);
+    const GemmOperand<T> opB(b, transB);
+    NN_PROFILE_SCOPE("gemm", -1, 2.0 * opA.rows * opA.cols * opB.cols);
+    dispatch(opA, opB, c, accumulate, (const GemmEpilogue<T>*)nullptr);
+}
+
+/**
+ * @brief Computes one layer, c = a * b + bias, then its activation and derivative
+ * @param a Weights (M x K)
+ * @param b Input values (K x N), one column per sample
+ * @param bias Bias per row (M x 1)
+ * @param activation Activation function of the layer
+ * @param c Receives the raw values (M x N), may be a view
+ * @param activated Receives the activated values, or null to only add the bias
+ * @param derived Receives the derivatives, or null when they are not needed
+ */
+template <typename T>
+void Gemm::multiplyBiasActivate(const BasicMatrix<T>& a, const BasicMatrix<T>& b, const BasicMatrix<T>& bias,
+                                ActivationType activation, BasicMatrix<T>& c, BasicMatrix<T>* activated,
+                                BasicMatrix<T>* derived) {
+    if (bias.getNumRows() != c.getNumRows() || (activated != nullptr && activated->getNumRows() != c.getNumRows())
+        || (derived != nullptr && (activated == nullptr || derived->getNumRows() != c.getNumRows()))) {
+        std::cerr << "Bias or activation outputs do not match the product: " << std::endl;
+        assert(false);
+    }
+
+    NN_PROFILE_SCOPE("gemmBiasActivate", -1, 2.0 * a.getNumRows() * a.getNumCols() * b.getNumCols());
+    GemmEpilogue<T> epilogue = { &bias, activation, activated, derived };
+    dispatch(GemmOperand<T>(a, GEMM_NO_TRANSPOSE), GemmOperand<T>(b, GEMM_NO_TRANSPOSE), c, false, &epilogue);
+}
+
+/**
+ * @brief Checks the shapes and runs the kernel for them, with an optional epilogue
+ */
+template <typename T>
+void Gemm::dispatch(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c, bool accumulate,
+                    const GemmEpilogue<T>* epilogue) {
+    if (a.cols != b.rows || c.getNumRows() != a.rows || c.getNumCols() != b.cols) {
+        std::cerr << "Matrix dimensions incompatible for multiplication: " << std::endl;
+        std::cerr << "A: " << a.rows << "x" << a.cols << (a.colStep != 1 ? " (transposed)" : "") << std::endl;
+        std::cerr << "B: " << b.rows << "x" << b.cols << (b.colStep != 1 ? " (transposed)" : "") << std::endl;
+        std::cerr << "C: " << c.getNumRows() << "x" << c.getNumCols() << std::endl;
+        assert(false);
+    }
+
+    if (!accumulate) {
+        for (int i = 0; i < c.getNumRows(); i++) {
+            std::memset(c.rowPtr(i), 0, sizeof(T) * c.getNumCols());
+        }
+    }
+
+    if (a.rows == 0 || b.cols == 0) {
+        return;
+    }
+
+    // The matrix-vector and blocked kernels run the epilogue as they finish each row or
+    // tile, the others leave it to one pass at the end
+    bool fused = false;
+    if (a.cols > 0) {
+        if (Gemm::kernel == GEMM_NAIVE) {
+            naive(a, b, c);
+        }
+        else if (b.cols == 1 && a.colStep != 1) {
+            gemvTransposed(a, b, c, epilogue);
+            fused = true;
+        }
+        else if (b.cols == 1) {
+            gemv(a, b, c, epilogue);
+            fused = true;
+        }
+        else if (a.cols == 1) {
+            outer(a, b, c);
+        }
+        else {
+            blocked(a, b, c, epilogue);
+            fused = true;
+        }
+    }
+
+    if (epilogue != nullptr && !fused) {
+        auto body = [&](size_t rb, size_t re) {
+            applyEpilogue(*epilogue, c, (int)rb, 0, (int)(re - rb), c.getNumCols());
+        };
+        ThreadPool::global().parallelFor(0, c.getNumRows(), (size_t)c.getNumRows() * c.getNumCols() * 4, body);
+    }
+}
+
+/**
+ * @brief Applies an epilogue to a rows x cols block of c
+ */
+template <typename T>
+void Gemm::applyEpilogue(const GemmEpilogue<T>& epilogue, BasicMatrix<T>& c, int row, int col, int rows, int cols) {
+    const int cs = c.getStride();
+    const int bs = epilogue.bias->getStride();
+    T* v = c.rowPtr(row) + col;
+    const T* shift = epilogue.bias->rowPtr(row);
+    for (int i = 0; i < rows; i++) {
+        T* vr = v + (size_t)i * cs;
+        const T b = shift[(size_t)i * bs];
+        for (int j = 0; j < cols; j++) {
+            vr[j] += b;
+        }
+    }
+    if (epilogue.activated == nullptr) {
+        return;
+    }
+
+    // Same kernel as Layer::activateValues, so results match bit for bit
+    const int as = epilogue.activated->getStride();
+    const int ds = epilogue.derived != nullptr ? epilogue.derived->getStride() : 1;
+    T* act = epilogue.activated->rowPtr(row) + col;
+    T* der = epilogue.derived != nullptr ? epilogue.derived->rowPtr(row) + col : nullptr;
+    if (cols == 1 && cs == 1 && as == 1 && ds == 1) {
+        // Contiguous column of a matrix-vector product: one run
+        Activation::apply(epilogue.activation, v, act, der, rows);
+        return;
+    }
+    for (int i = 0; i < rows; i++) {
+        Activation::apply(epilogue.activation, v + (size_t)i * cs, act + (size_t)i * as,
+                          der != nullptr ? der + (size_t)i * ds : der, cols);
+    }
+}
+
+/**
+ * @brief Reference kernel: i-l-k triple loop accumulating into c
+ */
+template <typename T>
+void Gemm::naive(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c) {
+    const int m = a.rows;
+    const int k = a.cols;
+    const int n = b.cols;
+    const size_t bcs = b.colStep;
+
+    auto body = [&](size_t rb, size_t re) {
+        for (int i = (int)rb; i < (int)re; i++) {
+            T* cr = c.rowPtr(i);
+            for (int l = 0; l < k; l++) {
+                const T av = a.at(i, l);
+                const T* br = b.ptr(l, 0);
+                for (int j = 0; j < n; j++) {
+                    cr[j] += av * br[(size_t)j * bcs];
+                }
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, m, 2 * (size_t)m * n * k, body);
+}
+
+/**
+ * @brief Matrix-vector fast path (N == 1): one dot product per row of a
+ *
+ * Four independent partial sums break the floating point dependency chain so the
+ * loop can keep several multiply-adds in flight.
+ */
+template <typename T>
+void Gemm::gemv(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c, const GemmEpilogue<T>* epilogue) {
+    const int m = a.rows;
+    const int k = a.cols;
+    const size_t bs = b.rowStep;
+    const T* x = b.data;
+
+    auto rowBlock = [&](int rb, int re) {
+        for (int i = rb; i < re; i++) {
+            const T* ar = a.ptr(i, 0);
+            T s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            int l = 0;
+            for (; l + 4 <= k; l += 4) {
+                s0 += ar[l] * x[(size_t)l * bs];
+                s1 += ar[l + 1] * x[(size_t)(l + 1) * bs];
+                s2 += ar[l + 2] * x[(size_t)(l + 2) * bs];
+                s3 += ar[l + 3] * x[(size_t)(l + 3) * bs];
+            }
+            for (; l < k; l++) {
+                s0 += ar[l] * x[(size_t)l * bs];
+            }
+            c.at(i, 0) += (s0 + s1) + (s2 + s3);
+        }
+    };
+    // The epilogue runs every GEMV_EPILOGUE_ROWS rows, while they are still in L1
+    auto body = [&](size_t rb, size_t re) {
+        for (int i = (int)rb; i < (int)re; i += GEMV_EPILOGUE_ROWS) {
+            const int end = (int)re - i < GEMV_EPILOGUE_ROWS ? (int)re : i + GEMV_EPILOGUE_ROWS;
+            rowBlock(i, end);
+            if (epilogue != nullptr) {
+                applyEpilogue(*epilogue, c, i, 0, end - i, 1);
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, m, 2 * (size_t)m * k, body);
+}
+
+/**
+ * @brief Matrix-vector fast path for a transposed a (N == 1): c += W^T x for a stored W
+ *
+ * A row of the product is a column of W, so instead of strided dot products each row
+ * of W is streamed once per block of outputs and scaled into GEMV_EPILOGUE_ROWS
+ * accumulators. Every output still sums over l in order, whatever the thread count.
+ */
+template <typename T>
+void Gemm::gemvTransposed(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c,
+                          const GemmEpilogue<T>* epilogue) {
+    const int m = a.rows;
+    const int k = a.cols;
+    const size_t bs = b.rowStep;
+    const T* x = b.data;
+
+    auto body = [&](size_t rb, size_t re) {
+        T acc[GEMV_EPILOGUE_ROWS];
+        for (int i = (int)rb; i < (int)re; i += GEMV_EPILOGUE_ROWS) {
+            const int rows = (int)re - i < GEMV_EPILOGUE_ROWS ? (int)re - i : GEMV_EPILOGUE_ROWS;
+            for (int r = 0; r < rows; r++) {
+                acc[r] = 0.0;
+            }
+            for (int l = 0; l < k; l++) {
+                const T xv = x[(size_t)l * bs];
+                const T* wr = a.ptr(i, l);
+                for (int r = 0; r < rows; r++) {
+                    acc[r] += xv * wr[r];
+                }
+            }
+            for (int r = 0; r < rows; r++) {
+                c.at(i + r, 0) += acc[r];
+            }
+            if (epilogue != nullptr) {
+                applyEpilogue(*epilogue, c, i, 0, rows, 1);
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, m, 2 * (size_t)m * k, body);
+}
+
+/**
+ * @brief Outer-product fast path (K == 1): c[i][j] += a[i] * b[j]
+ */
+template <typename T>
+void Gemm::outer(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c) {
+    const int m = a.rows;
+    const int n = b.cols;
+    const size_t bcs = b.colStep;
+    const T* br = b.data;
+
+    auto body = [&](size_t rb, size_t re) {
+        for (int i = (int)rb; i < (int)re; i++) {
+            const T av = a.at(i, 0);
+            T* cr = c.rowPtr(i);
+            if (bcs == 1) {
+                for (int j = 0; j < n; j++) {
+                    cr[j] += av * br[j];
+                }
+            }
+            else {
+                for (int j = 0; j < n; j++) {
+                    cr[j] += av * br[(size_t)j * bcs];
+                }
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, m, 2 * (size_t)m * n, body);
+}
+
+/**
+ * @brief Packs an mc x kc block of a into MR-row panels, zero padding the last panel
+ *
+ * Within a panel the MR values of each column are stored next to each other, which is
+ * the order the micro-kernel consumes them in.
+ */
+template <typename T>
+void Gemm::packA(const GemmOperand<T>& a, int row, int depth, int rows, int depthLen, int MR, T* dst) {
+    for (int ir = 0; ir < rows; ir += MR) {
+        const int mr = rows - ir < MR ? rows - ir : MR;
+        for (int p = 0; p < depthLen; p++) {
+            for (int r = 0; r < mr; r++) {
+                dst[r] = a.at(row + ir + r, depth + p);
+            }
+            for (int r = mr; r < MR; r++) {
+                dst[r] = 0.0;
+            }
+            dst += MR;
+        }
+    }
+}
+
+/**
+ * @brief Packs a kc x nc panel of b into NR-column slivers, zero padding the last sliver
+ *
+ * A transposed b is walked column by column, which is along its stored rows, and
+ * scattered into the sliver instead.
+ */
+template <typename T>
+void Gemm::packB(const GemmOperand<T>& b, int depth, int col, int depthLen, int cols, int NR, T* dst) {
+    for (int jr = 0; jr < cols; jr += NR) {
+        const int nr = cols - jr < NR ? cols - jr : NR;
+        if (b.colStep == 1) {
+            for (int p = 0; p < depthLen; p++) {
+                const T* src = b.ptr(depth + p, col + jr);
+                for (int j = 0; j < nr; j++) {
+                    dst[j] = src[j];
+                }
+                for (int j = nr; j < NR; j++) {
+                    dst[j] = 0.0;
+                }
+                dst += NR;
+            }
+            continue;
+        }
+        for (int j = 0; j < NR; j++) {
+            if (j < nr) {
+                const T* src = b.ptr(depth, col + jr + j);
+                for (int p = 0; p < depthLen; p++) {
+                    dst[(size_t)p * NR + j] = src[(size_t)p * b.rowStep];
+                }
+            }
+            else {
+                for (int p = 0; p < depthLen; p++) {
+                    dst[(size_t)p * NR + j] = 0.0;
+                }
+            }
+        }
+        dst += (size_t)depthLen * NR;
+    }
+}
+
+/**
+ * @brief Packed, cache-blocked kernel accumulating into c
+ */
+template <typename T>
+void Gemm::blocked(const GemmOperand<T>& a, const GemmOperand<T>& b, BasicMatrix<T>& c, const GemmEpilogue<T>* epilogue) {
+    const int m = a.rows;
+    const int k = a.cols;
+    const int n = b.cols;
+    const int ldc = c.getStride();
+
+    // The tile comes from the instruction set of the host, the blocks are rounded to it
+    const GemmMicroKernel<T> micro = Kernels::ops<T>().gemm;
+    const int MR = micro.rows;
+    const int NR = micro.cols;
+    const int mcBlock = (Gemm::mc + MR - 1) / MR * MR;
+    const int ncBlock = (Gemm::nc + NR - 1) / NR * NR;
+    const int panels = (m + MR - 1) / MR;
+
+    T* bPack = GemmPackBuffers<T>::reserve(packBuffers<T>().b, packBuffers<T>().bSize, (size_t)Gemm::kc * ncBlock);
+
+    for (int jc = 0; jc < n; jc += ncBlock) {
+        const int ncLen = n - jc < ncBlock ? n - jc : ncBlock;
+        for (int pc = 0; pc < k; pc += Gemm::kc) {
+            const int kcLen = k - pc < Gemm::kc ? k - pc : Gemm::kc;
+            // The last depth block completes its tiles of C
+            const bool complete = epilogue != nullptr && pc + kcLen == k;
+            packB(b, pc, jc, kcLen, ncLen, NR, bPack);
+
+            // Threads own disjoint ranges of MR-row panels of C and pack their own A blocks,
+            // so the summation order of every element is the same for any thread count
+            auto body = [&](size_t pb, size_t pe) {
+                T* aPack = GemmPackBuffers<T>::reserve(packBuffers<T>().a, packBuffers<T>().aSize, (size_t)mcBlock * Gemm::kc);
+                const int rowEnd = (int)pe * MR < m ? (int)pe * MR : m;
+
+                for (int ic = (int)pb * MR; ic < rowEnd; ic += mcBlock) {
+                    const int mcLen = rowEnd - ic < mcBlock ? rowEnd - ic : mcBlock;
+                    packA(a, ic, pc, mcLen, kcLen, MR, aPack);
+
+                    // Row panels outermost: the A panel stays in L1 across the B slivers, and
+                    // a finished mr x ncLen panel takes the epilogue while still in cache, one
+                    // activation call per row of the block rather than per NR-wide tile row
+                    for (int ir = 0; ir < mcLen; ir += MR) {
+                        const int mr = mcLen - ir < MR ? mcLen - ir : MR;
+                        for (int jr = 0; jr < ncLen; jr += NR) {
+                            const int nr = ncLen - jr < NR ? ncLen - jr : NR;
+                            micro.kernel(kcLen, aPack + (size_t)ir * kcLen, bPack + (size_t)jr * kcLen,
+                                         c.getData() + (size_t)(ic + ir) * ldc + jc + jr, ldc, mr, nr);
+                        }
+                        if (complete) {
+                            applyEpilogue(*epilogue, c, ic + ir, jc, mr, ncLen);
+                        }
+                    }
+                }
+            };
+            ThreadPool::global().parallelFor(0, panels, 2 * (size_t)m * ncLen * kcLen, body);
+        }
+    }
+}
+
+template void Gemm::multiply(const BasicMatrix<double>&, const BasicMatrix<double>&, BasicMatrix<double>&, bool,
+                             GemmTranspose, GemmTranspose);
+template void Gemm::multiply(const BasicMatrix<float>&, const BasicMatrix<float>&, BasicMatrix<float>&, bool,
+                             GemmTranspose, GemmTranspose);
+template void Gemm::multiplyBiasActivate(const BasicMatrix<double>&, const BasicMatrix<double>&, const BasicMatrix<double>&,
+                                         ActivationType, BasicMatrix<double>&, BasicMatrix<double>*, BasicMatrix<double>*);
+template void Gemm::multiplyBiasActivate(const BasicMatrix<float>&, const BasicMatrix<float>&, const BasicMatrix<float>&,
+                                         ActivationType, BasicMatrix<float>&, BasicMatrix<float>*, BasicMatrix<float>*);
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <cassert>
+
+#include "../include/InferenceModel.hpp"
+#include "../include/Gemm.hpp"
+
+using namespace std;
+
+/**
+ * @brief Copies the weights and biases of a trained network
+ * @param network Network to copy (later training does not affect the model)
+ */
+template <typename T>
+BasicInferenceModel<T>::BasicInferenceModel(BasicNeuralNetwork<T>& network) {
+    this->modelFile = NULL;
+    this->topology = network.getTopology();
+    this->activations = network.getActivations();
+    for (int i = 0; i < this->topology.size() - 1; i++) {
+        this->weights.push_back(new BasicMatrix<T>(*network.getWeightMatrix(i)));
+    }
+    for (int i = 0; i < this->topology.size(); i++) {
+        this->biases.push_back(new BasicMatrix<T>(*network.getBiasMatrix(i)));
+    }
+    this->finishLoad();
+}
+
+/**
+ * @brief Loads a model file
+ * @param path Path to the saved model file
+ */
+template <typename T>
+BasicInferenceModel<T>::BasicInferenceModel(const string& path) {
+    this->modelFile = NULL;
+
+    if (ModelFile::isBinary(path)) {
+        this->modelFile = new ModelFile(path);
+        this->topology = this->modelFile->getTopology();
+        this->activations = this->modelFile->getActivations();
+        for (int i = 0; i < this->topology.size() - 1; i++) {
+            this->weights.push_back(this->modelFile->template weightView<T>(i));
+        }
+        for (int i = 0; i < this->topology.size(); i++) {
+            this->biases.push_back(this->modelFile->template biasView<T>(i));
+        }
+
+        // A file of another dtype was converted into owning matrices
+        if (this->modelFile->getDtype() != this->getDtype()) {
+            delete this->modelFile;
+            this->modelFile = NULL;
+        }
+    }
+    else {
+        // The text format is only parsed by the network, borrow one for the load
+        BasicNeuralNetwork<T> network(path);
+        this->topology = network.getTopology();
+        this->activations = network.getActivations();
+        for (int i = 0; i < this->topology.size() - 1; i++) {
+            this->weights.push_back(new BasicMatrix<T>(*network.getWeightMatrix(i)));
+        }
+        for (int i = 0; i < this->topology.size(); i++) {
+            this->biases.push_back(new BasicMatrix<T>(*network.getBiasMatrix(i)));
+        }
+    }
+    this->finishLoad();
+}
+
+/**
+ * @brief Destructor to clean up memory
+ */
+template <typename T>
+BasicInferenceModel<T>::~BasicInferenceModel() {
+    for (int i = 0; i < this->weights.size(); i++) {
+        delete this->weights.at(i);
+    }
+    for (int i = 0; i < this->biases.size(); i++) {
+        delete this->biases.at(i);
+    }
+    delete this->modelFile;
+}
+
+/**
+ * @brief Sets up the topology bookkeeping once the weights are in place
+ */
+template <typename T>
+void BasicInferenceModel<T>::finishLoad() {
+    if (this->topology.size() < 2) {
+        cerr << "Inference model needs at least an input and an output layer!." << endl;
+        assert(false);
+    }
+
+    this->widestHidden = 0;
+    for (int i = 1; i < this->topology.size() - 1; i++) {
+        this->widestHidden = max(this->widestHidden, this->topology.at(i));
+    }
+}
+
+/**
+ * @brief Runs one sample through the network
+ * @param input Input values, getInputSize() of them
+ * @param output Receives getOutputSize() raw output values
+ * @param scratch Caller buffer of at least getScratchSize() values
+ */
+template <typename T>
+void BasicInferenceModel<T>::predict(const T* input, T* output, T* scratch) const {
+    // The input view is only ever read
+    const BasicMatrix<T> in(const_cast<T*>(input), this->getInputSize(), 1, 1);
+    BasicMatrix<T> out(output, this->getOutputSize(), 1, 1);
+    this->forward(in, out, scratch);
+}
+
+/**
+ * @brief Runs a batch of samples through the network, one sample per column
+ * @param inputs Input values (getInputSize() x count), may be a view
+ * @param outputs Receives the raw outputs (getOutputSize() x count), may be a view
+ * @param scratch Caller buffer of at least getScratchSize(count) values
+ */
+template <typename T>
+void BasicInferenceModel<T>::predictBatch(const BasicMatrix<T>& inputs, BasicMatrix<T>& outputs, T* scratch) const {
+    if (inputs.getNumRows() != this->getInputSize() || outputs.getNumRows() != this->getOutputSize()
+        || inputs.getNumCols() != outputs.getNumCols()) {
+        cerr << "Batch of " << inputs.getNumRows() << "x" << inputs.getNumCols() << " inputs and "
+             << outputs.getNumRows() << "x" << outputs.getNumCols() << " outputs does not fit the model" << endl;
+        assert(false);
+    }
+
+    this->forward(inputs, outputs, scratch);
+}
+
+/**
+ * @brief Forward pass from input to output columns
+ * @param input Input layer values (one column per sample)
+ * @param output Receives the raw output values
+ * @param scratch Two hidden-layer buffers of widestHidden x count values
+ */
+template <typename T>
+void BasicInferenceModel<T>::forward(const BasicMatrix<T>& input, BasicMatrix<T>& output, T* scratch) const {
+    const int count = input.getNumCols();
+    const int last = this->topology.size() - 2;
+    const size_t half = (size_t)this->widestHidden * count;
+
+    for (int i = 0; i <= last; i++) {
+        // Hidden layers ping-pong between the two halves of the scratch buffer
+        BasicMatrix<T> previous(scratch + ((i + 1) % 2) * half, this->topology.at(i), count, count);
+        BasicMatrix<T> hidden(scratch + (i % 2) * half, this->topology.at(i + 1), count, count);
+        const BasicMatrix<T>& in = i == 0 ? input : previous;
+        BasicMatrix<T>& out = i == last ? output : hidden;
+
+        // Hidden layers are activated in place, without derivatives
+        BasicMatrix<T>* activated = i != last ? &out : NULL;
+        BasicMatrix<T>* derived = NULL;
+        Gemm::multiplyBiasActivate(*this->weights.at(i), in, *this->biases.at(i + 1), this->activations.at(i + 1),
+                                   out, activated, derived);
+    }
+}
+
+template class BasicInferenceModel<double>;
+template class BasicInferenceModel<float>;
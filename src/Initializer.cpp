@@ -0,0 +1,201 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+#include "../include/Initializer.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+// Philox4x32 multipliers and Weyl key increments (Salmon et al., 2011)
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+static atomic<uint64_t> globalSeed(INIT_DEFAULT_SEED);
+static atomic<uint64_t> globalCounter(0);
+
+/**
+ * @brief Generates one block of random bits
+ * @param stream Independent sequence, e.g. the index of a matrix
+ * @param counter Block index within the stream
+ * @param out Receives four random 32-bit words
+ */
+void Philox::block(uint64_t stream, uint64_t counter, uint32_t out[4]) const {
+    uint32_t c0 = (uint32_t)counter;
+    uint32_t c1 = (uint32_t)(counter >> 32);
+    uint32_t c2 = (uint32_t)stream;
+    uint32_t c3 = (uint32_t)(stream >> 32);
+    uint32_t k0 = (uint32_t)this->key;
+    uint32_t k1 = (uint32_t)(this->key >> 32);
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        const uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        const uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+/**
+ * @brief Fills a matrix with uniform values
+ * @param m Matrix to fill
+ * @param low Lower bound
+ * @param high Upper bound (exclusive)
+ * @param seed Seed
+ * @param stream Independent sequence under the seed
+ */
+template <typename T>
+void Initializer::uniform(BasicMatrix<T>& m, double low, double high, uint64_t seed, uint64_t stream) {
+    const Philox philox(seed);
+    const int cols = m.getNumCols();
+    const double scale = high - low;
+
+    auto body = [&](size_t b, size_t e) {
+        uint32_t bits[4];
+        for (size_t r = b; r < e; r++) {
+            T* row = m.rowPtr((int)r);
+            for (int c = 0; c < cols; c++) {
+                const uint64_t i = (uint64_t)r * cols + c;
+                if (c == 0 || i % 4 == 0) {
+                    philox.block(stream, i / 4, bits);
+                }
+                row[c] = (T)(low + scale * Philox::unit(bits[i % 4]));
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, m.getNumRows(), (size_t)m.getNumRows() * cols * 16, body);
+}
+
+/**
+ * @brief Fills a matrix with normally distributed values (Box-Muller)
+ * @param m Matrix to fill
+ * @param mean Mean
+ * @param stddev Standard deviation
+ * @param seed Seed
+ * @param stream Independent sequence under the seed
+ */
+template <typename T>
+void Initializer::normal(BasicMatrix<T>& m, double mean, double stddev, uint64_t seed, uint64_t stream) {
+    const Philox philox(seed);
+    const int cols = m.getNumCols();
+    const double twoPi = 2.0 * acos(-1.0);
+
+    auto body = [&](size_t b, size_t e) {
+        uint32_t bits[4];
+        double first = 0.0;
+        double second = 0.0;
+        for (size_t r = b; r < e; r++) {
+            T* row = m.rowPtr((int)r);
+            for (int c = 0; c < cols; c++) {
+                const uint64_t i = (uint64_t)r * cols + c;
+                if (c == 0 || i % 4 == 0) {
+                    philox.block(stream, i / 4, bits);
+                }
+                // Elements 2j and 2j + 1 share pair j of words (the two halves of a block) and
+                // take the cosine and the sine of one Box-Muller transform. A row starting at
+                // an odd element recomputes its pair, so values never depend on the row split
+                if (c == 0 || i % 2 == 0) {
+                    const uint32_t* pair = bits + 2 * (i / 2 % 2);
+                    const double radius = stddev * sqrt(-2.0 * log(Philox::unit(pair[0])));
+                    const double angle = twoPi * Philox::unit(pair[1]);
+                    first = radius * cos(angle);
+                    second = radius * sin(angle);
+                }
+                row[c] = (T)(mean + (i % 2 == 0 ? first : second));
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, m.getNumRows(), (size_t)m.getNumRows() * cols * 32, body);
+}
+
+/**
+ * @brief Fills a weight matrix with a scheme
+ * @param weights fanOut x fanIn weight matrix
+ * @param scheme Initialization scheme
+ * @param seed Seed
+ * @param stream Independent sequence under the seed, e.g. the layer index
+ */
+template <typename T>
+void Initializer::initialize(BasicMatrix<T>& weights, InitScheme scheme, uint64_t seed, uint64_t stream) {
+    const double fanIn = weights.getNumCols();
+    const double fanOut = weights.getNumRows();
+
+    switch (scheme) {
+        case INIT_UNIFORM:
+            Initializer::uniform(weights, 0.0, 1.0, seed, stream);
+            break;
+        case INIT_XAVIER_UNIFORM: {
+            const double limit = sqrt(6.0 / (fanIn + fanOut));
+            Initializer::uniform(weights, -limit, limit, seed, stream);
+            break;
+        }
+        case INIT_XAVIER_NORMAL:
+            Initializer::normal(weights, 0.0, sqrt(2.0 / (fanIn + fanOut)), seed, stream);
+            break;
+        case INIT_HE_UNIFORM: {
+            const double limit = sqrt(6.0 / fanIn);
+            Initializer::uniform(weights, -limit, limit, seed, stream);
+            break;
+        }
+        case INIT_HE_NORMAL:
+            Initializer::normal(weights, 0.0, sqrt(2.0 / fanIn), seed, stream);
+            break;
+        default:
+            cerr << "Unknown initialization scheme " << scheme << endl;
+            assert(false);
+    }
+}
+
+/**
+ * @brief Restarts the global seed sequence
+ * @param seed Seed of the sequence
+ */
+void Initializer::setSeed(uint64_t seed) {
+    globalSeed = seed;
+    globalCounter = 0;
+}
+
+/**
+ * @brief Draws the next seed of the global sequence, thread-safe
+ * @return Seed
+ */
+uint64_t Initializer::nextSeed() {
+    uint32_t bits[4];
+    Philox(globalSeed).block(0, globalCounter++, bits);
+    return ((uint64_t)bits[1] << 32) | bits[0];
+}
+
+/**
+ * @brief Gets the printable name of a scheme
+ * @param scheme Initialization scheme
+ * @return Name such as "he_normal"
+ */
+const char* Initializer::getName(InitScheme scheme) {
+    switch (scheme) {
+        case INIT_UNIFORM: return "uniform";
+        case INIT_XAVIER_UNIFORM: return "xavier_uniform";
+        case INIT_XAVIER_NORMAL: return "xavier_normal";
+        case INIT_HE_UNIFORM: return "he_uniform";
+        case INIT_HE_NORMAL: return "he_normal";
+    }
+    return "unknown";
+}
+
+template void Initializer::uniform(Matrix&, double, double, uint64_t, uint64_t);
+template void Initializer::uniform(MatrixF&, double, double, uint64_t, uint64_t);
+template void Initializer::normal(Matrix&, double, double, uint64_t, uint64_t);
+template void Initializer::normal(MatrixF&, double, double, uint64_t, uint64_t);
+template void Initializer::initialize(Matrix&, InitScheme, uint64_t, uint64_t);
+template void Initializer::initialize(MatrixF&, InitScheme, uint64_t, uint64_t);
@@ -0,0 +1,248 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "../include/Kernels.hpp"
+#include "../include/ActivationKernels.hpp"
+#include "../include/GemmKernels.hpp"
+#include "../include/OptimizerKernels.hpp"
+
+using namespace std;
+
+#if defined(NN_X86_KERNELS)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+template <typename T>
+static void scalarAdd(const T* a, const T* b, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+template <typename T>
+static void scalarSub(const T* a, const T* b, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+template <typename T>
+static void scalarMul(const T* a, const T* b, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+template <typename T>
+static void scalarAxpy(T alpha, const T* x, T* y, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+template <typename T>
+static void scalarScale(T alpha, T* x, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+template <typename T>
+static void scalarSubScaled(const T* a, const T* b, T scalar, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] - scalar * b[i];
+    }
+}
+
+static void scalarGemvInt8(const int8_t* a, const int8_t* x, int32_t* y, size_t rows, size_t cols, size_t stride) {
+    for (size_t r = 0; r < rows; r++) {
+        const int8_t* row = a + r * stride;
+        int32_t sum = 0;
+        for (size_t c = 0; c < cols; c++) {
+            sum += (int32_t)row[c] * x[c];
+        }
+        y[r] = sum;
+    }
+}
+
+/**
+ * @brief One-lane "register" operations, so the scalar table shares the vector kernels
+ */
+template <typename T>
+struct Scalar {
+    typedef T V;
+    typedef bool Mask;
+    static const size_t width = 1;
+    static NN_ALWAYS_INLINE V load(const T* p) { return *p; }
+    static NN_ALWAYS_INLINE void store(T* p, V v) { *p = v; }
+    static NN_ALWAYS_INLINE V set1(T a) { return a; }
+    static NN_ALWAYS_INLINE V add(V a, V b) { return a + b; }
+    static NN_ALWAYS_INLINE V sub(V a, V b) { return a - b; }
+    static NN_ALWAYS_INLINE V mul(V a, V b) { return a * b; }
+    static NN_ALWAYS_INLINE V div(V a, V b) { return a / b; }
+    static NN_ALWAYS_INLINE V sqrt(V a) { return std::sqrt(a); }
+    static NN_ALWAYS_INLINE V min(V a, V b) { return a < b ? a : b; }
+    static NN_ALWAYS_INLINE V max(V a, V b) { return a > b ? a : b; }
+    static NN_ALWAYS_INLINE V abs(V a) { return a < 0 ? -a : a; }
+    /// a * b + c
+    static NN_ALWAYS_INLINE V fmadd(V a, V b, V c) { return a * b + c; }
+    /// c - a * b
+    static NN_ALWAYS_INLINE V fnmadd(V a, V b, V c) { return c - a * b; }
+    /// |magnitude| with the sign of sign
+    static NN_ALWAYS_INLINE V copySign(V magnitude, V sign) { return sign < 0 ? -abs(magnitude) : abs(magnitude); }
+    static NN_ALWAYS_INLINE Mask greater(V a, V b) { return a > b; }
+    /// m ? a : b
+    static NN_ALWAYS_INLINE V select(Mask m, V a, V b) { return m ? a : b; }
+    /// 2^n from t = n + 1.5 * 2^52 (2^23 for float)
+    static NN_ALWAYS_INLINE V pow2(V t) {
+        typedef typename conditional<sizeof(T) == sizeof(uint64_t), uint64_t, uint32_t>::type Bits;
+        const bool wide = sizeof(T) == sizeof(uint64_t);
+        Bits bits;
+        memcpy(&bits, &t, sizeof(t));
+        bits = (bits + (wide ? 1023 : 127)) << (wide ? 52 : 23);
+        memcpy(&t, &bits, sizeof(t));
+        return t;
+    }
+};
+
+static const KernelTable scalarTable = {
+    ISA_SCALAR, "scalar",
+    { scalarAdd<double>, scalarSub<double>, scalarMul<double>, scalarAxpy<double>, scalarScale<double>, scalarSubScaled<double>,
+      ActivationKernels<Scalar<double>, double>::activate, OptimizerKernels<Scalar<double>, double>::optimize,
+      GemmKernels<Scalar<double>, double, 4, 8>::entry() },
+    { scalarAdd<float>, scalarSub<float>, scalarMul<float>, scalarAxpy<float>, scalarScale<float>, scalarSubScaled<float>,
+      ActivationKernels<Scalar<float>, float>::activate, OptimizerKernels<Scalar<float>, float>::optimize,
+      GemmKernels<Scalar<float>, float, 4, 8>::entry() },
+    scalarGemvInt8
+};
+
+#if defined(NN_X86_KERNELS)
+/**
+ * @brief Executes cpuid for a leaf/subleaf
+ * @param regs Receives eax, ebx, ecx, edx
+ */
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) {
+        regs[i] = (unsigned int)r[i];
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/**
+ * @brief Reads XCR0 to learn which register files the OS saves on context switch
+ */
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+/**
+ * @brief Gets the best instruction set supported by this host and binary
+ * @return Detected instruction set
+ */
+KernelIsa Kernels::detect() {
+#if defined(NN_X86_KERNELS)
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    const unsigned int maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    const bool sse2 = (regs[3] >> 26) & 1;
+    const bool osxsave = (regs[2] >> 27) & 1;
+    const bool avx = (regs[2] >> 28) & 1;
+    const bool fma = (regs[2] >> 12) & 1;
+
+    bool avx2 = false;
+    bool avx512 = false;
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        avx2 = (regs[1] >> 5) & 1;
+        avx512 = (regs[1] >> 16) & 1;
+    }
+
+    // The CPU flags only say the instructions exist; XCR0 says the OS preserves the
+    // YMM (bits 1-2) and opmask/ZMM (bits 5-7) state, without which they are unusable.
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    const bool osYmm = (xcr0 & 0x6) == 0x6;
+    const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+
+    if (avx512 && osZmm) {
+        return ISA_AVX512;
+    }
+    if (avx && avx2 && fma && osYmm) {
+        return ISA_AVX2;
+    }
+    if (sse2) {
+        return ISA_SSE2;
+    }
+#endif
+    return ISA_SCALAR;
+}
+
+/**
+ * @brief Gets the kernel table for an instruction set
+ * @param isa Instruction set
+ * @return Table, or nullptr if not compiled into this binary
+ */
+const KernelTable* Kernels::table(KernelIsa isa) {
+    switch (isa) {
+        case ISA_SCALAR: return &scalarTable;
+#if defined(NN_X86_KERNELS)
+        case ISA_SSE2: return getSse2KernelTable();
+        case ISA_AVX2: return getAvx2KernelTable();
+        case ISA_AVX512: return getAvx512KernelTable();
+#else
+        default: break;
+#endif
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Checks whether an instruction set can be used on this host
+ * @param isa Instruction set to check
+ * @return True if the kernels for isa are compiled in and the CPU supports them
+ */
+bool Kernels::isSupported(KernelIsa isa) {
+    return table(isa) != nullptr && isa <= detect();
+}
+
+/**
+ * @brief Forces a specific instruction set, e.g. to compare kernels
+ * @param isa Instruction set to use; ignored (returns false) if unsupported
+ * @return True if the instruction set was selected
+ */
+bool Kernels::setIsa(KernelIsa isa) {
+    if (!isSupported(isa)) {
+        return false;
+    }
+    Kernels::active() = table(isa);
+
+    return true;
+}
+
+/**
+ * @brief Gets the active table, detecting the host on first use
+ * @return Active kernel table
+ */
+const KernelTable*& Kernels::active() {
+    static const KernelTable* selected = table(detect());
+    return selected;
+}
@@ -0,0 +1,232 @@
+#include <immintrin.h>
+
+#include "../include/Kernels.hpp"
+#include "../include/ActivationKernels.hpp"
+#include "../include/GemmKernels.hpp"
+#include "../include/OptimizerKernels.hpp"
+
+// AVX2 + FMA kernels: four doubles or eight floats per register, two registers per
+// iteration to hide load latency, scalar tail.
+
+/**
+ * @brief 256-bit register operations for one element type
+ */
+template <typename T>
+struct Avx2;
+
+template <>
+struct Avx2<double> {
+    typedef __m256d V;
+    typedef __m256d Mask;
+    static const size_t width = 4;
+    static NN_ALWAYS_INLINE V load(const double* p) { return _mm256_loadu_pd(p); }
+    static NN_ALWAYS_INLINE void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static NN_ALWAYS_INLINE V set1(double a) { return _mm256_set1_pd(a); }
+    static NN_ALWAYS_INLINE V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static NN_ALWAYS_INLINE V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static NN_ALWAYS_INLINE V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    /// a * b + c
+    static NN_ALWAYS_INLINE V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+    /// c - a * b
+    static NN_ALWAYS_INLINE V fnmadd(V a, V b, V c) { return _mm256_fnmadd_pd(a, b, c); }
+    static NN_ALWAYS_INLINE V div(V a, V b) { return _mm256_div_pd(a, b); }
+    static NN_ALWAYS_INLINE V sqrt(V a) { return _mm256_sqrt_pd(a); }
+    static NN_ALWAYS_INLINE V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static NN_ALWAYS_INLINE V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static NN_ALWAYS_INLINE V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    /// |magnitude| with the sign of sign
+    static NN_ALWAYS_INLINE V copySign(V magnitude, V sign) {
+        const V s = _mm256_set1_pd(-0.0);
+        return _mm256_or_pd(_mm256_andnot_pd(s, magnitude), _mm256_and_pd(s, sign));
+    }
+    static NN_ALWAYS_INLINE Mask greater(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    /// m ? a : b per lane
+    static NN_ALWAYS_INLINE V select(Mask m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+    /// 2^n from t = n + 1.5 * 2^52
+    static NN_ALWAYS_INLINE V pow2(V t) {
+        return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_castpd_si256(t), _mm256_set1_epi64x(1023)), 52));
+    }
+};
+
+template <>
+struct Avx2<float> {
+    typedef __m256 V;
+    typedef __m256 Mask;
+    static const size_t width = 8;
+    static NN_ALWAYS_INLINE V load(const float* p) { return _mm256_loadu_ps(p); }
+    static NN_ALWAYS_INLINE void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static NN_ALWAYS_INLINE V set1(float a) { return _mm256_set1_ps(a); }
+    static NN_ALWAYS_INLINE V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static NN_ALWAYS_INLINE V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static NN_ALWAYS_INLINE V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    /// a * b + c
+    static NN_ALWAYS_INLINE V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    /// c - a * b
+    static NN_ALWAYS_INLINE V fnmadd(V a, V b, V c) { return _mm256_fnmadd_ps(a, b, c); }
+    static NN_ALWAYS_INLINE V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static NN_ALWAYS_INLINE V sqrt(V a) { return _mm256_sqrt_ps(a); }
+    static NN_ALWAYS_INLINE V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static NN_ALWAYS_INLINE V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static NN_ALWAYS_INLINE V abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    /// |magnitude| with the sign of sign
+    static NN_ALWAYS_INLINE V copySign(V magnitude, V sign) {
+        const V s = _mm256_set1_ps(-0.0f);
+        return _mm256_or_ps(_mm256_andnot_ps(s, magnitude), _mm256_and_ps(s, sign));
+    }
+    static NN_ALWAYS_INLINE Mask greater(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    /// m ? a : b per lane
+    static NN_ALWAYS_INLINE V select(Mask m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    /// 2^n from t = n + 1.5 * 2^23
+    static NN_ALWAYS_INLINE V pow2(V t) {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_castps_si256(t), _mm256_set1_epi32(127)), 23));
+    }
+};
+
+template <typename T>
+static void avx2Add(const T* a, const T* b, T* out, size_t n) {
+    typedef Avx2<T> S;
+    const size_t w = S::width;
+    size_t i = 0;
+    for (; i + 2 * w <= n; i += 2 * w) {
+        S::store(out + i, S::add(S::load(a + i), S::load(b + i)));
+        S::store(out + i + w, S::add(S::load(a + i + w), S::load(b + i + w)));
+    }
+    for (; i + w <= n; i += w) {
+        S::store(out + i, S::add(S::load(a + i), S::load(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+template <typename T>
+static void avx2Sub(const T* a, const T* b, T* out, size_t n) {
+    typedef Avx2<T> S;
+    const size_t w = S::width;
+    size_t i = 0;
+    for (; i + 2 * w <= n; i += 2 * w) {
+        S::store(out + i, S::sub(S::load(a + i), S::load(b + i)));
+        S::store(out + i + w, S::sub(S::load(a + i + w), S::load(b + i + w)));
+    }
+    for (; i + w <= n; i += w) {
+        S::store(out + i, S::sub(S::load(a + i), S::load(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+template <typename T>
+static void avx2Mul(const T* a, const T* b, T* out, size_t n) {
+    typedef Avx2<T> S;
+    const size_t w = S::width;
+    size_t i = 0;
+    for (; i + 2 * w <= n; i += 2 * w) {
+        S::store(out + i, S::mul(S::load(a + i), S::load(b + i)));
+        S::store(out + i + w, S::mul(S::load(a + i + w), S::load(b + i + w)));
+    }
+    for (; i + w <= n; i += w) {
+        S::store(out + i, S::mul(S::load(a + i), S::load(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+template <typename T>
+static void avx2Axpy(T alpha, const T* x, T* y, size_t n) {
+    typedef Avx2<T> S;
+    const size_t w = S::width;
+    const typename S::V va = S::set1(alpha);
+    size_t i = 0;
+    for (; i + 2 * w <= n; i += 2 * w) {
+        S::store(y + i, S::fmadd(va, S::load(x + i), S::load(y + i)));
+        S::store(y + i + w, S::fmadd(va, S::load(x + i + w), S::load(y + i + w)));
+    }
+    for (; i + w <= n; i += w) {
+        S::store(y + i, S::fmadd(va, S::load(x + i), S::load(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+template <typename T>
+static void avx2Scale(T alpha, T* x, size_t n) {
+    typedef Avx2<T> S;
+    const typename S::V va = S::set1(alpha);
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(x + i, S::mul(va, S::load(x + i)));
+    }
+    for (; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+template <typename T>
+static void avx2SubScaled(const T* a, const T* b, T scalar, T* out, size_t n) {
+    typedef Avx2<T> S;
+    const size_t w = S::width;
+    const typename S::V vs = S::set1(scalar);
+    size_t i = 0;
+    for (; i + 2 * w <= n; i += 2 * w) {
+        S::store(out + i, S::fnmadd(vs, S::load(b + i), S::load(a + i)));
+        S::store(out + i + w, S::fnmadd(vs, S::load(b + i + w), S::load(a + i + w)));
+    }
+    for (; i + w <= n; i += w) {
+        S::store(out + i, S::fnmadd(vs, S::load(b + i), S::load(a + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] - scalar * b[i];
+    }
+}
+
+/**
+ * @brief Multiplies sixteen int8 pairs and sums adjacent products into eight int32 lanes
+ */
+static NN_ALWAYS_INLINE __m256i avx2MaddInt8(const int8_t* a, const int8_t* x) {
+    __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+    __m256i vx = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+    return _mm256_madd_epi16(va, vx);
+}
+
+static void avx2GemvInt8(const int8_t* a, const int8_t* x, int32_t* y, size_t rows, size_t cols, size_t stride) {
+    for (size_t r = 0; r < rows; r++) {
+        const int8_t* row = a + r * stride;
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        size_t c = 0;
+        for (; c + 32 <= cols; c += 32) {
+            acc0 = _mm256_add_epi32(acc0, avx2MaddInt8(row + c, x + c));
+            acc1 = _mm256_add_epi32(acc1, avx2MaddInt8(row + c + 16, x + c + 16));
+        }
+        for (; c + 16 <= cols; c += 16) {
+            acc0 = _mm256_add_epi32(acc0, avx2MaddInt8(row + c, x + c));
+        }
+        __m256i acc = _mm256_add_epi32(acc0, acc1);
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+        int32_t sum = _mm_cvtsi128_si32(s);
+        for (; c < cols; c++) {
+            sum += (int32_t)row[c] * x[c];
+        }
+        y[r] = sum;
+    }
+}
+
+static const KernelTable avx2Table = {
+    ISA_AVX2, "avx2",
+    { avx2Add<double>, avx2Sub<double>, avx2Mul<double>, avx2Axpy<double>, avx2Scale<double>, avx2SubScaled<double>,
+      ActivationKernels<Avx2<double>, double>::activate, OptimizerKernels<Avx2<double>, double>::optimize,
+      GemmKernels<Avx2<double>, double, 6, 2>::entry() },
+    { avx2Add<float>, avx2Sub<float>, avx2Mul<float>, avx2Axpy<float>, avx2Scale<float>, avx2SubScaled<float>,
+      ActivationKernels<Avx2<float>, float>::activate, OptimizerKernels<Avx2<float>, float>::optimize,
+      GemmKernels<Avx2<float>, float, 6, 2>::entry() },
+    avx2GemvInt8
+};
+
+const KernelTable* getAvx2KernelTable() {
+    return &avx2Table;
+}
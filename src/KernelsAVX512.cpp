@@ -0,0 +1,220 @@
+#include <immintrin.h>
+
+#include "../include/Kernels.hpp"
+#include "../include/ActivationKernels.hpp"
+#include "../include/GemmKernels.hpp"
+#include "../include/OptimizerKernels.hpp"
+
+// AVX-512F kernels: eight doubles or sixteen floats per register, the tail handled with
+// a masked load/store instead of a scalar loop.
+
+/**
+ * @brief 512-bit register operations for one element type
+ */
+template <typename T>
+struct Avx512;
+
+template <>
+struct Avx512<double> {
+    typedef __m512d V;
+    typedef __mmask8 Mask;
+    static const size_t width = 8;
+    static NN_ALWAYS_INLINE Mask tail(size_t remaining) { return (Mask)((1u << remaining) - 1); }
+    static NN_ALWAYS_INLINE V load(const double* p) { return _mm512_loadu_pd(p); }
+    static NN_ALWAYS_INLINE V load(Mask m, const double* p) { return _mm512_maskz_loadu_pd(m, p); }
+    static NN_ALWAYS_INLINE void store(double* p, V v) { _mm512_storeu_pd(p, v); }
+    static NN_ALWAYS_INLINE void store(double* p, Mask m, V v) { _mm512_mask_storeu_pd(p, m, v); }
+    static NN_ALWAYS_INLINE V set1(double a) { return _mm512_set1_pd(a); }
+    static NN_ALWAYS_INLINE V add(V a, V b) { return _mm512_add_pd(a, b); }
+    static NN_ALWAYS_INLINE V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+    static NN_ALWAYS_INLINE V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+    /// a * b + c
+    static NN_ALWAYS_INLINE V fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+    /// c - a * b
+    static NN_ALWAYS_INLINE V fnmadd(V a, V b, V c) { return _mm512_fnmadd_pd(a, b, c); }
+    static NN_ALWAYS_INLINE V div(V a, V b) { return _mm512_div_pd(a, b); }
+    static NN_ALWAYS_INLINE V sqrt(V a) { return _mm512_sqrt_pd(a); }
+    static NN_ALWAYS_INLINE V min(V a, V b) { return _mm512_min_pd(a, b); }
+    static NN_ALWAYS_INLINE V max(V a, V b) { return _mm512_max_pd(a, b); }
+    static NN_ALWAYS_INLINE V abs(V a) { return _mm512_abs_pd(a); }
+    /// |magnitude| with the sign of sign (integer logic, the float forms need AVX-512DQ)
+    static NN_ALWAYS_INLINE V copySign(V magnitude, V sign) {
+        const __m512i s = _mm512_set1_epi64((long long)0x8000000000000000ull);
+        return _mm512_castsi512_pd(_mm512_or_si512(_mm512_andnot_si512(s, _mm512_castpd_si512(magnitude)),
+                                                   _mm512_and_si512(s, _mm512_castpd_si512(sign))));
+    }
+    static NN_ALWAYS_INLINE Mask greater(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    /// m ? a : b per lane
+    static NN_ALWAYS_INLINE V select(Mask m, V a, V b) { return _mm512_mask_blend_pd(m, b, a); }
+    /// 2^n from t = n + 1.5 * 2^52
+    static NN_ALWAYS_INLINE V pow2(V t) {
+        return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(_mm512_castpd_si512(t), _mm512_set1_epi64(1023)), 52));
+    }
+};
+
+template <>
+struct Avx512<float> {
+    typedef __m512 V;
+    typedef __mmask16 Mask;
+    static const size_t width = 16;
+    static NN_ALWAYS_INLINE Mask tail(size_t remaining) { return (Mask)((1u << remaining) - 1); }
+    static NN_ALWAYS_INLINE V load(const float* p) { return _mm512_loadu_ps(p); }
+    static NN_ALWAYS_INLINE V load(Mask m, const float* p) { return _mm512_maskz_loadu_ps(m, p); }
+    static NN_ALWAYS_INLINE void store(float* p, V v) { _mm512_storeu_ps(p, v); }
+    static NN_ALWAYS_INLINE void store(float* p, Mask m, V v) { _mm512_mask_storeu_ps(p, m, v); }
+    static NN_ALWAYS_INLINE V set1(float a) { return _mm512_set1_ps(a); }
+    static NN_ALWAYS_INLINE V add(V a, V b) { return _mm512_add_ps(a, b); }
+    static NN_ALWAYS_INLINE V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+    static NN_ALWAYS_INLINE V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+    /// a * b + c
+    static NN_ALWAYS_INLINE V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+    /// c - a * b
+    static NN_ALWAYS_INLINE V fnmadd(V a, V b, V c) { return _mm512_fnmadd_ps(a, b, c); }
+    static NN_ALWAYS_INLINE V div(V a, V b) { return _mm512_div_ps(a, b); }
+    static NN_ALWAYS_INLINE V sqrt(V a) { return _mm512_sqrt_ps(a); }
+    static NN_ALWAYS_INLINE V min(V a, V b) { return _mm512_min_ps(a, b); }
+    static NN_ALWAYS_INLINE V max(V a, V b) { return _mm512_max_ps(a, b); }
+    static NN_ALWAYS_INLINE V abs(V a) { return _mm512_abs_ps(a); }
+    /// |magnitude| with the sign of sign (integer logic, the float forms need AVX-512DQ)
+    static NN_ALWAYS_INLINE V copySign(V magnitude, V sign) {
+        const __m512i s = _mm512_set1_epi32((int)0x80000000u);
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_andnot_si512(s, _mm512_castps_si512(magnitude)),
+                                                   _mm512_and_si512(s, _mm512_castps_si512(sign))));
+    }
+    static NN_ALWAYS_INLINE Mask greater(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    /// m ? a : b per lane
+    static NN_ALWAYS_INLINE V select(Mask m, V a, V b) { return _mm512_mask_blend_ps(m, b, a); }
+    /// 2^n from t = n + 1.5 * 2^23
+    static NN_ALWAYS_INLINE V pow2(V t) {
+        return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_castps_si512(t), _mm512_set1_epi32(127)), 23));
+    }
+};
+
+template <typename T>
+static void avx512Add(const T* a, const T* b, T* out, size_t n) {
+    typedef Avx512<T> S;
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::add(S::load(a + i), S::load(b + i)));
+    }
+    if (i < n) {
+        const typename S::Mask m = S::tail(n - i);
+        S::store(out + i, m, S::add(S::load(m, a + i), S::load(m, b + i)));
+    }
+}
+
+template <typename T>
+static void avx512Sub(const T* a, const T* b, T* out, size_t n) {
+    typedef Avx512<T> S;
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::sub(S::load(a + i), S::load(b + i)));
+    }
+    if (i < n) {
+        const typename S::Mask m = S::tail(n - i);
+        S::store(out + i, m, S::sub(S::load(m, a + i), S::load(m, b + i)));
+    }
+}
+
+template <typename T>
+static void avx512Mul(const T* a, const T* b, T* out, size_t n) {
+    typedef Avx512<T> S;
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::mul(S::load(a + i), S::load(b + i)));
+    }
+    if (i < n) {
+        const typename S::Mask m = S::tail(n - i);
+        S::store(out + i, m, S::mul(S::load(m, a + i), S::load(m, b + i)));
+    }
+}
+
+template <typename T>
+static void avx512Axpy(T alpha, const T* x, T* y, size_t n) {
+    typedef Avx512<T> S;
+    const typename S::V va = S::set1(alpha);
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(y + i, S::fmadd(va, S::load(x + i), S::load(y + i)));
+    }
+    if (i < n) {
+        const typename S::Mask m = S::tail(n - i);
+        S::store(y + i, m, S::fmadd(va, S::load(m, x + i), S::load(m, y + i)));
+    }
+}
+
+template <typename T>
+static void avx512Scale(T alpha, T* x, size_t n) {
+    typedef Avx512<T> S;
+    const typename S::V va = S::set1(alpha);
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(x + i, S::mul(va, S::load(x + i)));
+    }
+    if (i < n) {
+        const typename S::Mask m = S::tail(n - i);
+        S::store(x + i, m, S::mul(va, S::load(m, x + i)));
+    }
+}
+
+template <typename T>
+static void avx512SubScaled(const T* a, const T* b, T scalar, T* out, size_t n) {
+    typedef Avx512<T> S;
+    const typename S::V vs = S::set1(scalar);
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::fnmadd(vs, S::load(b + i), S::load(a + i)));
+    }
+    if (i < n) {
+        const typename S::Mask m = S::tail(n - i);
+        S::store(out + i, m, S::fnmadd(vs, S::load(m, b + i), S::load(m, a + i)));
+    }
+}
+
+/**
+ * @brief Multiplies sixteen int8 pairs into sixteen int32 lanes
+ *
+ * AVX-512F has no 16-bit multiply-add (that is AVX-512BW), so the bytes are widened
+ * straight to int32.
+ */
+static NN_ALWAYS_INLINE __m512i avx512MulInt8(const int8_t* a, const int8_t* x) {
+    __m512i va = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+    __m512i vx = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+    return _mm512_mullo_epi32(va, vx);
+}
+
+static void avx512GemvInt8(const int8_t* a, const int8_t* x, int32_t* y, size_t rows, size_t cols, size_t stride) {
+    for (size_t r = 0; r < rows; r++) {
+        const int8_t* row = a + r * stride;
+        __m512i acc0 = _mm512_setzero_si512();
+        __m512i acc1 = _mm512_setzero_si512();
+        size_t c = 0;
+        for (; c + 32 <= cols; c += 32) {
+            acc0 = _mm512_add_epi32(acc0, avx512MulInt8(row + c, x + c));
+            acc1 = _mm512_add_epi32(acc1, avx512MulInt8(row + c + 16, x + c + 16));
+        }
+        for (; c + 16 <= cols; c += 16) {
+            acc0 = _mm512_add_epi32(acc0, avx512MulInt8(row + c, x + c));
+        }
+        int32_t sum = _mm512_reduce_add_epi32(_mm512_add_epi32(acc0, acc1));
+        for (; c < cols; c++) {
+            sum += (int32_t)row[c] * x[c];
+        }
+        y[r] = sum;
+    }
+}
+
+static const KernelTable avx512Table = {
+    ISA_AVX512, "avx512",
+    { avx512Add<double>, avx512Sub<double>, avx512Mul<double>, avx512Axpy<double>, avx512Scale<double>, avx512SubScaled<double>,
+      ActivationKernels<Avx512<double>, double>::activate, OptimizerKernels<Avx512<double>, double>::optimize,
+      GemmKernels<Avx512<double>, double, 12, 2>::entry() },
+    { avx512Add<float>, avx512Sub<float>, avx512Mul<float>, avx512Axpy<float>, avx512Scale<float>, avx512SubScaled<float>,
+      ActivationKernels<Avx512<float>, float>::activate, OptimizerKernels<Avx512<float>, float>::optimize,
+      GemmKernels<Avx512<float>, float, 12, 2>::entry() },
+    avx512GemvInt8
+};
+
+const KernelTable* getAvx512KernelTable() {
+    return &avx512Table;
+}
@@ -0,0 +1,200 @@
+#include <emmintrin.h>
+
+#include "../include/Kernels.hpp"
+#include "../include/ActivationKernels.hpp"
+#include "../include/GemmKernels.hpp"
+#include "../include/OptimizerKernels.hpp"
+
+// SSE2 kernels: two doubles or four floats per register, scalar tail for the rest.
+
+/**
+ * @brief 128-bit register operations for one element type
+ */
+template <typename T>
+struct Sse2;
+
+template <>
+struct Sse2<double> {
+    typedef __m128d V;
+    typedef __m128d Mask;
+    static const size_t width = 2;
+    static NN_ALWAYS_INLINE V load(const double* p) { return _mm_loadu_pd(p); }
+    static NN_ALWAYS_INLINE void store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static NN_ALWAYS_INLINE V set1(double a) { return _mm_set1_pd(a); }
+    static NN_ALWAYS_INLINE V add(V a, V b) { return _mm_add_pd(a, b); }
+    static NN_ALWAYS_INLINE V sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static NN_ALWAYS_INLINE V mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static NN_ALWAYS_INLINE V div(V a, V b) { return _mm_div_pd(a, b); }
+    static NN_ALWAYS_INLINE V sqrt(V a) { return _mm_sqrt_pd(a); }
+    static NN_ALWAYS_INLINE V min(V a, V b) { return _mm_min_pd(a, b); }
+    static NN_ALWAYS_INLINE V max(V a, V b) { return _mm_max_pd(a, b); }
+    static NN_ALWAYS_INLINE V abs(V a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    /// a * b + c, rounded twice (no FMA in SSE2)
+    static NN_ALWAYS_INLINE V fmadd(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    /// c - a * b, rounded twice
+    static NN_ALWAYS_INLINE V fnmadd(V a, V b, V c) { return _mm_sub_pd(c, _mm_mul_pd(a, b)); }
+    /// |magnitude| with the sign of sign
+    static NN_ALWAYS_INLINE V copySign(V magnitude, V sign) {
+        const V s = _mm_set1_pd(-0.0);
+        return _mm_or_pd(_mm_andnot_pd(s, magnitude), _mm_and_pd(s, sign));
+    }
+    static NN_ALWAYS_INLINE Mask greater(V a, V b) { return _mm_cmpgt_pd(a, b); }
+    /// m ? a : b per lane
+    static NN_ALWAYS_INLINE V select(Mask m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    /// 2^n from t = n + 1.5 * 2^52
+    static NN_ALWAYS_INLINE V pow2(V t) {
+        return _mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(_mm_castpd_si128(t), _mm_set1_epi64x(1023)), 52));
+    }
+};
+
+template <>
+struct Sse2<float> {
+    typedef __m128 V;
+    typedef __m128 Mask;
+    static const size_t width = 4;
+    static NN_ALWAYS_INLINE V load(const float* p) { return _mm_loadu_ps(p); }
+    static NN_ALWAYS_INLINE void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static NN_ALWAYS_INLINE V set1(float a) { return _mm_set1_ps(a); }
+    static NN_ALWAYS_INLINE V add(V a, V b) { return _mm_add_ps(a, b); }
+    static NN_ALWAYS_INLINE V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static NN_ALWAYS_INLINE V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static NN_ALWAYS_INLINE V div(V a, V b) { return _mm_div_ps(a, b); }
+    static NN_ALWAYS_INLINE V sqrt(V a) { return _mm_sqrt_ps(a); }
+    static NN_ALWAYS_INLINE V min(V a, V b) { return _mm_min_ps(a, b); }
+    static NN_ALWAYS_INLINE V max(V a, V b) { return _mm_max_ps(a, b); }
+    static NN_ALWAYS_INLINE V abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    /// a * b + c, rounded twice (no FMA in SSE2)
+    static NN_ALWAYS_INLINE V fmadd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    /// c - a * b, rounded twice
+    static NN_ALWAYS_INLINE V fnmadd(V a, V b, V c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+    /// |magnitude| with the sign of sign
+    static NN_ALWAYS_INLINE V copySign(V magnitude, V sign) {
+        const V s = _mm_set1_ps(-0.0f);
+        return _mm_or_ps(_mm_andnot_ps(s, magnitude), _mm_and_ps(s, sign));
+    }
+    static NN_ALWAYS_INLINE Mask greater(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    /// m ? a : b per lane
+    static NN_ALWAYS_INLINE V select(Mask m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    /// 2^n from t = n + 1.5 * 2^23
+    static NN_ALWAYS_INLINE V pow2(V t) {
+        return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_castps_si128(t), _mm_set1_epi32(127)), 23));
+    }
+};
+
+template <typename T>
+static void sse2Add(const T* a, const T* b, T* out, size_t n) {
+    typedef Sse2<T> S;
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::add(S::load(a + i), S::load(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+template <typename T>
+static void sse2Sub(const T* a, const T* b, T* out, size_t n) {
+    typedef Sse2<T> S;
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::sub(S::load(a + i), S::load(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+template <typename T>
+static void sse2Mul(const T* a, const T* b, T* out, size_t n) {
+    typedef Sse2<T> S;
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::mul(S::load(a + i), S::load(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+template <typename T>
+static void sse2Axpy(T alpha, const T* x, T* y, size_t n) {
+    typedef Sse2<T> S;
+    const typename S::V va = S::set1(alpha);
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(y + i, S::add(S::load(y + i), S::mul(va, S::load(x + i))));
+    }
+    for (; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+template <typename T>
+static void sse2Scale(T alpha, T* x, size_t n) {
+    typedef Sse2<T> S;
+    const typename S::V va = S::set1(alpha);
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(x + i, S::mul(va, S::load(x + i)));
+    }
+    for (; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+template <typename T>
+static void sse2SubScaled(const T* a, const T* b, T scalar, T* out, size_t n) {
+    typedef Sse2<T> S;
+    const typename S::V vs = S::set1(scalar);
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width) {
+        S::store(out + i, S::sub(S::load(a + i), S::mul(vs, S::load(b + i))));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] - scalar * b[i];
+    }
+}
+
+/**
+ * @brief Sign-extends the low (high) eight bytes of v to 16-bit lanes
+ */
+static NN_ALWAYS_INLINE __m128i sse2WidenLo(__m128i v) { return _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8); }
+static NN_ALWAYS_INLINE __m128i sse2WidenHi(__m128i v) { return _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8); }
+
+static void sse2GemvInt8(const int8_t* a, const int8_t* x, int32_t* y, size_t rows, size_t cols, size_t stride) {
+    for (size_t r = 0; r < rows; r++) {
+        const int8_t* row = a + r * stride;
+        __m128i acc = _mm_setzero_si128();
+        size_t c = 0;
+        for (; c + 16 <= cols; c += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + c));
+            __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + c));
+            // Pairs of int8 products summed into int32 lanes
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(sse2WidenLo(va), sse2WidenLo(vx)));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(sse2WidenHi(va), sse2WidenHi(vx)));
+        }
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        int32_t sum = _mm_cvtsi128_si32(acc);
+        for (; c < cols; c++) {
+            sum += (int32_t)row[c] * x[c];
+        }
+        y[r] = sum;
+    }
+}
+
+static const KernelTable sse2Table = {
+    ISA_SSE2, "sse2",
+    { sse2Add<double>, sse2Sub<double>, sse2Mul<double>, sse2Axpy<double>, sse2Scale<double>, sse2SubScaled<double>,
+      ActivationKernels<Sse2<double>, double>::activate, OptimizerKernels<Sse2<double>, double>::optimize,
+      GemmKernels<Sse2<double>, double, 4, 2>::entry() },
+    { sse2Add<float>, sse2Sub<float>, sse2Mul<float>, sse2Axpy<float>, sse2Scale<float>, sse2SubScaled<float>,
+      ActivationKernels<Sse2<float>, float>::activate, OptimizerKernels<Sse2<float>, float>::optimize,
+      GemmKernels<Sse2<float>, float, 4, 2>::entry() },
+    sse2GemvInt8
+};
+
+const KernelTable* getSse2KernelTable() {
+    return &sse2Table;
+}
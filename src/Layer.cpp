@@ -1,86 +1,111 @@
 #include "../include/Layer.hpp"
 #include "../include/Matrix.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/ThreadPool.hpp"
 
 using namespace std;
 
 /**
  * @brief Constructor for Layer
  * @param size Number of neurons in the layer
+ * @param activation Activation function of the neurons
  */
-Layer::Layer(int size) {
-    for (int i = 0; i < size; i++) {
-        Neuron* n = new Neuron(0.00);
-        this->neurons.push_back(n);
-    }
+template <typename T>
+BasicLayer<T>::BasicLayer(int size, ActivationType activation)
+    : vals(size, 1, false), activatedVals(size, 1, false), derivedVals(size, 1, false) {
     this->size = size;
+    this->activation = activation;
+    this->activate();
 }
 
 /**
- * @brief Cleans up memory by deleting all neurons
+ * @brief Sets the value of a specific neuron in the layer
+ * @param index Index of the neuron
+ * @param value New value for the neuron
  */
-void Layer::cleanup() {
-    for (int i = 0; i < this->neurons.size(); i++) {
-        delete this->neurons.at(i);
-    }
+template <typename T>
+void BasicLayer<T>::setNeuronVal(int index, double value) {
+    this->vals.setVal(index, 0, value);
+    // Same kernel as the forward pass, so a neuron set by hand matches a computed one
+    Activation::apply(this->activation, &this->vals.at(index, 0), &this->activatedVals.at(index, 0),
+                      &this->derivedVals.at(index, 0), 1);
 }
 
 /**
- * @brief Sets the value of a specific neuron in the layer
- * @param index Index of the neuron
- * @param value New value for the neuron
+ * @brief Changes the activation function and recomputes the activated values
+ * @param activation New activation function
  */
-void Layer::setNeuronVal(int index, double value) {
-    this->neurons.at(index)->setVal(value);
+template <typename T>
+void BasicLayer<T>::setActivation(ActivationType activation) {
+    this->activation = activation;
+    this->activate();
 }
 
 /**
- * @brief Gets all neurons in the layer
- * @return Vector of pointers to neurons
+ * @brief Recomputes activated and derived values from the raw values in one pass
  */
-vector<Neuron*> Layer::getNeurons() {
-    vector<Neuron*> temp;
-    for (int i = 0; i < this->neurons.size(); i++) {
-        temp.push_back(this->neurons.at(i));
+template <typename T>
+void BasicLayer<T>::activate() {
+    activateValues(this->activation, this->vals, this->activatedVals, this->derivedVals);
+}
+
+/**
+ * @brief Applies an activation function and its derivative element-wise
+ * @param type Activation function
+ * @param vals Raw values
+ * @param activated Receives the activated values (same shape as vals)
+ * @param derived Receives the derivatives (same shape as vals)
+ */
+template <typename T>
+void BasicLayer<T>::activateValues(ActivationType type, const BasicMatrix<T>& vals, BasicMatrix<T>& activated, BasicMatrix<T>& derived) {
+    NN_PROFILE_SCOPE("activation", -1, 0);
+    const size_t cols = vals.getNumCols();
+    // A handful of flops per element, a few dozen for the exp based activations
+    const size_t work = (size_t)vals.getNumRows() * cols * 8;
+
+    if (vals.isContiguous() && activated.isContiguous() && derived.isContiguous()) {
+        // One run over all the values, e.g. a single-sample column
+        auto body = [&](size_t b, size_t e) {
+            Activation::apply(type, vals.getData() + b, activated.getData() + b, derived.getData() + b, e - b);
+        };
+        ThreadPool::global().parallelFor(0, (size_t)vals.getNumRows() * cols, work, body);
+        return;
     }
 
-    return temp;
+    auto body = [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            Activation::apply(type, vals.rowPtr((int)i), activated.rowPtr((int)i), derived.rowPtr((int)i), cols);
+        }
+    };
+    ThreadPool::global().parallelFor(0, vals.getNumRows(), work, body);
 }
 
 /**
  * @brief Converts raw neuron values to a matrix
  * @return Matrix containing raw neuron values
  */
-Matrix* Layer::matrixifyVals() {
-    Matrix* m = new Matrix(this->neurons.size(), 1, false);
-    for (int i = 0; i < this->neurons.size(); i++) {
-        m->setVal(i, 0, neurons.at(i)->getVal());
-    }
-    
-    return m;
+template <typename T>
+BasicMatrix<T>* BasicLayer<T>::matrixifyVals() {
+    return new BasicMatrix<T>(this->vals);
 }
 
 /**
  * @brief Converts activated neuron values to a matrix
  * @return Matrix containing activated neuron values
  */
-Matrix* Layer::matrixifyActivatedVals() {
-    Matrix* m = new Matrix(this->neurons.size(), 1, false);
-    for (int i = 0; i < this->neurons.size(); i++) {
-        m->setVal(i, 0, neurons.at(i)->getActivatedVal());
-    }
-    
-    return m;
+template <typename T>
+BasicMatrix<T>* BasicLayer<T>::matrixifyActivatedVals() {
+    return new BasicMatrix<T>(this->activatedVals);
 }
 
 /**
  * @brief Converts derived neuron values to a matrix
  * @return Matrix containing derived neuron values
  */
-Matrix* Layer::matrixifyDerivedVals() {
-    Matrix* m = new Matrix(this->neurons.size(), 1, false);
-    for (int i = 0; i < this->neurons.size(); i++) {
-        m->setVal(i, 0, neurons.at(i)->getDerivedVal());
-    }
-    
-    return m;
+template <typename T>
+BasicMatrix<T>* BasicLayer<T>::matrixifyDerivedVals() {
+    return new BasicMatrix<T>(this->derivedVals);
 }
+
+template class BasicLayer<double>;
+template class BasicLayer<float>;
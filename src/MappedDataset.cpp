@@ -0,0 +1,366 @@
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include <cstddef>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../include/MappedDataset.hpp"
+#include "../include/Dataset.hpp"
+#include "../include/Initializer.hpp"
+
+using namespace std;
+
+// Samples transposed in memory before each row's slice of them is written
+#define CONVERT_BLOCK 4096
+
+static_assert(sizeof(MappedDatasetHeader) == 64, "MappedDatasetHeader must stay 64 bytes");
+
+/**
+ * @brief Writes every sample of a source file into the rows of a columnar file
+ * @param loader Loader over the source, in file order
+ * @param file Columnar file with its header already written
+ * @param h Header of the file
+ * @return Number of samples written
+ */
+template <typename U>
+static size_t writeColumns(DatasetLoader& loader, ofstream& file, const MappedDatasetHeader& h) {
+    const int width = h.numInputs + h.numTargets;
+    vector<U> block((size_t)width * CONVERT_BLOCK);
+    DatasetBatch batch;
+    size_t written = 0;
+    size_t filled = 0;
+
+    auto flush = [&]() {
+        for (int r = 0; r < width; r++) {
+            const uint64_t offset = h.inputsOffset + ((uint64_t)r * h.stride + written) * sizeof(U);
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char*>(&block[(size_t)r * CONVERT_BLOCK]), filled * sizeof(U));
+        }
+        written += filled;
+        filled = 0;
+    };
+
+    while (loader.next(batch)) {
+        for (size_t k = 0; k < batch.inputs.size(); k++) {
+            if (written + filled == h.numSamples) {
+                cerr << "Dataset changed while it was being converted" << endl;
+                assert(false);
+            }
+            for (int r = 0; r < (int)h.numInputs; r++) {
+                block[(size_t)r * CONVERT_BLOCK + filled] = (U)batch.inputs[k][r];
+            }
+            for (int r = 0; r < (int)h.numTargets; r++) {
+                block[(size_t)(h.numInputs + r) * CONVERT_BLOCK + filled] = (U)batch.targets[k][r];
+            }
+            if (++filled == CONVERT_BLOCK) {
+                flush();
+            }
+        }
+    }
+    flush();
+    return written;
+}
+
+/**
+ * @brief Maps and validates a columnar dataset file
+ * @param path Path written by convert
+ */
+template <typename T>
+BasicMappedDataset<T>::BasicMappedDataset(const string& path) {
+    this->base = nullptr;
+    this->size = 0;
+    this->converted = nullptr;
+    this->batchSize = 0;
+    this->rng = 1;
+
+#ifdef _WIN32
+    // No mmap: read the file into an aligned buffer instead
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open()) {
+        cerr << "Could not open dataset file: " << path << endl;
+        assert(false);
+    }
+    this->size = (size_t)file.tellg();
+    this->base = static_cast<unsigned char*>(Matrix::alignedAlloc(this->size));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(this->base), this->size);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "Could not open dataset file: " << path << endl;
+        assert(false);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MappedDatasetHeader)) {
+        cerr << "Dataset file is too small to be a columnar dataset: " << path << endl;
+        close(fd);
+        assert(false);
+    }
+    this->size = (size_t)st.st_size;
+
+    // Private mapping, as for models: the views are writable but the file never changes
+    void* p = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        cerr << "Could not map dataset file: " << path << endl;
+        assert(false);
+    }
+    this->base = static_cast<unsigned char*>(p);
+#endif
+
+    this->validate(path);
+}
+
+/**
+ * @brief Destructor, unmaps the file
+ */
+template <typename T>
+BasicMappedDataset<T>::~BasicMappedDataset() {
+    Matrix::alignedFree(this->converted);
+#ifdef _WIN32
+    Matrix::alignedFree(this->base);
+#else
+    if (this->base != nullptr) {
+        munmap(this->base, this->size);
+    }
+#endif
+}
+
+/**
+ * @brief Validates the header and locates the blocks
+ */
+template <typename T>
+void BasicMappedDataset<T>::validate(const string& path) {
+    const MappedDatasetHeader* h = this->header();
+
+    if (this->size < sizeof(MappedDatasetHeader) || memcmp(h->magic, MAPPED_DATASET_MAGIC, sizeof(MAPPED_DATASET_MAGIC)) != 0) {
+        cerr << "Not a columnar dataset file: " << path << endl;
+        assert(false);
+    }
+    if (h->byteOrder != MODEL_FILE_BYTE_ORDER) {
+        cerr << "Dataset file was written with a different byte order: " << path << endl;
+        assert(false);
+    }
+    if (h->version != MAPPED_DATASET_VERSION) {
+        cerr << "Unsupported dataset file version " << h->version << ": " << path << endl;
+        assert(false);
+    }
+    if (h->dtype != MODEL_FLOAT64 && h->dtype != MODEL_FLOAT32) {
+        cerr << "Unsupported dataset data type " << h->dtype << ": " << path << endl;
+        assert(false);
+    }
+
+    const uint64_t elementSize = h->dtype == MODEL_FLOAT32 ? sizeof(float) : sizeof(double);
+    const uint64_t rowBytes = h->stride * elementSize;
+    if (h->numInputs < 1 || h->numTargets < 1 || h->stride < h->numSamples || h->stride > INT_MAX
+        || rowBytes % MODEL_FILE_ALIGNMENT != 0 || h->inputsOffset % MODEL_FILE_ALIGNMENT != 0
+        || h->inputsOffset < sizeof(MappedDatasetHeader) || h->targetsOffset != h->inputsOffset + h->numInputs * rowBytes) {
+        cerr << "Corrupt dataset file header: " << path << endl;
+        assert(false);
+    }
+    if (h->targetsOffset + h->numTargets * rowBytes != this->size) {
+        cerr << "Dataset file is truncated, expected " << h->targetsOffset + h->numTargets * rowBytes
+             << " bytes but found " << this->size << ": " << path << endl;
+        assert(false);
+    }
+
+    this->numSamples = h->numSamples;
+    this->stride = h->stride;
+    this->numInputs = h->numInputs;
+    this->numTargets = h->numTargets;
+
+    if (h->dtype == ModelDtypeOf<T>::value) {
+        this->data = reinterpret_cast<T*>(this->base + h->inputsOffset);
+        return;
+    }
+
+    // Other dtype: convert both blocks once, the views then point into the copy
+    const int rows = this->numInputs + this->numTargets;
+    const int cols = (int)this->numSamples;
+    this->converted = static_cast<T*>(Matrix::alignedAlloc(sizeof(T) * rows * this->stride));
+    BasicMatrix<T> dst(this->converted, rows, cols, (int)this->stride);
+    unsigned char* src = this->base + h->inputsOffset;
+    if (h->dtype == MODEL_FLOAT64) {
+        dst.convertFrom(Matrix(reinterpret_cast<double*>(src), rows, cols, (int)this->stride));
+    }
+    else {
+        dst.convertFrom(MatrixF(reinterpret_cast<float*>(src), rows, cols, (int)this->stride));
+    }
+    this->data = this->converted;
+}
+
+/**
+ * @brief Checks whether a file starts with the columnar dataset magic
+ * @param path Path to check
+ * @return True for columnar dataset files
+ */
+template <typename T>
+bool BasicMappedDataset<T>::isColumnar(const string& path) {
+    ifstream file(path, ios::binary);
+    char magic[sizeof(MAPPED_DATASET_MAGIC)];
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return memcmp(magic, MAPPED_DATASET_MAGIC, sizeof(MAPPED_DATASET_MAGIC)) == 0;
+}
+
+/**
+ * @brief Converts a CSV or binary row file into a columnar dataset file
+ * @param sourcePath CSV or binary row file (see DatasetLoader)
+ * @param path Columnar file to write
+ * @param numInputs Input values per sample
+ * @param numTargets Target values per sample
+ * @param dtype Element type to store
+ * @param skipHeader Whether the first line of a CSV file is a header
+ * @return Number of samples written
+ */
+template <typename T>
+size_t BasicMappedDataset<T>::convert(const string& sourcePath, const string& path, int numInputs, int numTargets,
+                                      ModelDtype dtype, bool skipHeader) {
+    if (numInputs < 1 || numTargets < 1) {
+        cerr << "A columnar dataset needs at least one input and one target" << endl;
+        assert(false);
+    }
+
+    DatasetConfig config;
+    config.batchSize = 1024;
+    config.skipHeader = skipHeader;
+
+    // First pass only counts, the layout depends on the number of samples
+    size_t numSamples = 0;
+    {
+        DatasetLoader loader(sourcePath, numInputs, numTargets, config);
+        DatasetBatch batch;
+        while (loader.next(batch)) {
+            numSamples += batch.inputs.size();
+        }
+    }
+
+    const uint64_t elementSize = dtype == MODEL_FLOAT32 ? sizeof(float) : sizeof(double);
+    const uint64_t perLine = MODEL_FILE_ALIGNMENT / elementSize;
+
+    MappedDatasetHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAPPED_DATASET_MAGIC, sizeof(MAPPED_DATASET_MAGIC));
+    h.version = MAPPED_DATASET_VERSION;
+    h.byteOrder = MODEL_FILE_BYTE_ORDER;
+    h.dtype = dtype;
+    h.numInputs = numInputs;
+    h.numTargets = numTargets;
+    h.numSamples = numSamples;
+    h.stride = (numSamples + perLine - 1) / perLine * perLine;
+    h.inputsOffset = MODEL_FILE_ALIGNMENT;
+    h.targetsOffset = h.inputsOffset + h.numInputs * h.stride * elementSize;
+    const uint64_t fileSize = h.targetsOffset + h.numTargets * h.stride * elementSize;
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        cerr << "Could not open dataset file for writing: " << path << endl;
+        assert(false);
+    }
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    DatasetLoader loader(sourcePath, numInputs, numTargets, config);
+    const size_t written = dtype == MODEL_FLOAT32 ? writeColumns<float>(loader, file, h) : writeColumns<double>(loader, file, h);
+    if (written != numSamples) {
+        cerr << "Dataset changed while it was being converted" << endl;
+        assert(false);
+    }
+
+    // Padding after the last sample of the last row is a hole; give the file its full size
+    if (numSamples < h.stride) {
+        file.seekp(fileSize - 1);
+        file.put(0);
+    }
+    if (!file.good()) {
+        cerr << "Could not write dataset file: " << path << endl;
+        assert(false);
+    }
+    return written;
+}
+
+/**
+ * @brief Creates a view of the inputs of consecutive samples
+ * @param first First sample
+ * @param count Number of samples
+ * @return numInputs x count view
+ */
+template <typename T>
+BasicMatrix<T> BasicMappedDataset<T>::inputs(size_t first, int count) {
+    if (count < 0 || first + count > this->numSamples) {
+        cerr << "Samples " << first << " to " << first + count << " are outside the dataset" << endl;
+        assert(false);
+    }
+    return BasicMatrix<T>(this->data + first, this->numInputs, count, (int)this->stride);
+}
+
+/**
+ * @brief Creates a view of the targets of consecutive samples
+ * @param first First sample
+ * @param count Number of samples
+ * @return numTargets x count view
+ */
+template <typename T>
+BasicMatrix<T> BasicMappedDataset<T>::targets(size_t first, int count) {
+    if (count < 0 || first + count > this->numSamples) {
+        cerr << "Samples " << first << " to " << first + count << " are outside the dataset" << endl;
+        assert(false);
+    }
+    return BasicMatrix<T>(this->data + this->numInputs * this->stride + first, this->numTargets, count, (int)this->stride);
+}
+
+/**
+ * @brief Lays out the batches of the next epoch
+ * @param batchSize Samples per batch
+ * @param shuffle Whether to permute the batches
+ * @return Number of batches in the epoch
+ */
+template <typename T>
+int BasicMappedDataset<T>::beginEpoch(int batchSize, bool shuffle) {
+    if (batchSize < 1) {
+        cerr << "Batch size must be positive" << endl;
+        assert(false);
+    }
+    this->batchSize = batchSize;
+    this->order.clear();
+
+    const size_t n = this->numSamples;
+    if (!shuffle || n <= (size_t)batchSize) {
+        for (size_t first = 0; first < n; first += batchSize) {
+            this->order.push_back(first);
+        }
+        return this->order.size();
+    }
+
+    // Shift the boundaries so batches mix differently, then permute their order
+    const size_t offset = SplitMix64::next(this->rng) % min((size_t)batchSize, n - batchSize + 1);
+    for (size_t first = offset; first + batchSize <= n; first += batchSize) {
+        this->order.push_back(first);
+    }
+    for (size_t i = this->order.size() - 1; i > 0; i--) {
+        swap(this->order[i], this->order[SplitMix64::next(this->rng) % (i + 1)]);
+    }
+    return this->order.size();
+}
+
+/**
+ * @brief Gets the number of samples in a batch of the epoch
+ * @param index Batch index
+ * @return Samples in the batch
+ */
+template <typename T>
+int BasicMappedDataset<T>::getBatchSize(int index) const {
+    const size_t first = this->order.at(index);
+    return (int)min((size_t)this->batchSize, this->numSamples - first);
+}
+
+template class BasicMappedDataset<double>;
+template class BasicMappedDataset<float>;
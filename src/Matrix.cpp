@@ -1,152 +1,493 @@
 #include <iostream>
-#include <random>
 #include <vector>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <new>
 
 #include "../include/Matrix.hpp"
+#include "../include/Gemm.hpp"
+#include "../include/Initializer.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/ThreadPool.hpp"
 
 /**
- * @brief Constructor for Matrix
+ * @brief Splits an element-wise pass over a matrix shape across the global thread pool
+ *
+ * When every operand is contiguous the matrix is treated as one flat row and split into
+ * element ranges, otherwise it is split by rows. body(row, offset, len) processes len
+ * elements starting at rowPtr(row) + offset of each operand.
+ * @param rows Number of rows of the operands
+ * @param cols Number of columns of the operands
+ * @param contiguous Whether all operands are contiguous
+ * @param body Callable taking (int row, size_t offset, size_t len)
+ */
+template <typename F>
+static void parallelSpans(int rows, int cols, bool contiguous, F& body) {
+    const size_t n = (size_t)rows * cols;
+    ThreadPool& pool = ThreadPool::global();
+
+    if (contiguous) {
+        auto chunk = [&](size_t b, size_t e) { body(0, b, e - b); };
+        pool.parallelFor(0, n, n, chunk);
+    }
+    else {
+        auto chunk = [&](size_t b, size_t e) {
+            for (size_t r = b; r < e; r++) {
+                body((int)r, 0, (size_t)cols);
+            }
+        };
+        pool.parallelFor(0, rows, n, chunk);
+    }
+}
+
+/**
+ * @brief Applies an element-wise kernel to two same-shaped matrices
+ */
+template <typename T>
+static void applyBinary(void (*op)(const T*, const T*, T*, size_t),
+                        const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out) {
+    auto body = [&](int row, size_t offset, size_t len) {
+        op(a.rowPtr(row) + offset, b.rowPtr(row) + offset, out.rowPtr(row) + offset, len);
+    };
+    parallelSpans(a.getNumRows(), a.getNumCols(), a.isContiguous() && b.isContiguous() && out.isContiguous(), body);
+}
+
+/**
+ * @brief Constructor for BasicMatrix
  * @param numRows Number of rows in the matrix
  * @param numCols Number of columns in the matrix
- * @param isRandom Whether to initialize with random values
+ * @param isRandom Whether to fill with uniform values in [0, 1) (see Initializer), zeros otherwise
  */
-Matrix::Matrix(int numRows, int numCols, bool isRandom) {
+template <typename T>
+BasicMatrix<T>::BasicMatrix(int numRows, int numCols, bool isRandom) {
     this->numRows = numRows;
     this->numCols = numCols;
-    
-    for (int i = 0; i < numRows; i++) {
-        double r = 0.0;
-        std::vector<double> colVals;
-        for (int k = 0; k < numCols; k++) {
-            if (isRandom) {
-                r = this->getRandNo();
-            }
-            colVals.push_back(r);
+    this->allocate();
+
+    if (isRandom) {
+        Initializer::uniform(*this, 0.0, 1.0, Initializer::nextSeed(), 0);
+    }
+}
+
+/**
+ * @brief Constructor for a non-owning view over existing memory
+ * @param data Pointer to the first element
+ * @param numRows Number of rows in the view
+ * @param numCols Number of columns in the view
+ * @param stride Distance in elements between the starts of consecutive rows
+ */
+template <typename T>
+BasicMatrix<T>::BasicMatrix(T* data, int numRows, int numCols, int stride) {
+    this->numRows = numRows;
+    this->numCols = numCols;
+    this->stride = stride;
+    this->owner = false;
+    this->data = data;
+}
+
+/**
+ * @brief Copy constructor, always produces an owning contiguous copy
+ * @param m BasicMatrix to copy
+ */
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& m) {
+    this->numRows = m.numRows;
+    this->numCols = m.numCols;
+    this->allocate();
+
+    for (int i = 0; i < this->numRows; i++) {
+        std::memcpy(this->rowPtr(i), m.rowPtr(i), sizeof(T) * this->numCols);
+    }
+}
+
+/**
+ * @brief Move constructor, takes over the buffer (and its ownership) of m
+ * @param m BasicMatrix to move from
+ */
+template <typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& m) {
+    this->numRows = m.numRows;
+    this->numCols = m.numCols;
+    this->stride = m.stride;
+    this->owner = m.owner;
+    this->data = m.data;
+
+    m.owner = false;
+    m.data = nullptr;
+    m.numRows = 0;
+    m.numCols = 0;
+}
+
+/**
+ * @brief Copy assignment, copies values into this matrix
+ * @param m BasicMatrix to copy values from
+ * @return Reference to this matrix
+ */
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& m) {
+    if (this == &m) {
+        return *this;
+    }
+
+    if (this->numRows != m.numRows || this->numCols != m.numCols) {
+        if (!this->owner) {
+            std::cerr << "Cannot assign a matrix of a different shape to a view: " << std::endl;
+            assert(false);
         }
-        this->values.push_back(colVals);
+        alignedFree(this->data);
+        this->numRows = m.numRows;
+        this->numCols = m.numCols;
+        this->allocate();
     }
+
+    for (int i = 0; i < this->numRows; i++) {
+        std::memmove(this->rowPtr(i), m.rowPtr(i), sizeof(T) * this->numCols);
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Move assignment, takes over the buffer (and its ownership) of m
+ * @param m BasicMatrix to move from
+ * @return Reference to this matrix
+ */
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& m) {
+    if (this == &m) {
+        return *this;
+    }
+
+    if (this->owner) {
+        alignedFree(this->data);
+    }
+    this->numRows = m.numRows;
+    this->numCols = m.numCols;
+    this->stride = m.stride;
+    this->owner = m.owner;
+    this->data = m.data;
+
+    m.owner = false;
+    m.data = nullptr;
+    m.numRows = 0;
+    m.numCols = 0;
+
+    return *this;
 }
 
 /**
- * @brief Generates a random number for matrix initialization
- * @return Random double value
+ * @brief Destructor, releases the buffer if this matrix owns it
  */
-double Matrix::getRandNo() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0, 1);
+template <typename T>
+BasicMatrix<T>::~BasicMatrix() {
+    if (this->owner) {
+        alignedFree(this->data);
+    }
+}
 
-    return dis(gen);
+/**
+ * @brief Allocates an owning contiguous buffer for the current shape
+ */
+template <typename T>
+void BasicMatrix<T>::allocate() {
+    this->stride = this->numCols;
+    this->owner = true;
+    this->data = static_cast<T*>(alignedAlloc(sizeof(T) * (size_t)this->numRows * this->numCols));
+    NN_PROFILE_ALLOC(sizeof(T) * (size_t)this->numRows * this->numCols);
+}
+
+/**
+ * @brief Allocates a zero-initialized buffer aligned to MATRIX_ALIGNMENT
+ *
+ * The pointer returned by operator new is stashed in the slot right before the aligned
+ * block so alignedFree can recover it without any platform specific allocator.
+ * @param bytes Size of the buffer in bytes
+ * @return Pointer to the buffer, to be released with alignedFree
+ */
+template <typename T>
+void* BasicMatrix<T>::alignedAlloc(size_t bytes) {
+    void* raw = ::operator new(bytes + MATRIX_ALIGNMENT + sizeof(void*));
+    uintptr_t p = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+    p = (p + MATRIX_ALIGNMENT - 1) & ~(uintptr_t)(MATRIX_ALIGNMENT - 1);
+
+    reinterpret_cast<void**>(p)[-1] = raw;
+    std::memset(reinterpret_cast<void*>(p), 0, bytes);
+
+    return reinterpret_cast<void*>(p);
+}
+
+/**
+ * @brief Releases a buffer obtained from alignedAlloc
+ * @param ptr Pointer returned by alignedAlloc (may be null)
+ */
+template <typename T>
+void BasicMatrix<T>::alignedFree(void* ptr) {
+    if (ptr != nullptr) {
+        ::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+    }
 }
 
 /**
  * @brief Prints the matrix to the console
  */
-void Matrix::printToConsole() {
+template <typename T>
+void BasicMatrix<T>::printToConsole() {
     for (int i = 0; i < numRows; i++) {
         for (int k = 0; k < numCols; k++) {
-            std::cout << this->values.at(i).at(k) << "\t";
+            std::cout << this->at(i, k) << "\t";
         }
         std::cout << std::endl;
     }
 }
 
+/**
+ * @brief Creates a non-owning view of a single row
+ * @param index Row index
+ * @return 1 x numCols view sharing this matrix's memory
+ */
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::row(int index) {
+    return this->block(index, 0, 1, this->numCols);
+}
+
+/**
+ * @brief Creates a non-owning view of a single column
+ * @param index Column index
+ * @return numRows x 1 view sharing this matrix's memory
+ */
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::col(int index) {
+    return this->block(0, index, this->numRows, 1);
+}
+
+/**
+ * @brief Creates a non-owning view of a rectangular sub-block
+ * @param row Index of the first row of the block
+ * @param col Index of the first column of the block
+ * @param numRows Number of rows in the block
+ * @param numCols Number of columns in the block
+ * @return View sharing this matrix's memory
+ */
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::block(int row, int col, int numRows, int numCols) {
+    if (row < 0 || col < 0 || numRows < 0 || numCols < 0 ||
+        row + numRows > this->numRows || col + numCols > this->numCols) {
+        throw std::out_of_range("BasicMatrix block out of range");
+    }
+
+    return BasicMatrix(this->data + (size_t)row * this->stride + col, numRows, numCols, this->stride);
+}
+
 /**
  * @brief Creates a transposed version of this matrix
  * @return Pointer to the transposed matrix
  */
-Matrix* Matrix::transpose() {
-    Matrix* m = new Matrix(this->numCols, this->numRows, false);
-    for (int i = 0; i < this->numCols; i++) {
-        for (int k = 0; k < this->numRows; k++) {
-            m->setVal(i, k, this->getVal(k, i));
-        }
-    }
+template <typename T>
+BasicMatrix<T>* BasicMatrix<T>::transpose() {
+    BasicMatrix* m = new BasicMatrix(this->numCols, this->numRows, false);
+    this->transposeInto(*m);
 
     return m;
 }
 
+/**
+ * @brief Writes the transpose of this matrix into an existing matrix
+ * @param out numCols x numRows destination
+ */
+template <typename T>
+void BasicMatrix<T>::transposeInto(BasicMatrix& out) const {
+    if (out.getNumRows() != this->numCols || out.getNumCols() != this->numRows) {
+        std::cerr << "Transpose destination has the wrong shape: " << std::endl;
+        assert(false);
+    }
+    NN_PROFILE_SCOPE("transpose", -1, 0);
+
+    // Each chunk fills whole rows of out, i.e. whole columns of this matrix
+    auto body = [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; k++) {
+            T* dst = out.rowPtr((int)k);
+            for (int i = 0; i < this->numRows; i++) {
+                dst[i] = this->at(i, (int)k);
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, this->numCols, (size_t)this->numRows * this->numCols, body);
+}
+
 /**
  * @brief Multiplies all elements by a scalar value
  * @param scalar The scalar value to multiply by
  */
-void Matrix::scalarMultiply(double scalar) {
-    for (int i = 0; i < this->getNumRows(); i++) {
-        for (int k = 0; k < this->getNumCols(); k++) {
-            this->setVal(i, k, this->getVal(i, k) * scalar);
-        }
+template <typename T>
+void BasicMatrix<T>::scalarMultiply(double scalar) {
+    NN_PROFILE_SCOPE("scale", -1, (double)this->numRows * this->numCols);
+    const KernelOps<T>& k = Kernels::ops<T>();
+    auto body = [&](int row, size_t offset, size_t len) {
+        k.scale((T)scalar, this->rowPtr(row) + offset, len);
+    };
+    parallelSpans(this->numRows, this->numCols, this->isContiguous(), body);
+}
+
+/**
+ * @brief Adds a scaled matrix to this matrix in place (this += alpha * x)
+ * @param alpha Scale factor applied to x
+ * @param x BasicMatrix to add
+ */
+template <typename T>
+void BasicMatrix<T>::axpy(double alpha, BasicMatrix& x) {
+    if (this->getNumRows() != x.getNumRows() || this->getNumCols() != x.getNumCols()) {
+        std::cerr << "Rows and Column sizes mismatch: " << std::endl;
+        assert(false);
     }
+    NN_PROFILE_SCOPE("axpy", -1, 2.0 * this->numRows * this->numCols);
+
+    const KernelOps<T>& k = Kernels::ops<T>();
+    auto body = [&](int row, size_t offset, size_t len) {
+        k.axpy((T)alpha, x.rowPtr(row) + offset, this->rowPtr(row) + offset, len);
+    };
+    parallelSpans(this->numRows, this->numCols, this->isContiguous() && x.isContiguous(), body);
 }
 
 /**
- * @brief Matrix addition operator
- * @param b Matrix to add
+ * @brief Computes this - scalar * b in a single pass
+ * @param b BasicMatrix to scale and subtract
+ * @param scalar Scale factor applied to b
  * @return Pointer to the resulting matrix
  */
-Matrix* Matrix::operator+(Matrix& b) {
-    if (this->getNumRows() != b.getNumRows() || this->getNumCols() != b.getNumCols()) {
+template <typename T>
+BasicMatrix<T>* BasicMatrix<T>::subtractScaled(BasicMatrix& b, double scalar) {
+    BasicMatrix* m = new BasicMatrix(this->getNumRows(), this->getNumCols(), false);
+    this->subtractScaled(b, scalar, *m);
+
+    return m;
+}
+
+/**
+ * @brief Computes this - scalar * b into an existing matrix
+ * @param b BasicMatrix to scale and subtract
+ * @param scalar Scale factor applied to b
+ * @param out Destination, may be this matrix for an in-place update
+ */
+template <typename T>
+void BasicMatrix<T>::subtractScaled(BasicMatrix& b, double scalar, BasicMatrix& out) {
+    if (this->getNumRows() != b.getNumRows() || this->getNumCols() != b.getNumCols() ||
+        this->getNumRows() != out.getNumRows() || this->getNumCols() != out.getNumCols()) {
         std::cerr << "Rows and Column sizes mismatch: " << std::endl;
         assert(false);
     }
+    NN_PROFILE_SCOPE("subtractScaled", -1, 2.0 * this->numRows * this->numCols);
 
-    Matrix* m = new Matrix(this->getNumRows(), this->getNumCols(), false);
+    const KernelOps<T>& k = Kernels::ops<T>();
+    auto body = [&](int row, size_t offset, size_t len) {
+        k.subScaled(this->rowPtr(row) + offset, b.rowPtr(row) + offset, (T)scalar, out.rowPtr(row) + offset, len);
+    };
+    parallelSpans(this->numRows, this->numCols, this->isContiguous() && b.isContiguous() && out.isContiguous(), body);
+}
 
-    for (int i = 0; i < this->getNumRows(); i++) {
-        for (int k = 0; k < this->getNumCols(); k++) {
-            m->setVal(i, k, this->getVal(i, k) + b.getVal(i, k));
-        }
+/**
+ * @brief Adds a column vector to every column of this matrix in place
+ * @param column numRows x 1 matrix to add
+ */
+template <typename T>
+void BasicMatrix<T>::broadcastAddColumn(BasicMatrix& column) {
+    if (column.getNumRows() != this->getNumRows() || column.getNumCols() != 1) {
+        std::cerr << "Broadcast column must be numRows x 1: " << std::endl;
+        assert(false);
     }
+    NN_PROFILE_SCOPE("broadcastAdd", -1, (double)this->numRows * this->numCols);
 
-    return m;
+    auto body = [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            const T v = column.at((int)i, 0);
+            T* r = this->rowPtr((int)i);
+            for (int k = 0; k < this->numCols; k++) {
+                r[k] += v;
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, this->numRows, (size_t)this->numRows * this->numCols, body);
 }
 
 /**
- * @brief Matrix subtraction operator
- * @param b Matrix to subtract
+ * @brief BasicMatrix addition operator
+ * @param b BasicMatrix to add
  * @return Pointer to the resulting matrix
  */
-Matrix* Matrix::operator-(Matrix& b) {
+template <typename T>
+BasicMatrix<T>* BasicMatrix<T>::operator+(BasicMatrix& b) {
     if (this->getNumRows() != b.getNumRows() || this->getNumCols() != b.getNumCols()) {
         std::cerr << "Rows and Column sizes mismatch: " << std::endl;
         assert(false);
     }
+    NN_PROFILE_SCOPE("add", -1, (double)this->numRows * this->numCols);
 
-    Matrix* m = new Matrix(this->getNumRows(), this->getNumCols(), false);
+    BasicMatrix* m = new BasicMatrix(this->getNumRows(), this->getNumCols(), false);
 
-    for (int i = 0; i < this->getNumRows(); i++) {
-        for (int k = 0; k < this->getNumCols(); k++) {
-            m->setVal(i, k, this->getVal(i, k) - b.getVal(i, k));
-        }
-    }
+    applyBinary(Kernels::ops<T>().add, *this, b, *m);
 
     return m;
 }
 
 /**
- * @brief Matrix multiplication operator
- * @param b Matrix to multiply with
+ * @brief BasicMatrix subtraction operator
+ * @param b BasicMatrix to subtract
  * @return Pointer to the resulting matrix
  */
-Matrix* Matrix::operator*(Matrix& b) {
-    if (this->getNumCols() != b.getNumRows()) {
-        std::cerr << "Matrix dimensions incompatible for multiplication: " << std::endl;
-        std::cerr << "A: " << this->getNumRows() << "x" << this->getNumCols() << std::endl;
-        std::cerr << "B: " << b.getNumRows() << "x" << b.getNumCols() << std::endl;
+template <typename T>
+BasicMatrix<T>* BasicMatrix<T>::operator-(BasicMatrix& b) {
+    if (this->getNumRows() != b.getNumRows() || this->getNumCols() != b.getNumCols()) {
+        std::cerr << "Rows and Column sizes mismatch: " << std::endl;
         assert(false);
     }
+    NN_PROFILE_SCOPE("sub", -1, (double)this->numRows * this->numCols);
 
-    Matrix* c = new Matrix(this->getNumRows(), b.getNumCols(), false);
+    BasicMatrix* m = new BasicMatrix(this->getNumRows(), this->getNumCols(), false);
 
-    for (int i = 0; i < this->getNumRows(); i++) {
-        for (int k = 0; k < b.getNumCols(); k++) {
-            for (int l = 0; l < this->getNumCols(); l++) { 
-                double v = this->getVal(i, l) * b.getVal(l, k);
-                double nv = c->getVal(i, k) + v;
-                c->setVal(i, k, nv);
-            }
-        }
+    applyBinary(Kernels::ops<T>().sub, *this, b, *m);
+
+    return m;
+}
+
+/**
+ * @brief BasicMatrix multiplication operator
+ *
+ * Dispatches to the kernel selected with Gemm::setKernel.
+ * @param b BasicMatrix to multiply with
+ * @return Pointer to the resulting matrix
+ */
+template <typename T>
+BasicMatrix<T>* BasicMatrix<T>::operator*(BasicMatrix& b) {
+    return this->multiply(b, false, false);
+}
+
+/**
+ * @brief Matrix product with either operand transposed, without copying it
+ *
+ * The kernels read a transposed operand in its stored layout, see Gemm.
+ * @param b BasicMatrix to multiply with
+ * @param transposeThis Whether to use the transpose of this matrix
+ * @param transposeB Whether to use the transpose of b
+ * @return Pointer to op(this) * op(b)
+ */
+template <typename T>
+BasicMatrix<T>* BasicMatrix<T>::multiply(BasicMatrix& b, bool transposeThis, bool transposeB) {
+    const int m = transposeThis ? this->getNumCols() : this->getNumRows();
+    const int k = transposeThis ? this->getNumRows() : this->getNumCols();
+    const int bk = transposeB ? b.getNumCols() : b.getNumRows();
+    const int n = transposeB ? b.getNumRows() : b.getNumCols();
+    if (k != bk) {
+        std::cerr << "BasicMatrix dimensions incompatible for multiplication: " << std::endl;
+        std::cerr << "A: " << m << "x" << k << (transposeThis ? " (transposed)" : "") << std::endl;
+        std::cerr << "B: " << bk << "x" << n << (transposeB ? " (transposed)" : "") << std::endl;
+        assert(false);
     }
+    NN_PROFILE_SCOPE("matmul", -1, 0);
+
+    BasicMatrix* c = new BasicMatrix(m, n, false);
+    Gemm::multiply(*this, b, *c, true, transposeThis ? GEMM_TRANSPOSE : GEMM_NO_TRANSPOSE,
+                   transposeB ? GEMM_TRANSPOSE : GEMM_NO_TRANSPOSE);
 
     return c;
 }
@@ -156,34 +497,75 @@ Matrix* Matrix::operator*(Matrix& b) {
  * @param m Pointer to the matrix to multiply with
  * @return Pointer to the resulting matrix
  */
-Matrix* Matrix::elementwiseMultiply(Matrix* m) {
-    if (m->getNumRows() != this->getNumRows() || m->getNumCols() != this->getNumCols()) {
-        std::cerr << "Dimensions mismatch for element-wise multiplication: " << std::endl;
-        assert(false);
-    }
+template <typename T>
+BasicMatrix<T>* BasicMatrix<T>::elementwiseMultiply(BasicMatrix* m) {
+    BasicMatrix* temp = new BasicMatrix(m->getNumRows(), m->getNumCols(), false);
+    this->elementwiseMultiply(*m, *temp);
 
-    Matrix* temp = new Matrix(m->getNumRows(), m->getNumCols(), false);
+    return temp;
+}
 
-    for (int i = 0; i < m->getNumRows(); i++) {
-        for (int k = 0; k < m->getNumCols(); k++) {
-            temp->setVal(i, k, this->getVal(i, k) * m->getVal(i, k));
-        }
+/**
+ * @brief Performs element-wise multiplication into an existing matrix
+ * @param m BasicMatrix to multiply with
+ * @param out Destination, may be this matrix or m
+ */
+template <typename T>
+void BasicMatrix<T>::elementwiseMultiply(BasicMatrix& m, BasicMatrix& out) {
+    if (m.getNumRows() != this->getNumRows() || m.getNumCols() != this->getNumCols() ||
+        out.getNumRows() != this->getNumRows() || out.getNumCols() != this->getNumCols()) {
+        std::cerr << "Dimensions mismatch for element-wise multiplication: " << std::endl;
+        assert(false);
     }
+    NN_PROFILE_SCOPE("hadamard", -1, (double)this->numRows * this->numCols);
 
-    return temp;
+    applyBinary(Kernels::ops<T>().mul, *this, m, out);
 }
 
 /**
  * @brief Converts the matrix to a vector
  * @return Vector containing all matrix elements
  */
-std::vector<double> Matrix::toVector() {
-    std::vector<double> v;
-    for (int i = 0; i < this->values.size(); i++) {
-        for (int k = 0; k < this->values.at(i).size(); k++) {
-            v.push_back(values.at(i).at(k));
-        }
+template <typename T>
+std::vector<T> BasicMatrix<T>::toVector() {
+    std::vector<T> v;
+    v.reserve((size_t)this->numRows * this->numCols);
+    for (int i = 0; i < this->numRows; i++) {
+        const T* r = this->rowPtr(i);
+        v.insert(v.end(), r, r + this->numCols);
     }
 
     return v;
 }
+
+/**
+ * @brief Copies the values of a same-shaped matrix of any element type into this one
+ * @param m Matrix to convert from
+ */
+template <typename T>
+template <typename U>
+void BasicMatrix<T>::convertFrom(const BasicMatrix<U>& m) {
+    if (this->numRows != m.getNumRows() || this->numCols != m.getNumCols()) {
+        std::cerr << "Rows and Column sizes mismatch: " << std::endl;
+        assert(false);
+    }
+
+    auto body = [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            const U* src = m.rowPtr((int)i);
+            T* dst = this->rowPtr((int)i);
+            for (int k = 0; k < this->numCols; k++) {
+                dst[k] = (T)src[k];
+            }
+        }
+    };
+    ThreadPool::global().parallelFor(0, this->numRows, (size_t)this->numRows * this->numCols, body);
+}
+
+template class BasicMatrix<double>;
+template class BasicMatrix<float>;
+
+template void BasicMatrix<double>::convertFrom(const BasicMatrix<double>&);
+template void BasicMatrix<double>::convertFrom(const BasicMatrix<float>&);
+template void BasicMatrix<float>::convertFrom(const BasicMatrix<double>&);
+template void BasicMatrix<float>::convertFrom(const BasicMatrix<float>&);
@@ -0,0 +1,364 @@
+#include <fstream>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../include/ModelFile.hpp"
+
+using namespace std;
+
+#define FNV_PRIME 1099511628211ull
+
+static_assert(sizeof(ModelFileHeader) == 64, "ModelFileHeader must stay 64 bytes");
+
+/**
+ * @brief Rounds a byte offset up to MODEL_FILE_ALIGNMENT
+ */
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + MODEL_FILE_ALIGNMENT - 1) / MODEL_FILE_ALIGNMENT * MODEL_FILE_ALIGNMENT;
+}
+
+/**
+ * @brief Maps and validates a binary model file
+ * @param path Path to the model file
+ */
+ModelFile::ModelFile(const string& path) {
+    this->base = nullptr;
+    this->size = 0;
+
+#ifdef _WIN32
+    // No mmap: read the file into an aligned buffer instead
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open()) {
+        throw runtime_error("Could not open model file: " + path);
+    }
+    this->size = (size_t)file.tellg();
+    this->base = static_cast<unsigned char*>(Matrix::alignedAlloc(this->size));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(this->base), this->size);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Could not open model file: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ModelFileHeader)) {
+        close(fd);
+        throw runtime_error("Model file is too small to be a binary model: " + path);
+    }
+    this->size = (size_t)st.st_size;
+
+    // Private mapping: writes to the weights stay in this process
+    void* p = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        throw runtime_error("Could not map model file: " + path);
+    }
+    this->base = static_cast<unsigned char*>(p);
+#endif
+
+    // The destructor does not run for a constructor that throws
+    try {
+        this->validate(path);
+    }
+    catch (...) {
+        this->unmap();
+        throw;
+    }
+}
+
+/**
+ * @brief Destructor, unmaps the file
+ */
+ModelFile::~ModelFile() {
+    this->unmap();
+}
+
+/**
+ * @brief Releases the mapping
+ */
+void ModelFile::unmap() {
+#ifdef _WIN32
+    Matrix::alignedFree(this->base);
+#else
+    if (this->base != nullptr) {
+        munmap(this->base, this->size);
+    }
+#endif
+    this->base = nullptr;
+}
+
+/**
+ * @brief Validates the header, topology and tensor table and reads them
+ *
+ * Every tensor must sit at exactly the offset the writer gives it, so a table or
+ * topology that disagrees with the data is rejected even in files whose checksum
+ * does not cover the tables.
+ */
+void ModelFile::validate(const string& path) {
+    const ModelFileHeader* h = this->header();
+
+    if (this->size < sizeof(ModelFileHeader) || memcmp(h->magic, MODEL_FILE_MAGIC, sizeof(MODEL_FILE_MAGIC)) != 0) {
+        throw runtime_error("Not a binary model file: " + path);
+    }
+    if (h->byteOrder != MODEL_FILE_BYTE_ORDER) {
+        throw runtime_error("Model file was written with a different byte order: " + path);
+    }
+    if (h->version < 1 || h->version > MODEL_FILE_VERSION) {
+        throw runtime_error("Unsupported model file version " + to_string(h->version) + ": " + path);
+    }
+    if (h->dtype != MODEL_FLOAT64 && h->dtype != MODEL_FLOAT32) {
+        throw runtime_error("Unsupported model data type " + to_string(h->dtype) + ": " + path);
+    }
+    if (h->fileSize != this->size) {
+        throw runtime_error("Model file is truncated, expected " + to_string(h->fileSize) + " bytes but found "
+                            + to_string(this->size) + ": " + path);
+    }
+
+    const uint64_t numTensors = 2 * (uint64_t)h->numLayers - 1;
+    const uint64_t layerTables = h->version >= 2 ? 2 : 1;
+    const uint64_t tableEnd = sizeof(ModelFileHeader) + layerTables * sizeof(uint32_t) * h->numLayers + sizeof(uint64_t) * numTensors;
+    if (h->numLayers == 0 || h->dataOffset != alignOffset(tableEnd) || h->dataOffset > this->size) {
+        throw runtime_error("Corrupt model file header: " + path);
+    }
+
+    if (h->version >= 3) {
+        const size_t field = offsetof(ModelFileHeader, checksum);
+        const unsigned char zero[sizeof(h->checksum)] = {0};
+        uint64_t hash = checksum(MODEL_FILE_CHECKSUM_SEED, this->base, field);
+        hash = checksum(hash, zero, sizeof(zero));
+        hash = checksum(hash, this->base + field + sizeof(zero), this->size - field - sizeof(zero));
+        if (hash != h->checksum) {
+            throw runtime_error("Model file checksum mismatch: " + path);
+        }
+    }
+
+    const uint32_t* topology = reinterpret_cast<const uint32_t*>(this->base + sizeof(ModelFileHeader));
+    const uint32_t* activations = topology + h->numLayers;
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(topology + layerTables * h->numLayers);
+    for (uint32_t i = 0; i < h->numLayers; i++) {
+        if (topology[i] == 0 || topology[i] > (uint32_t)INT32_MAX) {
+            throw runtime_error("Invalid layer size " + to_string(topology[i]) + " in model file: " + path);
+        }
+    }
+    this->topology.assign(topology, topology + h->numLayers);
+    this->offsets.assign(offsets, offsets + numTensors);
+
+    this->activations.assign(h->numLayers, ACTIVATION_SOFTSIGN);
+    for (uint32_t i = 0; h->version >= 2 && i < h->numLayers; i++) {
+        if (!Activation::isValid(activations[i])) {
+            throw runtime_error("Unknown activation " + to_string(activations[i]) + " in model file: " + path);
+        }
+        this->activations.at(i) = (ActivationType)activations[i];
+    }
+
+    // Tensors follow each other from dataOffset and the last one ends the file
+    uint64_t expected = h->dataOffset;
+    for (uint64_t t = 0; t < numTensors; t++) {
+        const int layers = h->numLayers;
+        const uint64_t rows = t < (uint64_t)layers - 1 ? this->topology.at(t + 1) : this->topology.at(t - (layers - 1));
+        const uint64_t cols = t < (uint64_t)layers - 1 ? this->topology.at(t) : 1;
+        // rows * cols fits in 62 bits, check it against the file before scaling it to bytes
+        if (this->offsets.at(t) != expected || expected > this->size
+            || rows * cols > (this->size - expected) / this->elementSize()) {
+            throw runtime_error("Corrupt tensor table in model file: " + path);
+        }
+        expected = alignOffset(expected + this->elementSize() * rows * cols);
+    }
+    if (expected != this->size) {
+        throw runtime_error("Corrupt tensor table in model file: " + path);
+    }
+
+    if (h->version < 3 && checksum(MODEL_FILE_CHECKSUM_SEED, this->base + h->dataOffset, this->size - h->dataOffset) != h->checksum) {
+        throw runtime_error("Model file checksum mismatch: " + path);
+    }
+}
+
+/**
+ * @brief Checks whether a file starts with the binary model magic
+ * @param path Path to the model file
+ * @return True for binary model files
+ */
+bool ModelFile::isBinary(const string& path) {
+    ifstream file(path, ios::binary);
+    char magic[sizeof(MODEL_FILE_MAGIC)];
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return memcmp(magic, MODEL_FILE_MAGIC, sizeof(MODEL_FILE_MAGIC)) == 0;
+}
+
+/**
+ * @brief Continues a 64-bit FNV-1a hash over a block of bytes
+ * @param hash Hash so far, MODEL_FILE_CHECKSUM_SEED for the first block
+ * @param data Bytes to hash
+ * @param size Number of bytes
+ * @return Updated hash
+ */
+uint64_t ModelFile::checksum(uint64_t hash, const unsigned char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Writes a model in the binary format
+ * @param path Path to write to
+ * @param topology Neurons per layer
+ * @param activations Activation of each layer
+ * @param learningRate Learning rate of the model
+ * @param weights Weight matrices between layers
+ * @param biases Bias vectors of each layer
+ */
+template <typename T>
+void ModelFile::write(const string& path, const vector<int>& topology, const vector<ActivationType>& activations,
+                      double learningRate, const vector<BasicMatrix<T>*>& weights, const vector<BasicMatrix<T>*>& biases) {
+    if (activations.size() != topology.size()) {
+        throw invalid_argument("Got " + to_string(activations.size()) + " activations for " + to_string(topology.size()) + " layers");
+    }
+
+    vector<BasicMatrix<T>*> tensors(weights);
+    tensors.insert(tensors.end(), biases.begin(), biases.end());
+
+    ModelFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MODEL_FILE_MAGIC, sizeof(MODEL_FILE_MAGIC));
+    h.version = MODEL_FILE_VERSION;
+    h.byteOrder = MODEL_FILE_BYTE_ORDER;
+    h.dtype = ModelDtypeOf<T>::value;
+    h.numLayers = topology.size();
+    h.learningRate = learningRate;
+    h.dataOffset = alignOffset(sizeof(ModelFileHeader) + 2 * sizeof(uint32_t) * topology.size() + sizeof(uint64_t) * tensors.size());
+
+    // Topology then activations, one uint32 per layer each
+    vector<uint32_t> layers(topology.begin(), topology.end());
+    layers.insert(layers.end(), activations.begin(), activations.end());
+    vector<uint64_t> offsets;
+    uint64_t offset = h.dataOffset;
+    for (int t = 0; t < tensors.size(); t++) {
+        offsets.push_back(offset);
+        offset = alignOffset(offset + sizeof(T) * tensors.at(t)->getNumRows() * tensors.at(t)->getNumCols());
+    }
+    h.fileSize = offset;
+
+    // Written aside and renamed: a model loaded from path may still read its weights from the
+    // mapping, and truncating a mapped file faults (SIGBUS) on the pages not yet copied
+    const string temp = path + ".tmp";
+    ofstream file(temp, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("Could not open model file for writing: " + temp);
+    }
+
+    // Header placeholder with a zero checksum, which is also how it is hashed
+    const char padding[MODEL_FILE_ALIGNMENT] = {0};
+    const size_t tablePad = h.dataOffset - (sizeof(h) + sizeof(uint32_t) * layers.size() + sizeof(uint64_t) * offsets.size());
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    file.write(reinterpret_cast<const char*>(layers.data()), sizeof(uint32_t) * layers.size());
+    file.write(reinterpret_cast<const char*>(offsets.data()), sizeof(uint64_t) * offsets.size());
+    file.write(padding, tablePad);
+
+    uint64_t hash = checksum(MODEL_FILE_CHECKSUM_SEED, reinterpret_cast<const unsigned char*>(&h), sizeof(h));
+    hash = checksum(hash, reinterpret_cast<const unsigned char*>(layers.data()), sizeof(uint32_t) * layers.size());
+    hash = checksum(hash, reinterpret_cast<const unsigned char*>(offsets.data()), sizeof(uint64_t) * offsets.size());
+    hash = checksum(hash, reinterpret_cast<const unsigned char*>(padding), tablePad);
+    for (int t = 0; t < tensors.size(); t++) {
+        const BasicMatrix<T>* m = tensors.at(t);
+        const size_t rowBytes = sizeof(T) * m->getNumCols();
+        for (int r = 0; r < m->getNumRows(); r++) {
+            const unsigned char* row = reinterpret_cast<const unsigned char*>(m->rowPtr(r));
+            file.write(reinterpret_cast<const char*>(row), rowBytes);
+            hash = checksum(hash, row, rowBytes);
+        }
+        const uint64_t end = t + 1 < tensors.size() ? offsets.at(t + 1) : h.fileSize;
+        const size_t pad = end - (offsets.at(t) + rowBytes * m->getNumRows());
+        file.write(padding, pad);
+        hash = checksum(hash, reinterpret_cast<const unsigned char*>(padding), pad);
+    }
+
+    h.checksum = hash;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    file.close();
+
+    // A failed or short write (e.g. a full disk) must never replace the previous file
+    if (!file) {
+        remove(temp.c_str());
+        throw runtime_error("Failed writing model file: " + temp);
+    }
+    ModelFile::moveIntoPlace(temp, path);
+}
+
+/**
+ * @brief Renames a completely written temporary file over its target
+ * @param temp Written file, removed if it cannot be moved
+ * @param path Target path
+ * @throws std::runtime_error if the rename fails
+ */
+void ModelFile::moveIntoPlace(const string& temp, const string& path) {
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        remove(temp.c_str());
+        throw runtime_error("Could not move model file into place: " + path);
+    }
+}
+
+/**
+ * @brief Creates a view (or converted copy) of tensor index of the file
+ */
+template <typename T>
+BasicMatrix<T>* ModelFile::tensorView(int index, int rows, int cols) {
+    unsigned char* data = this->base + this->offsets.at(index);
+    if (this->getDtype() == ModelDtypeOf<T>::value) {
+        return new BasicMatrix<T>(reinterpret_cast<T*>(data), rows, cols, cols);
+    }
+
+    BasicMatrix<T>* m = new BasicMatrix<T>(rows, cols, false);
+    if (this->getDtype() == MODEL_FLOAT64) {
+        m->convertFrom(Matrix(reinterpret_cast<double*>(data), rows, cols, cols));
+    }
+    else {
+        m->convertFrom(MatrixF(reinterpret_cast<float*>(data), rows, cols, cols));
+    }
+    return m;
+}
+
+/**
+ * @brief Creates a view of a weight matrix in the mapping
+ * @param index Weight matrix index
+ * @return New matrix (topology[index + 1] x topology[index])
+ */
+template <typename T>
+BasicMatrix<T>* ModelFile::weightView(int index) {
+    return this->tensorView<T>(index, this->topology.at(index + 1), this->topology.at(index));
+}
+
+/**
+ * @brief Creates a view of a bias vector in the mapping
+ * @param index Layer index
+ * @return New matrix (topology[index] x 1)
+ */
+template <typename T>
+BasicMatrix<T>* ModelFile::biasView(int index) {
+    return this->tensorView<T>(this->topology.size() - 1 + index, this->topology.at(index), 1);
+}
+
+template void ModelFile::write(const string&, const vector<int>&, const vector<ActivationType>&, double,
+                               const vector<Matrix*>&, const vector<Matrix*>&);
+template void ModelFile::write(const string&, const vector<int>&, const vector<ActivationType>&, double,
+                               const vector<MatrixF*>&, const vector<MatrixF*>&);
+template Matrix* ModelFile::weightView<double>(int);
+template MatrixF* ModelFile::weightView<float>(int);
+template Matrix* ModelFile::biasView<double>(int);
+template MatrixF* ModelFile::biasView<float>(int);
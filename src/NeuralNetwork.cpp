@@ -1,12 +1,17 @@
 #include <vector>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <stdexcept>
 #include <string>
 #include "../include/NeuralNetwork.hpp"
 #include "../include/Layer.hpp"
 #include "../include/Matrix.hpp"
+#include "../include/Gemm.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/TextModelReader.hpp"
 
 using namespace std;
 
@@ -14,102 +19,186 @@ using namespace std;
  * @brief Constructor for creating a new neural network
  * @param topology Vector of integers representing the number of neurons in each layer
  * @param learningRate Learning rate for training
+ * @param init Weight initialization scheme
+ * @param seed Seed of the weights, 0 to take the next seed of Initializer's global sequence
  */
 
-NeuralNetwork::NeuralNetwork(vector<int> topology, double learningRate) {
+template <typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(vector<int> topology, double learningRate, InitScheme init, uint64_t seed) {
 	this->topologySize = topology.size();
 	this->topology = topology;
 	this->learningRate = learningRate;
+	this->batchSize = 0;
+	this->batchCapacity = 0;
+	this->batchOnes = NULL;
+	this->batchTargets = NULL;
+	this->batchOnesStorage = NULL;
+	this->batchTargetsStorage = NULL;
+	this->batchInput = NULL;
+	this->modelFile = NULL;
 
 	for (int i = 0; i < topology.size(); i++) {
-		Layer *l = new Layer(topology.at(i));
-		Matrix *b = new Matrix(topology.at(i), 1, false);
+		BasicLayer<T> *l = new BasicLayer<T>(topology.at(i));
+		BasicMatrix<T> *b = new BasicMatrix<T>(topology.at(i), 1, false);
 		this->biasMatrices.push_back(b);
 		this->layers.push_back(l);
 	}
 
 	for (int i = 0; i < this->topologySize - 1; i++) {
-		Matrix *m = new Matrix(topology.at(i + 1), topology.at(i), true);
+		BasicMatrix<T> *m = new BasicMatrix<T>(topology.at(i + 1), topology.at(i), false);
 		this->weightMatrices.push_back(m);
 	}
 
+	this->allocateWorkspaces(this->workspaces, 1, true);
+	this->allocateGradients();
+	this->initializeWeights(init, seed);
 }
 
-NeuralNetwork::NeuralNetwork(const string& path) {
-	ifstream model(path);
-	string chunk;
-	string temp;
+template <typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(const string& path) {
+	this->batchSize = 0;
+	this->batchCapacity = 0;
+	this->batchOnes = NULL;
+	this->batchTargets = NULL;
+	this->batchOnesStorage = NULL;
+	this->batchTargetsStorage = NULL;
+	this->batchInput = NULL;
+	this->modelFile = NULL;
+	vector<ActivationType> activations;
+
+	if (ModelFile::isBinary(path)) {
+		// Weights and biases are views into the mapped file
+		this->modelFile = new ModelFile(path);
+		this->topology = this->modelFile->getTopology();
+		this->topologySize = this->topology.size();
+		this->learningRate = this->modelFile->getLearningRate();
+		activations = this->modelFile->getActivations();
 
-	if (model.is_open()) {
-		// Setting up topology 
-		vector<int> topology;
-	
-		getline(model, chunk, ';');
-		stringstream topologyChunk(chunk);
+		for (int i = 0; i < this->topologySize - 1; i++) {
+			this->weightMatrices.push_back(this->modelFile->template weightView<T>(i));
+		}
+		for (int i = 0; i < this->topologySize; i++) {
+			this->biasMatrices.push_back(this->modelFile->template biasView<T>(i));
+		}
 
-		while(getline(topologyChunk, temp, ',')) {
-			topology.push_back(stoi(temp));
+		// A file of another dtype was converted into owning matrices, the mapping is not needed
+		if (this->modelFile->getDtype() != this->getDtype()) {
+			delete this->modelFile;
+			this->modelFile = NULL;
 		}
-	
-		this->topology = topology;
-		this->topologySize = this->topology.size();
-		
-		// setting up weights
-		for (int i = 0; i < this->topologySize - 1; i++) {
-			getline(model, chunk, ';');
-			stringstream weightsChunk(chunk);
-			Matrix *m = new Matrix(topology.at(i + 1), topology.at(i), false);
-			for (int k = 0; k < m->getNumRows(); k++) {
-				for (int l = 0; l < m->getNumCols(); l++) {
-					getline(weightsChunk, temp, ',');
-					m->setVal(k, l, stod(temp));
-				}
-			}
-			this->weightMatrices.push_back(m);
+	}
+	else {
+		this->loadText(path, activations);
+	}
+
+	// Creating Layers
+	for (int i = 0; i < this->topologySize; i++) {
+		BasicLayer<T> *l = new BasicLayer<T>(this->topology.at(i), activations.at(i));
+		this->layers.push_back(l);
+	}
+
+	this->allocateWorkspaces(this->workspaces, 1, true);
+	this->allocateGradients();
+	this->resetOptimizer();
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::loadText(const string& path, vector<ActivationType>& activations) {
+	TextModelReader model(path);
+	try {
+		this->readText(model, activations);
+	}
+	catch (...) {
+		// The constructor did not complete, so the destructor will not free these
+		for (int i = 0; i < this->weightMatrices.size(); i++) {
+			delete this->weightMatrices.at(i);
+		}
+		for (int i = 0; i < this->biasMatrices.size(); i++) {
+			delete this->biasMatrices.at(i);
 		}
+		throw;
+	}
+}
 
-		// Setting up biases
-		for (int i = 0; i < this->topologySize; i++) {
-			getline(model, chunk, ';');
-			stringstream biasesChunk(chunk);
-			Matrix *m = new Matrix(topology.at(i), 1, false);
-			for (int k = 0; k < m->getNumRows(); k++) {
-				for (int l = 0; l < m->getNumCols(); l++) {
-					getline(biasesChunk, temp, ',');
-					m->setVal(k, l, stod(temp));
-				}
-			}
-			this->biasMatrices.push_back(m);
+template <typename T>
+void BasicNeuralNetwork<T>::readText(TextModelReader& model, vector<ActivationType>& activations) {
+	char delimiter = ',';
 
-		
+	// Setting up topology
+	while (delimiter == ',') {
+		double size = model.next(delimiter);
+		if (size < 1 || size != (int)size) {
+			model.fail("layer sizes must be positive integers");
 		}
+		this->topology.push_back((int)size);
+	}
+	this->topologySize = this->topology.size();
 
-		// setting up learning rate (eventho not needed)
-		getline(model, chunk, ';');
-		this->learningRate = stod(chunk);
+	// setting up weights
+	for (int i = 0; i < this->topologySize - 1; i++) {
+		BasicMatrix<T> *m = new BasicMatrix<T>(this->topology.at(i + 1), this->topology.at(i), false);
+		model.readMatrix(*m);
+		this->weightMatrices.push_back(m);
+	}
+
+	// Setting up biases
+	for (int i = 0; i < this->topologySize; i++) {
+		BasicMatrix<T> *m = new BasicMatrix<T>(this->topology.at(i), 1, false);
+		model.readMatrix(*m);
+		this->biasMatrices.push_back(m);
+	}
 
-		// Creating Layers
+	// setting up learning rate (eventho not needed)
+	this->learningRate = model.nextBefore(';');
+
+	// Activations, missing from files written before they were configurable
+	activations.assign(this->topologySize, ACTIVATION_SOFTSIGN);
+	if (!model.atEnd()) {
 		for (int i = 0; i < this->topologySize; i++) {
-			Layer *l = new Layer(this->topology.at(i));
-			this->layers.push_back(l);
+			double id = model.nextBefore(i != this->topologySize - 1 ? ',' : ';');
+			if (!Activation::isValid((long long)id) || id != (long long)id) {
+				model.fail("unknown activation");
+			}
+			activations.at(i) = (ActivationType)(int)id;
 		}
 	}
-	model.close();
+	model.expectEnd();
 }
 
-NeuralNetwork::~NeuralNetwork() {
+template <typename T>
+BasicNeuralNetwork<T>::~BasicNeuralNetwork() {
+	this->setMasterWeights(false);
 	for (int i = 0; i < this->layers.size(); i++) {
-		this->layers.at(i)->cleanup();
 		delete this->biasMatrices.at(i);
+		delete this->biasGradients.at(i);
 		delete layers.at(i);
 	}
 	for (int i = 0; i < this->weightMatrices.size(); i++) {
 		delete this->weightMatrices.at(i);
+		delete this->weightGradients.at(i);
 	}
+	this->freeWorkspaces(this->workspaces);
+	this->clearBatch();
+	delete this->modelFile;
 }
 
-void NeuralNetwork::saveModel(const string& path) {
-	ofstream file(path);	
+template <typename T>
+void BasicNeuralNetwork<T>::saveModel(const string& path, ModelFormat format) {
+	if (format == MODEL_TEXT) {
+		this->saveText(path);
+	}
+	else {
+		ModelFile::write(path, this->topology, this->getActivations(), this->learningRate, this->weightMatrices, this->biasMatrices);
+	}
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::saveText(const string& path) {
+	// Written aside and renamed like binary models, the weights may be mapped from path
+	const string temp = path + ".tmp";
+	ofstream file(temp);
+	// Enough digits for every double to read back unchanged
+	file.precision(17);
 
 	if (file.is_open()) {
 		for ( int i = 0; i < this->topologySize; i++) {
@@ -123,7 +212,7 @@ void NeuralNetwork::saveModel(const string& path) {
 			
 		}
 		for (int i = 0; i < this->topologySize - 1; i++) {
-			Matrix *wM = this->getWeightMatrix(i);
+			BasicMatrix<T> *wM = this->getWeightMatrix(i);
 
 			for (int k = 0; k < wM->getNumRows(); k++) {
 				for (int l = 0; l < wM->getNumCols(); l++) {
@@ -138,7 +227,7 @@ void NeuralNetwork::saveModel(const string& path) {
 			}
 		}
 		for (int i = 0; i < this->topologySize; i++) {
-			Matrix *wB = this->getBiasMatrix(i);
+			BasicMatrix<T> *wB = this->getBiasMatrix(i);
 
 			for (int k = 0; k < wB->getNumRows(); k++) {
 				for (int l = 0; l < wB->getNumCols(); l++) {
@@ -153,139 +242,583 @@ void NeuralNetwork::saveModel(const string& path) {
 			}
 		}
 		file << this->learningRate << ";";
+		for (int i = 0; i < this->topologySize; i++) {
+			file << (int)this->getActivation(i) << (i != this->topologySize - 1 ? "," : ";");
+		}
 	}
 	file.close();
+
+	if (!file) {
+		remove(temp.c_str());
+		throw runtime_error("Failed writing model file: " + temp);
+	}
+	ModelFile::moveIntoPlace(temp, path);
 }
 
-Matrix *NeuralNetwork::predict(vector<double> input) {
+template <typename T>
+BasicMatrix<T> *BasicNeuralNetwork<T>::predict(vector<double> input) {
 	this->setCurrentInput(input);
 	this->feedForward();
 
 	return this->layers.at(this->layers.size() - 1)->matrixifyVals();
 }
 
-void NeuralNetwork::feedForward() {
-	for (int i = 0; i < (this->layers.size() - 1); i++) {
-		Matrix *a;
+template <typename T>
+void BasicNeuralNetwork<T>::trainBatch(const vector<vector<double>>& inputs, const vector<vector<double>>& targets) {
+	this->computeGradients(inputs, targets);
+	this->applyGradients();
+}
 
-		if (i != 0) {
-			a = this->getActivatedNeuronMatrix(i);
-		}	
+template <typename T>
+void BasicNeuralNetwork<T>::computeGradients(const vector<vector<double>>& inputs, const vector<vector<double>>& targets) {
+	if (inputs.size() != targets.size()) {
+		cerr << "Batch has " << inputs.size() << " inputs but " << targets.size() << " targets" << endl;
+		assert(false);
+	}
+
+	this->setBatchInput(inputs);
+	this->setBatchTargets(targets);
+	this->feedForwardBatch();
+	this->backPropogateBatch(*this->batchTargets);
+}
+
+template <typename T>
+double BasicNeuralNetwork<T>::evaluate(const vector<vector<double>>& inputs, const vector<vector<double>>& targets) {
+	if (inputs.size() != targets.size()) {
+		cerr << "Batch has " << inputs.size() << " inputs but " << targets.size() << " targets" << endl;
+		assert(false);
+	}
+
+	this->setBatchInput(inputs);
+	this->setBatchTargets(targets);
+	this->feedForwardBatch();
+	return this->batchError(*this->batchTargets);
+}
+
+template <typename T>
+double BasicNeuralNetwork<T>::evaluate(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets) {
+	this->setBatchInput(inputs, targets);
+	this->feedForwardBatch();
+	return this->batchError(targets);
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::trainBatch(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets) {
+	this->computeGradients(inputs, targets);
+	this->applyGradients();
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::computeGradients(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets) {
+	this->setBatchInput(inputs, targets);
+	this->feedForwardBatch();
+	this->backPropogateBatch(targets);
+}
+
+template <typename T>
+BasicMatrix<T> *BasicNeuralNetwork<T>::predictBatch(const vector<vector<double>>& inputs) {
+	this->setBatchInput(inputs);
+	this->feedForwardBatch();
+
+	return new BasicMatrix<T>(*this->batchWorkspaces.at(this->topologySize - 1).vals);
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::allocateWorkspaces(vector<LayerWorkspace<T> >& workspaces, int columns, bool bindLayers) {
+	for (int i = 0; i < this->topologySize; i++) {
+		LayerWorkspace<T> ws;
+		int size = this->topology.at(i);
+		if (bindLayers) {
+			// Views straight onto the layer's arrays, nothing to copy in or out
+			BasicLayer<T> *l = this->layers.at(i);
+			ws.vals = new BasicMatrix<T>(l->getVals().getData(), size, 1, 1);
+			ws.activated = new BasicMatrix<T>(l->getActivatedVals().getData(), size, 1, 1);
+			ws.derived = new BasicMatrix<T>(l->getDerivedVals().getData(), size, 1, 1);
+		}
 		else {
-			a = this->getNeuronMatrix(i);
+			ws.vals = new BasicMatrix<T>(size, columns, false);
+			ws.activated = new BasicMatrix<T>(size, columns, false);
+			ws.derived = new BasicMatrix<T>(size, columns, false);
 		}
+		ws.delta = new BasicMatrix<T>(size, columns, false);
+		workspaces.push_back(ws);
+	}
+}
 
-		Matrix *b = this->getWeightMatrix(i);
-		Matrix *d = this->getBiasMatrix(i + 1);
+template <typename T>
+void BasicNeuralNetwork<T>::freeWorkspaces(vector<LayerWorkspace<T> >& workspaces) {
+	for (int i = 0; i < workspaces.size(); i++) {
+		LayerWorkspace<T>& ws = workspaces.at(i);
+		delete ws.vals;
+		delete ws.activated;
+		delete ws.derived;
+		delete ws.delta;
+	}
+	workspaces.clear();
+}
 
+/**
+ * @brief Points a view at the leading columns of a buffer, creating the view the first time
+ */
+template <typename T>
+static void viewColumns(BasicMatrix<T>*& view, BasicMatrix<T>* storage, int columns) {
+	BasicMatrix<T> v(storage->getData(), storage->getNumRows(), columns, storage->getStride());
+	if (view == NULL) {
+		view = new BasicMatrix<T>(std::move(v));
+	}
+	else {
+		*view = std::move(v);
+	}
+}
 
-		Matrix *e = *b * *a;
-		Matrix *c = *e + *d;
+template <typename T>
+void BasicNeuralNetwork<T>::prepareBatch(int size) {
+	if (size == this->batchSize) {
+		return;
+	}
 
-		for (int k = 0; k < c->getNumRows(); k++) {
-			this->setNeuronValue(i + 1, k, c->getVal(k, 0));
+	// Buffers only grow, smaller batches (validation, the last batch of an epoch) use their leading columns
+	if (size > this->batchCapacity) {
+		this->clearBatch();
+		this->allocateWorkspaces(this->batchStorage, size, false);
+		this->batchWorkspaces.assign(this->topologySize, LayerWorkspace<T>());
+		this->batchOnesStorage = new BasicMatrix<T>(size, 1, false);
+		for (int i = 0; i < size; i++) {
+			this->batchOnesStorage->at(i, 0) = 1.0;
 		}
+		this->batchTargetsStorage = new BasicMatrix<T>(this->topology.back(), size, false);
+		this->batchCapacity = size;
+	}
 
-		delete a;
-		delete e;
-		delete c;
-	} 
+	for (int i = 0; i < this->topologySize; i++) {
+		LayerWorkspace<T>& storage = this->batchStorage.at(i);
+		LayerWorkspace<T>& ws = this->batchWorkspaces.at(i);
+		viewColumns(ws.vals, storage.vals, size);
+		viewColumns(ws.activated, storage.activated, size);
+		viewColumns(ws.derived, storage.derived, size);
+		viewColumns(ws.delta, storage.delta, size);
+	}
+	viewColumns(this->batchTargets, this->batchTargetsStorage, size);
+	// The column of ones is cut by rows
+	BasicMatrix<T> ones(this->batchOnesStorage->getData(), size, 1, 1);
+	if (this->batchOnes == NULL) {
+		this->batchOnes = new BasicMatrix<T>(std::move(ones));
+	}
+	else {
+		*this->batchOnes = std::move(ones);
+	}
+	this->batchSize = size;
 }
 
-void NeuralNetwork::backPropogate() {
-	this->setErrors();
+template <typename T>
+void BasicNeuralNetwork<T>::clearBatch() {
+	// Views first, then the buffers they point into
+	this->freeWorkspaces(this->batchWorkspaces);
+	this->freeWorkspaces(this->batchStorage);
+	delete this->batchOnes;
+	delete this->batchTargets;
+	delete this->batchOnesStorage;
+	delete this->batchTargetsStorage;
+	this->batchOnes = NULL;
+	this->batchTargets = NULL;
+	this->batchOnesStorage = NULL;
+	this->batchTargetsStorage = NULL;
+	this->batchInput = NULL;
+	this->batchSize = 0;
+	this->batchCapacity = 0;
+}
 
-	// Hidden -> Output
-	int outputLayerIndex = this->layers.size() - 1;
-	int lastHiddenLayerIndex = outputLayerIndex - 1;
-	Matrix *output = this->layers.at(outputLayerIndex)->matrixifyVals();
+template <typename T>
+void BasicNeuralNetwork<T>::setBatchInput(const vector<vector<double>>& inputs) {
+	if (inputs.size() == 0) {
+		cerr << "Batch is empty!." << endl;
+		assert(false);
+	}
+
+	this->prepareBatch(inputs.size());
+
+	BasicMatrix<T> *x = this->batchWorkspaces.at(0).vals;
+	for (int k = 0; k < inputs.size(); k++) {
+		if (inputs.at(k).size() != x->getNumRows()) {
+			cerr << "Batch input " << k << " is not same size that of the input layer size: " << endl;
+			assert(false);
+		}
+		for (int i = 0; i < x->getNumRows(); i++) {
+			x->at(i, k) = inputs.at(k).at(i);
+		}
+	}
+	this->batchInput = x;
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::setBatchTargets(const vector<vector<double>>& targets) {
+	BasicMatrix<T> *t = this->batchTargets;
+	for (int k = 0; k < targets.size(); k++) {
+		if (targets.at(k).size() != t->getNumRows()) {
+			cerr << "Target is not same size that of the output layer size: " << endl;
+			assert(false);
+		}
+		for (int r = 0; r < t->getNumRows(); r++) {
+			t->at(r, k) = targets.at(k).at(r);
+		}
+	}
+}
+
+template <typename T>
+double BasicNeuralNetwork<T>::batchError(const BasicMatrix<T>& targets) {
+	const BasicMatrix<T> *out = this->batchWorkspaces.at(this->topologySize - 1).activated;
+	double sum = 0.0;
+	for (int r = 0; r < out->getNumRows(); r++) {
+		for (int k = 0; k < this->batchSize; k++) {
+			sum += 0.5 * pow(out->at(r, k) - targets.at(r, k), 2);
+		}
+	}
+	return sum / this->batchSize;
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::setBatchInput(const BasicMatrix<T>& inputs, const BasicMatrix<T>& targets) {
+	if (inputs.getNumCols() == 0) {
+		cerr << "Batch is empty!." << endl;
+		assert(false);
+	}
+	if (inputs.getNumRows() != this->topology.front() || targets.getNumRows() != this->topology.back()) {
+		cerr << "Batch matrices do not match the input and output layer sizes: " << endl;
+		assert(false);
+	}
+	if (targets.getNumCols() != inputs.getNumCols()) {
+		cerr << "Batch has " << inputs.getNumCols() << " inputs but " << targets.getNumCols() << " targets" << endl;
+		assert(false);
+	}
+
+	this->prepareBatch(inputs.getNumCols());
+	this->batchInput = &inputs;
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::feedForwardBatch() {
+	NN_PROFILE_SCOPE("feedForward", -1, 0);
+	for (int i = 0; i < this->topologySize - 1; i++) {
+		// Same as the per-sample pass: the input layer feeds raw values, hidden layers activated ones
+		LayerWorkspace<T>& in = this->batchWorkspaces.at(i);
+		LayerWorkspace<T>& out = this->batchWorkspaces.at(i + 1);
+		const BasicMatrix<T> *a = i != 0 ? in.activated : this->batchInput;
+		NN_PROFILE_SCOPE("forward", i + 1, 2.0 * out.vals->getNumRows() * a->getNumRows() * a->getNumCols());
+
+		Gemm::multiplyBiasActivate(*this->getWeightMatrix(i), *a, *this->getBiasMatrix(i + 1), this->getActivation(i + 1),
+			*out.vals, out.activated, out.derived);
+	}
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::backPropogateBatch(const BasicMatrix<T>& targets) {
+	NN_PROFILE_SCOPE("computeGradients", -1, 0);
+	int outputLayerIndex = this->topologySize - 1;
+	LayerWorkspace<T>& out = this->batchWorkspaces.at(outputLayerIndex);
+	const double scale = 1.0 / this->batchSize;
+
+	// Output error: delta = (output - target) * f'(output), as in backPropogate
+	{
+		NN_PROFILE_SCOPE("setErrors", outputLayerIndex, 0);
+		this->errors.assign(out.vals->getNumRows(), 0.0);
+		this->error = 0.0;
+		for (int k = 0; k < this->batchSize; k++) {
+			for (int r = 0; r < out.vals->getNumRows(); r++) {
+				const double t = targets.at(r, k);
+				double tempErr = 0.5 * pow(out.activated->at(r, k) - t, 2) * scale;
+				this->errors.at(r) += tempErr;
+				this->error += tempErr;
+				out.delta->at(r, k) = (out.vals->at(r, k) - t) * out.derived->at(r, k);
+			}
+		}
+		this->historicalErrors.push_back(this->error);
+	}
+
+	this->accumulateGradients(this->batchWorkspaces, *this->batchInput, this->batchOnes);
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::accumulateGradients(vector<LayerWorkspace<T> >& workspaces, const BasicMatrix<T>& input, BasicMatrix<T> *ones) {
+	int outputLayerIndex = this->topologySize - 1;
+
+	for (int i = outputLayerIndex - 1; i >= 0; i--) {
+		LayerWorkspace<T>& ws = workspaces.at(i);
+		LayerWorkspace<T>& next = workspaces.at(i + 1);
+		const BasicMatrix<T> *vals = i != 0 ? ws.activated : &input;
+		NN_PROFILE_SCOPE("backward", i + 1, (i != 0 ? 4.0 : 2.0) * next.delta->getNumRows() * vals->getNumRows() * vals->getNumCols());
+
+		// Gradients summed over the samples straight into the buffers, delta * vals^T
+		Gemm::multiply(*next.delta, *vals, *this->weightGradients.at(i), true, GEMM_NO_TRANSPOSE, GEMM_TRANSPOSE);
+		if (ones != NULL) {
+			Gemm::multiply(*next.delta, *ones, *this->biasGradients.at(i + 1), true);
+		}
+		else {
+			this->biasGradients.at(i + 1)->axpy(1.0, *next.delta);
+		}
+
+		// Delta of the layer (the input layer needs none), weights^T * delta read in place
+		if (i != 0) {
+			Gemm::multiply(*this->getWeightMatrix(i), *next.delta, *ws.delta, false, GEMM_TRANSPOSE, GEMM_NO_TRANSPOSE);
+			ws.delta->elementwiseMultiply(*ws.derived, *ws.delta);
+		}
+	}
+	this->accumulatedSamples += ones != NULL ? ones->getNumRows() : 1;
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::applyGradients() {
+	if (this->accumulatedSamples == 0) {
+		return;
+	}
+
+	// The buffers hold sums, the update uses their mean
+	NN_PROFILE_SCOPE("applyGradients", -1, 0);
+	const double scale = 1.0 / this->accumulatedSamples;
+	if (this->masters.empty()) {
+		this->optimizer.beginStep();
+	}
+	else {
+		this->masterOptimizer.beginStep();
+	}
+	for (int i = 0; i < this->topologySize - 1; i++) {
+		NN_PROFILE_SCOPE("update", i + 1, 0);
+		this->applyUpdate(i, *this->weightMatrices.at(i), *this->weightGradients.at(i), scale);
+	}
+	// The input layer's bias is never used, so it has no gradient
+	for (int i = 1; i < this->topologySize; i++) {
+		NN_PROFILE_SCOPE("update", i, 0);
+		this->applyUpdate(this->topologySize - 1 + i, *this->biasMatrices.at(i), *this->biasGradients.at(i), scale);
+	}
+	this->clearGradients();
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::allocateGradients() {
+	for (int i = 0; i < this->topologySize - 1; i++) {
+		this->weightGradients.push_back(new BasicMatrix<T>(this->topology.at(i + 1), this->topology.at(i), false));
+	}
+	for (int i = 0; i < this->topologySize; i++) {
+		this->biasGradients.push_back(new BasicMatrix<T>(this->topology.at(i), 1, false));
+	}
+	this->accumulatedSamples = 0;
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::clearGradients() {
+	for (int i = 0; i < this->weightGradients.size(); i++) {
+		BasicMatrix<T> *g = this->weightGradients.at(i);
+		memset(g->getData(), 0, sizeof(T) * g->getNumRows() * g->getNumCols());
+	}
+	for (int i = 0; i < this->biasGradients.size(); i++) {
+		BasicMatrix<T> *g = this->biasGradients.at(i);
+		memset(g->getData(), 0, sizeof(T) * g->getNumRows() * g->getNumCols());
+	}
+	this->accumulatedSamples = 0;
+}
+
+template <typename T>
+double BasicNeuralNetwork<T>::getGradientNorm() {
+	if (this->accumulatedSamples == 0) {
+		return 0.0;
+	}
+
+	double sum = 0.0;
+	for (int p = 0; p < 2 * this->topologySize - 1; p++) {
+		BasicMatrix<T> *g = p < this->topologySize - 1 ? this->weightGradients.at(p) : this->biasGradients.at(p - (this->topologySize - 1));
+		const T *data = g->getData();
+		const size_t n = (size_t)g->getNumRows() * g->getNumCols();
+		for (size_t k = 0; k < n; k++) {
+			sum += (double)data[k] * data[k];
+		}
+	}
+	return sqrt(sum) / this->accumulatedSamples;
+}
 
-	Matrix *target = new Matrix(output->getNumRows(), 1, false);
-	for (int i = 0; i < output->getNumRows(); i++) {
-		target->setVal(i, 0, this->target.at(i));
+template <typename T>
+double BasicNeuralNetwork<T>::clipGradients(double maxNorm) {
+	const double norm = this->getGradientNorm();
+	if (norm > maxNorm) {
+		const double factor = maxNorm / norm;
+		for (int i = 0; i < this->weightGradients.size(); i++) {
+			this->weightGradients.at(i)->scalarMultiply(factor);
+		}
+		for (int i = 0; i < this->biasGradients.size(); i++) {
+			this->biasGradients.at(i)->scalarMultiply(factor);
+		}
+	}
+	return norm;
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::initializeWeights(InitScheme scheme, uint64_t seed) {
+	if (seed == 0) {
+		seed = Initializer::nextSeed();
+	}
+	for (int i = 0; i < this->topologySize - 1; i++) {
+		Initializer::initialize(*this->weightMatrices.at(i), scheme, seed, i);
+		this->refreshMaster(i, this->weightMatrices.at(i));
+	}
+	for (int i = 0; i < this->topologySize; i++) {
+		BasicMatrix<T> *b = this->biasMatrices.at(i);
+		memset(b->getData(), 0, sizeof(T) * b->getNumRows() * b->getNumCols());
+		this->refreshMaster(this->topologySize - 1 + i, b);
+	}
+	this->clearGradients();
+	this->resetOptimizer();
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::setActivations(const vector<ActivationType>& activations) {
+	if (activations.size() != this->topologySize) {
+		cerr << "Got " << activations.size() << " activations for " << this->topologySize << " layers" << endl;
+		assert(false);
+	}
+	for (int i = 0; i < this->topologySize; i++) {
+		this->setActivation(i, activations.at(i));
 	}
+}
 
-	Matrix *derivedVals = this->layers.at(outputLayerIndex)->matrixifyDerivedVals();
-	Matrix *error = *output - *target;
+template <typename T>
+vector<ActivationType> BasicNeuralNetwork<T>::getActivations() const {
+	vector<ActivationType> activations;
+	for (int i = 0; i < this->topologySize; i++) {
+		activations.push_back(this->getActivation(i));
+	}
+	return activations;
+}
 
-	Matrix *delta = error->elementwiseMultiply(derivedVals);
+template <typename T>
+void BasicNeuralNetwork<T>::applyUpdate(int index, BasicMatrix<T>& param, BasicMatrix<T>& gradient, double gradientScale) {
+	if (this->masters.empty()) {
+		this->optimizer.update(index, param, gradient, this->learningRate, gradientScale);
+		return;
+	}
 
+	MasterParameter& m = this->masters.at(index);
+	m.gradient->convertFrom(gradient);
+	this->masterOptimizer.update(index, *m.value, *m.gradient, this->learningRate, gradientScale);
+	param.convertFrom(*m.value);
+}
 
-	// cleanup from HIDDEN->OUTPUT
-	delete error;
-	delete derivedVals;
-	delete target;
-	delete output;
+template <typename T>
+void BasicNeuralNetwork<T>::setOptimizer(const OptimizerConfig& config) {
+	this->optimizer.setConfig(config);
+	this->masterOptimizer.setConfig(config);
+	this->resetOptimizer();
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::resetOptimizer() {
+	const int numWeights = this->topologySize - 1;
+	if (this->masters.empty()) {
+		vector<BasicMatrix<T>*> params(this->weightMatrices);
+		params.insert(params.end(), this->biasMatrices.begin(), this->biasMatrices.end());
+		this->optimizer.reset(params, numWeights);
+		this->masterOptimizer.clear();
+	}
+	else {
+		vector<Matrix*> params;
+		for (int i = 0; i < this->masters.size(); i++) {
+			params.push_back(this->masters.at(i).value);
+		}
+		this->masterOptimizer.reset(params, numWeights);
+		this->optimizer.clear();
+	}
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::setMasterWeights(bool enabled) {
+	if (!enabled || ModelDtypeOf<T>::value == MODEL_FLOAT64) {
+		for (int i = 0; i < this->masters.size(); i++) {
+			delete this->masters.at(i).value;
+			delete this->masters.at(i).gradient;
+		}
+		if (!this->masters.empty()) {
+			this->masters.clear();
+			this->resetOptimizer();
+		}
+		return;
+	}
+	if (!this->masters.empty()) {
+		return;
+	}
+
+	for (int i = 0; i < 2 * this->topologySize - 1; i++) {
+		BasicMatrix<T> *param = i < this->topologySize - 1 ? this->weightMatrices.at(i) : this->biasMatrices.at(i - (this->topologySize - 1));
+		MasterParameter m;
+		m.value = new Matrix(param->getNumRows(), param->getNumCols(), false);
+		m.gradient = new Matrix(param->getNumRows(), param->getNumCols(), false);
+		this->masters.push_back(m);
+		this->refreshMaster(i, param);
+	}
+	this->resetOptimizer();
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::refreshMaster(int index, BasicMatrix<T> *param) {
+	if (!this->masters.empty()) {
+		this->masters.at(index).value->convertFrom(*param);
+	}
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::feedForward() {
+	NN_PROFILE_SCOPE("feedForward", -1, 0);
+	for (int i = 0; i < (this->layers.size() - 1); i++) {
+		LayerWorkspace<T>& in = this->workspaces.at(i);
+		LayerWorkspace<T>& out = this->workspaces.at(i + 1);
+		BasicMatrix<T> *a = i != 0 ? in.activated : in.vals;
+		NN_PROFILE_SCOPE("forward", i + 1, 2.0 * out.vals->getNumRows() * a->getNumRows());
+
+		BasicMatrix<T> *b = this->getWeightMatrix(i);
+		BasicMatrix<T> *d = this->getBiasMatrix(i + 1);
+
+		// The workspace matrices are views of layer i + 1, so this writes the neurons directly
+		Gemm::multiplyBiasActivate(*b, *a, *d, this->getActivation(i + 1), *out.vals, out.activated, out.derived);
+	} 
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::backPropogate() {
+	this->computeGradients();
+	this->applyGradients();
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::computeGradients() {
+	NN_PROFILE_SCOPE("computeGradients", -1, 0);
+	this->setErrors();
+
+	// Hidden -> Output
+	LayerWorkspace<T>& out = this->workspaces.at(this->topologySize - 1);
+	for (int i = 0; i < out.vals->getNumRows(); i++) {
+		out.delta->at(i, 0) = (out.vals->at(i, 0) - this->target.at(i)) * out.derived->at(i, 0);
+	}
 
 	// Input to hidden and hidden to hidden
-	for (int i = lastHiddenLayerIndex; i >= 0; i--) {
-		Matrix *vals = i != 0 ? this->layers.at(i)->matrixifyActivatedVals() : 
-					this->layers.at(i)->matrixifyVals();
-		// Getting Weights and Biases
-		Matrix *weights = this->getWeightMatrix(i);
-		Matrix *biases = this->getBiasMatrix(i + 1);
-
-		// Gradient Calculation
-		Matrix *valsT = vals->transpose();	
-		Matrix *gradient = *delta * *valsT;
-	
-		// Bias updated first since the delta is updated in each
-		// iteration and we want the old delta to update the biases
-
-		// Calculating new biases
-		// used deltaSC for not altering the original delta
-		Matrix deltaSC = *delta;
-		deltaSC.scalarMultiply(this->learningRate);
-		Matrix *updatedBiases = *biases - deltaSC;
-
-		// Calculating delta
-		Matrix *weightsT = weights->transpose();
-		derivedVals = this->layers.at(i)->matrixifyDerivedVals(); 
-		Matrix *dA = *weightsT * *delta;
-		delete delta;
-		delta = dA->elementwiseMultiply(derivedVals); // This is the real DELTA
-
-		
-		// Calculating new weights
-		gradient->scalarMultiply(this->learningRate);
-		Matrix *updatedWeights = *weights - *gradient;
-
-
-		// Setting up weights and biases
-		this->setWeightMatrix(i, updatedWeights);
-		this->setBiasMatrix(i + 1, updatedBiases);
-
-		// Input/Hidden -> Hidden Memory cleanup
-		// Dont't delete updatedWeights
-		delete dA;
-		delete gradient;
-		delete derivedVals;
-		delete weightsT;
-		delete vals;
-		delete valsT;
-		
-	}
-	
-	delete delta;
-}
-
-void NeuralNetwork::setErrors() {
+	this->accumulateGradients(this->workspaces, *this->workspaces.at(0).vals, NULL);
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::setErrors() {
 	int outputLayerIndex = this->layers.size() - 1;
 	if (this->target.size() == 0) {
 		cerr << "Target is not set for Neural Network!." << endl;
 		assert(false);
 	}
 
-	if (this->target.size() != this->layers.at(outputLayerIndex)->getNeurons().size()) {
+	if (this->target.size() != this->layers.at(outputLayerIndex)->getSize()) {
 		cerr << "Target is not same size that of the output layer size: " << endl;
 		assert(false);
 	}
 
+	NN_PROFILE_SCOPE("setErrors", outputLayerIndex, 0);
 	this->error = 0.0;
-	vector<Neuron *> outputNeurons= this->layers.at(outputLayerIndex)->getNeurons();
+	this->errors.resize(this->target.size());
+	BasicLayer<T> *outputLayer = this->layers.at(outputLayerIndex);
 	for (int i = 0; i < target.size(); i++) {
-		double tempErr = 0.5 * pow(outputNeurons.at(i)->getActivatedVal() - this->target.at(i), 2);
-		this->errors.push_back(tempErr);
+		double tempErr = 0.5 * pow(outputLayer->getNeuronActivatedVal(i) - this->target.at(i), 2);
+		this->errors.at(i) = tempErr;
 		this->error += tempErr;
 	}
 
@@ -293,40 +826,48 @@ void NeuralNetwork::setErrors() {
 
 }
 
-void NeuralNetwork::setCurrentInput(vector<double> input) {
+template <typename T>
+void BasicNeuralNetwork<T>::setCurrentInput(vector<double> input) {
 	this->input = input;
 	for (int i = 0; i < input.size(); i++) {
 		this->layers.at(0)->setNeuronVal(i, input.at(i));
 	}
 }
 
-void NeuralNetwork::setWeightMatrix(int index, Matrix *weightMatrix) {
+template <typename T>
+void BasicNeuralNetwork<T>::setWeightMatrix(int index, BasicMatrix<T> *weightMatrix) {
 	delete this->weightMatrices.at(index);
 	this->weightMatrices.at(index) = weightMatrix; 
+	this->refreshMaster(index, weightMatrix);
 }
 
-void NeuralNetwork::setBiasMatrix(int index, Matrix *biasMatrix) {
+template <typename T>
+void BasicNeuralNetwork<T>::setBiasMatrix(int index, BasicMatrix<T> *biasMatrix) {
 	delete this->biasMatrices.at(index);
 	this->biasMatrices.at(index) = biasMatrix; 
+	this->refreshMaster(this->topologySize - 1 + index, biasMatrix);
 }
 
-void NeuralNetwork::printInputToConsole() {
+template <typename T>
+void BasicNeuralNetwork<T>::printInputToConsole() {
 	cout << "==========" << endl;
 	cout << "INPUT: " << endl;
-	Matrix *m = this->layers.at(0)->matrixifyVals();
+	BasicMatrix<T> *m = this->layers.at(0)->matrixifyVals();
 	m->printToConsole();
 	delete m;
 }
 
-void NeuralNetwork::printOutputToConsole() {
+template <typename T>
+void BasicNeuralNetwork<T>::printOutputToConsole() {
 	cout << "==========" << endl;
 	cout << "OUTPUT: " << endl;
-	Matrix *m = this->layers.at(this->layers.size() - 1)->matrixifyVals();
+	BasicMatrix<T> *m = this->layers.at(this->layers.size() - 1)->matrixifyVals();
 	m->printToConsole();
 	delete m;
 }
 
-void NeuralNetwork::printTargetToConsole() {
+template <typename T>
+void BasicNeuralNetwork<T>::printTargetToConsole() {
 	cout << "==========" << endl;
 	cout << "TARGET: " << endl;
 	for (int i = 0; i < this->target.size(); i++) {
@@ -334,11 +875,12 @@ void NeuralNetwork::printTargetToConsole() {
 	}
 	cout << endl;
 }
-void NeuralNetwork::printToConsole() {
+template <typename T>
+void BasicNeuralNetwork<T>::printToConsole() {
 	for (int i = 0; i < this->layers.size(); i++) {
 		cout << "=====================" << endl;
 		cout << "LAYER: " << i << endl;
-		Matrix *m;
+		BasicMatrix<T> *m;
 		if (i == 0) {
 			m = this->layers.at(i)->matrixifyVals();
 			m->printToConsole();
@@ -349,13 +891,13 @@ void NeuralNetwork::printToConsole() {
 		}
 		if (i != this->layers.size() - 1) {
 			cout << "Weight: " << endl;
-			Matrix *wM = this->getWeightMatrix(i);
+			BasicMatrix<T> *wM = this->getWeightMatrix(i);
 			wM->printToConsole();
 			cout << "________________" << endl;
 		}
 		if (i != 0) {
 			cout << "Bias: " << endl;
-			Matrix *bM = this->getBiasMatrix(i);
+			BasicMatrix<T> *bM = this->getBiasMatrix(i);
 			bM->printToConsole();
 		}
 		cout << "=====================" << endl;
@@ -363,3 +905,6 @@ void NeuralNetwork::printToConsole() {
 		delete m;
 	}
 }
+
+template class BasicNeuralNetwork<double>;
+template class BasicNeuralNetwork<float>;
@@ -1,4 +1,4 @@
-#include <cstdlib>
+#include <cmath>
 #include "../include/Neuron.hpp"
 
 /**
@@ -27,15 +27,33 @@ void Neuron::setVal(double val) {
  * Fast Sigmoid Function: f(x) = x / (1 + |x|)
  */
 void Neuron::activate() {
-    this->activatedVal = this->val / (1 + abs(this->val));
+    this->activatedVal = activation(this->val);
 }
 
 /**
  * @brief Calculates the derivative of the activation function
  * 
- * Derivative of Sigmoid: f'(x) = f(x) * (1 - f(x))
+ * Derivative of the fast sigmoid: f'(x) = 1 / (1 + |x|)^2 = (1 - |f(x)|)^2
  */
 void Neuron::derive() {
-    this->derivedVal = this->activatedVal * (1 - this->activatedVal);
+    this->derivedVal = derivative(this->activatedVal);
+}
+
+/**
+ * @brief Evaluates the activation function without a Neuron object
+ * @param val Raw value
+ * @return Activated value
+ */
+double Neuron::activation(double val) {
+    return val / (1 + fabs(val));
+}
+
+/**
+ * @brief Evaluates the activation derivative without a Neuron object
+ * @param activatedVal Value returned by activation()
+ * @return Derivative
+ */
+double Neuron::derivative(double activatedVal) {
+    return (1 - fabs(activatedVal)) * (1 - fabs(activatedVal));
 }
 
@@ -0,0 +1,174 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+#include "../include/Optimizer.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+/**
+ * @brief Constructor for BasicOptimizer
+ * @param config Update rule and hyperparameters
+ */
+template <typename T>
+BasicOptimizer<T>::BasicOptimizer(const OptimizerConfig& config) {
+    this->config = config;
+    this->steps = 0;
+    this->beta1Power = 1.0;
+    this->beta2Power = 1.0;
+}
+
+/**
+ * @brief Destructor, frees the state buffers
+ */
+template <typename T>
+BasicOptimizer<T>::~BasicOptimizer() {
+    this->clear();
+}
+
+/**
+ * @brief Changes the update rule, dropping all state
+ * @param config Update rule and hyperparameters
+ */
+template <typename T>
+void BasicOptimizer<T>::setConfig(const OptimizerConfig& config) {
+    this->config = config;
+    this->clear();
+}
+
+/**
+ * @brief Frees the state of every parameter and restarts the step count
+ */
+template <typename T>
+void BasicOptimizer<T>::clear() {
+    for (int i = 0; i < this->states.size(); i++) {
+        delete this->states.at(i).m;
+        delete this->states.at(i).v;
+    }
+    this->states.clear();
+    this->steps = 0;
+    this->beta1Power = 1.0;
+    this->beta2Power = 1.0;
+}
+
+/**
+ * @brief Allocates zeroed state for a set of parameters and restarts the step count
+ * @param params Parameters in update order, weights first then biases
+ * @param numWeights Number of leading entries of params that are weight matrices
+ */
+template <typename T>
+void BasicOptimizer<T>::reset(const vector<BasicMatrix<T>*>& params, int numWeights) {
+    this->clear();
+
+    const OptimizerType type = this->config.type;
+    for (int i = 0; i < params.size(); i++) {
+        const int rows = params.at(i)->getNumRows();
+        const int cols = params.at(i)->getNumCols();
+        State s;
+        s.m = type != OPTIMIZER_SGD ? new BasicMatrix<T>(rows, cols, false) : NULL;
+        s.v = type == OPTIMIZER_ADAM || type == OPTIMIZER_ADAMW ? new BasicMatrix<T>(rows, cols, false) : NULL;
+        s.decayed = i < numWeights;
+        this->states.push_back(s);
+    }
+}
+
+/**
+ * @brief Starts a new step, advancing the step count Adam's bias correction uses
+ */
+template <typename T>
+void BasicOptimizer<T>::beginStep() {
+    this->steps++;
+    this->beta1Power *= this->config.beta1;
+    this->beta2Power *= this->config.beta2;
+}
+
+/**
+ * @brief Updates one parameter in place
+ * @param index Parameter index, as registered with reset
+ * @param param Parameter to update, same shape as at reset
+ * @param gradient Gradient of param
+ * @param learningRate Learning rate
+ * @param gradientScale Factor applied to gradient, e.g. 1 / batch size
+ */
+template <typename T>
+void BasicOptimizer<T>::update(int index, BasicMatrix<T>& param, const BasicMatrix<T>& gradient,
+                               double learningRate, double gradientScale) {
+    if (param.getNumRows() != gradient.getNumRows() || param.getNumCols() != gradient.getNumCols()) {
+        cerr << "Rows and Column sizes mismatch: " << endl;
+        assert(false);
+    }
+    if (index >= this->states.size()) {
+        cerr << "Optimizer has no state for parameter " << index << endl;
+        assert(false);
+    }
+
+    const OptimizerConfig& c = this->config;
+    State& state = this->states.at(index);
+    const double decay = state.decayed ? c.weightDecay : 0.0;
+
+    OptimizerStep<T> s;
+    s.type = c.type;
+    s.rate = (T)learningRate;
+    s.gradientScale = (T)gradientScale;
+    s.momentum = (T)(c.type == OPTIMIZER_ADAM || c.type == OPTIMIZER_ADAMW ? c.beta1 : c.momentum);
+    s.beta2 = (T)c.beta2;
+    s.epsilon = (T)c.epsilon;
+    s.l2 = (T)(c.type != OPTIMIZER_ADAMW ? decay : 0.0);
+    s.decay = (T)(c.type == OPTIMIZER_ADAMW ? learningRate * decay : 0.0);
+    if (c.type == OPTIMIZER_ADAM || c.type == OPTIMIZER_ADAMW) {
+        // lr * m_hat / (sqrt(v_hat) + eps) with both corrections moved into the scalars.
+        // An update before the first beginStep counts as step 1.
+        const double correction1 = 1 - (this->steps > 0 ? this->beta1Power : c.beta1);
+        const double correction2 = sqrt(1 - (this->steps > 0 ? this->beta2Power : c.beta2));
+        s.rate = (T)(learningRate * correction2 / correction1);
+        s.epsilon = (T)(c.epsilon * correction2);
+    }
+
+    const KernelOps<T>& k = Kernels::ops<T>();
+    BasicMatrix<T>* m = state.m;
+    BasicMatrix<T>* v = state.v;
+    const int rows = param.getNumRows();
+    const int cols = param.getNumCols();
+    const size_t n = (size_t)rows * cols;
+    // A few dozen flops per value for Adam, a handful for the others
+    const size_t work = n * 8;
+
+    if (param.isContiguous() && gradient.isContiguous()) {
+        auto body = [&](size_t b, size_t e) {
+            k.optimize(s, param.getData() + b, gradient.getData() + b,
+                       m != NULL ? m->getData() + b : NULL, v != NULL ? v->getData() + b : NULL, e - b);
+        };
+        ThreadPool::global().parallelFor(0, n, work, body);
+        return;
+    }
+
+    auto body = [&](size_t b, size_t e) {
+        for (size_t r = b; r < e; r++) {
+            k.optimize(s, param.rowPtr((int)r), gradient.rowPtr((int)r),
+                       m != NULL ? m->rowPtr((int)r) : NULL, v != NULL ? v->rowPtr((int)r) : NULL, cols);
+        }
+    };
+    ThreadPool::global().parallelFor(0, rows, work, body);
+}
+
+/**
+ * @brief Gets the printable name of an update rule
+ * @param type Update rule
+ * @return Name such as "adamw"
+ */
+template <typename T>
+const char* BasicOptimizer<T>::getName(OptimizerType type) {
+    switch (type) {
+        case OPTIMIZER_SGD: return "sgd";
+        case OPTIMIZER_MOMENTUM: return "momentum";
+        case OPTIMIZER_NESTEROV: return "nesterov";
+        case OPTIMIZER_ADAM: return "adam";
+        case OPTIMIZER_ADAMW: return "adamw";
+    }
+    return "unknown";
+}
+
+template class BasicOptimizer<double>;
+template class BasicOptimizer<float>;
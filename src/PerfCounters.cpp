@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "../include/PerfCounters.hpp"
+#include "../include/Gemm.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Matrix.hpp"
+#include "../include/ThreadPool.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#define PEAK_GEMM_SIZE 512
+// Multiply-adds per accumulator of the FMA loop, a few milliseconds per round
+#define PEAK_FMA_ITERATIONS (1 << 20)
+// 32 MB per array, larger than the last level cache of most machines
+#define PEAK_STREAM_ELEMENTS (4 << 20)
+#define PEAK_ROUNDS 3
+
+#ifdef __linux__
+/**
+ * @brief Opens one event of the calling thread, user space only
+ * @param type perf_event_attr type
+ * @param config perf_event_attr config
+ * @param group Group leader, -1 to open a leader
+ * @return File descriptor, -1 with errno set on failure
+ */
+static int openEvent(uint32_t type, uint64_t config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+/**
+ * @brief Constructor for PerfCounters, opens the counters for the calling thread
+ */
+PerfCounters::PerfCounters() {
+    this->numOpen = 0;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        this->fds[i] = -1;
+        this->slots[i] = -1;
+    }
+
+#ifdef __linux__
+    const uint32_t types[PERF_EVENT_COUNT] = {
+        PERF_TYPE_SOFTWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+    };
+    const uint64_t configs[PERF_EVENT_COUNT] = {
+        PERF_COUNT_SW_TASK_CLOCK,
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    // The software leader keeps the group alive where the hardware events are refused
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        int fd = openEvent(types[i], configs[i], this->fds[PERF_TASK_CLOCK]);
+        if (fd < 0) {
+            if (this->error.empty()) {
+                this->error = string(PerfCounters::getName((PerfEvent)i)) + ": " + strerror(errno);
+            }
+            if (i == PERF_TASK_CLOCK) {
+                return;
+            }
+            continue;
+        }
+        this->fds[i] = fd;
+        this->slots[i] = this->numOpen++;
+    }
+
+    ioctl(this->fds[PERF_TASK_CLOCK], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(this->fds[PERF_TASK_CLOCK], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    this->error = "perf_event_open is only available on Linux";
+#endif
+}
+
+/**
+ * @brief Destructor, closes the counters
+ */
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    // Members first, the leader last
+    for (int i = PERF_EVENT_COUNT - 1; i >= 0; i--) {
+        if (this->fds[i] >= 0) {
+            close(this->fds[i]);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Reads all events
+ * @param values Receives the running totals, 0 for events not counted
+ * @return Whether the counters could be read
+ */
+bool PerfCounters::read(uint64_t values[PERF_EVENT_COUNT]) const {
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        values[i] = 0;
+    }
+    if (!this->isOpen()) {
+        return false;
+    }
+
+#ifdef __linux__
+    // nr, time enabled, time running, then one value per event in the order they were opened
+    uint64_t buffer[3 + PERF_EVENT_COUNT];
+    const ssize_t expected = (ssize_t)((3 + this->numOpen) * sizeof(uint64_t));
+    if (::read(this->fds[PERF_TASK_CLOCK], buffer, sizeof(buffer)) != expected) {
+        return false;
+    }
+
+    // Counters that were multiplexed only ran part of the time, extrapolate to the whole
+    const double scale = buffer[2] > 0 ? (double)buffer[1] / buffer[2] : 1.0;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (this->slots[i] >= 0) {
+            values[i] = (uint64_t)(buffer[3 + this->slots[i]] * scale);
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Gets the printable name of an event
+ * @param event Event
+ * @return Name such as "cycles"
+ */
+const char* PerfCounters::getName(PerfEvent event) {
+    switch (event) {
+        case PERF_TASK_CLOCK: return "task-clock";
+        case PERF_CYCLES: return "cycles";
+        case PERF_INSTRUCTIONS: return "instructions";
+        case PERF_L1D_MISSES: return "L1d-read-misses";
+        case PERF_LLC_MISSES: return "LLC-misses";
+        case PERF_BRANCH_MISSES: return "branch-misses";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Measures the compute and memory ceilings of this machine
+ * @return Peak GFLOP/s and GB/s
+ */
+MachinePeak PerfCounters::measurePeak() {
+    MachinePeak peak = { 0.0, 0.0 };
+
+    // Compute: the dispatched FMA loop on every pool thread, one chunk each, so no kernel of
+    // the library can beat it; GEMMs are timed on the same threads
+    const GemmMicroKernel<double> micro = Kernels::ops<double>().gemm;
+    const int threads = ThreadPool::global().getNumThreads();
+    vector<double> sinks(threads);
+    auto body = [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            micro.fmaLoop(PEAK_FMA_ITERATIONS, &sinks[t]);
+        }
+    };
+    const double loopFlops = 2.0 * micro.rows * micro.cols * PEAK_FMA_ITERATIONS * threads;
+    for (int round = 0; round < PEAK_ROUNDS; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        ThreadPool::global().parallelFor(0, threads, (size_t)loopFlops, body);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        peak.gflops = max(peak.gflops, loopFlops / seconds * 1e-9);
+    }
+
+    // A square GEMM large enough for the blocked kernel to reach steady state, in case it
+    // overlaps better than the loop on this core
+    Matrix a(PEAK_GEMM_SIZE, PEAK_GEMM_SIZE, true), b(PEAK_GEMM_SIZE, PEAK_GEMM_SIZE, true), c(PEAK_GEMM_SIZE, PEAK_GEMM_SIZE, false);
+    const double flops = 2.0 * PEAK_GEMM_SIZE * PEAK_GEMM_SIZE * PEAK_GEMM_SIZE;
+    for (int round = 0; round < PEAK_ROUNDS; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Gemm::multiply(a, b, c);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        peak.gflops = max(peak.gflops, flops / seconds * 1e-9);
+    }
+
+    // Memory: y += alpha * x streams two arrays in and one out
+    Matrix x(1, PEAK_STREAM_ELEMENTS, false), y(1, PEAK_STREAM_ELEMENTS, false);
+    const double bytes = 3.0 * PEAK_STREAM_ELEMENTS * sizeof(double);
+    for (int round = 0; round < PEAK_ROUNDS; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        y.axpy(1.0, x);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        peak.gbytesPerSecond = max(peak.gbytesPerSecond, bytes / seconds * 1e-9);
+    }
+    return peak;
+}
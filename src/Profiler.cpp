@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+#include "../include/Profiler.hpp"
+
+using namespace std;
+
+/**
+ * @brief A scope that has been opened and not yet closed
+ */
+struct OpenScope {
+    const char* name;   ///< Operation, NULL if the scope began while recording was paused
+    int layer;          ///< Layer index
+    double flops;       ///< Floating point operations
+    uint64_t start;     ///< Start, nanoseconds since the profiler epoch
+    uint64_t child;     ///< Nanoseconds spent in nested scopes
+    uint64_t bytes;     ///< Bytes allocated directly inside the scope
+    bool counted;       ///< Whether counters holds a reading
+    uint64_t counters[PERF_EVENT_COUNT]; ///< Hardware counters at the start
+};
+
+/**
+ * @brief A closed scope, kept for the trace
+ */
+struct TraceEvent {
+    const char* name;   ///< Operation
+    int layer;          ///< Layer index
+    double flops;       ///< Floating point operations
+    uint64_t bytes;     ///< Bytes allocated directly inside the scope
+    uint64_t start;     ///< Start, nanoseconds since the profiler epoch
+    uint64_t duration;  ///< Duration in nanoseconds
+};
+
+/**
+ * @brief Everything one thread has recorded, only ever written by that thread
+ */
+struct ThreadProfile {
+    int tid;                                            ///< Track of the thread in the trace
+    vector<OpenScope> open;                             ///< Stack of open scopes, PROFILER_MAX_DEPTH reserved
+    vector<TraceEvent> events;                          ///< Closed scopes, at most PROFILER_MAX_EVENTS
+    map<pair<const char*, int>, ProfileStat> stats;     ///< Totals per operation and layer
+    PerfCounters* perf;                                 ///< Hardware counters, opened on first use
+};
+
+static atomic<bool> recording(true);
+static atomic<bool> counting(false);
+// Bit per PerfEvent that at least one thread managed to open
+static atomic<unsigned> liveEvents(0);
+static mutex registryMutex;
+// Never freed: a pool thread may still point at its profile when the program exits
+static vector<ThreadProfile*> registry;
+static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+static thread_local ThreadProfile* local = NULL;
+
+/**
+ * @brief Reads the clock
+ * @return Nanoseconds since the profiler epoch
+ */
+static inline uint64_t now() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+ * @brief Gets the profile of the calling thread, registering it on first use
+ * @return Profile
+ */
+static ThreadProfile& threadProfile() {
+    if (local == NULL) {
+        local = new ThreadProfile();
+        local->perf = NULL;
+        // Reserved up front so recording never allocates inside the instrumented code; the
+        // pages of the event buffer are only committed by the OS as events fill them
+        local->open.reserve(PROFILER_MAX_DEPTH);
+        local->events.reserve(PROFILER_MAX_EVENTS);
+        lock_guard<mutex> lock(registryMutex);
+        local->tid = (int)registry.size();
+        registry.push_back(local);
+    }
+    return *local;
+}
+
+/**
+ * @brief Opens the hardware counters of the calling thread if it has none yet
+ * @param p Profile of the calling thread
+ * @return Counters, possibly closed
+ */
+static PerfCounters& threadCounters(ThreadProfile& p) {
+    if (p.perf == NULL) {
+        p.perf = new PerfCounters();
+        for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+            if (p.perf->isCounting((PerfEvent)i)) {
+                liveEvents |= 1u << i;
+            }
+        }
+    }
+    return *p.perf;
+}
+
+/**
+ * @brief Starts or pauses recording, enabled by default
+ * @param enabled Whether scopes are recorded
+ */
+void Profiler::setEnabled(bool enabled) {
+    recording = enabled;
+}
+
+/**
+ * @brief Tells whether scopes are recorded
+ * @return True if recording
+ */
+bool Profiler::isEnabled() {
+    return recording;
+}
+
+/**
+ * @brief Tells whether the library was built with NN_PROFILE
+ * @return True if the instrumentation is compiled in
+ */
+bool Profiler::isCompiledIn() {
+#ifdef NN_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Turns the hardware counters on or off for the scopes opened from now on
+ * @param enabled Whether scopes read the PerfCounters of their thread, off by default
+ * @return Whether the counters could be opened on the calling thread (always true when disabling)
+ */
+bool Profiler::setHardwareCounters(bool enabled) {
+    counting = enabled;
+    if (!enabled) {
+        return true;
+    }
+
+    PerfCounters& perf = threadCounters(threadProfile());
+    if (!perf.isOpen()) {
+        cerr << "Hardware counters unavailable (" << perf.getError() << "), timing only" << endl;
+    }
+    return perf.isOpen();
+}
+
+/**
+ * @brief Tells whether scopes read the hardware counters
+ * @return True if enabled
+ */
+bool Profiler::hasHardwareCounters() {
+    return counting;
+}
+
+/**
+ * @brief Discards everything recorded so far
+ */
+void Profiler::reset() {
+    lock_guard<mutex> lock(registryMutex);
+    for (size_t i = 0; i < registry.size(); i++) {
+        registry[i]->events.clear();
+        registry[i]->stats.clear();
+    }
+}
+
+/**
+ * @brief Opens a scope on the calling thread, use NN_PROFILE_SCOPE instead
+ * @param name Operation, a string literal
+ * @param layer Layer index, -1 to inherit the enclosing scope's
+ * @param flops Floating point operations of the scope
+ */
+void Profiler::begin(const char* name, int layer, double flops) {
+    ThreadProfile& p = threadProfile();
+    OpenScope s;
+    s.name = recording ? name : NULL;
+    s.layer = layer < 0 && !p.open.empty() ? p.open.back().layer : layer;
+    s.flops = flops;
+    s.child = 0;
+    s.bytes = 0;
+    s.counted = false;
+    if (s.name != NULL && counting) {
+        s.counted = threadCounters(p).read(s.counters);
+    }
+    s.start = s.name != NULL ? now() : 0;
+    p.open.push_back(s);
+}
+
+/**
+ * @brief Closes the innermost scope of the calling thread
+ */
+void Profiler::end() {
+    ThreadProfile& p = threadProfile();
+    const OpenScope s = p.open.back();
+    p.open.pop_back();
+    if (s.name == NULL) {
+        return;
+    }
+
+    const uint64_t duration = now() - s.start;
+    uint64_t counters[PERF_EVENT_COUNT];
+    const bool counted = s.counted && p.perf->read(counters);
+    if (!p.open.empty()) {
+        p.open.back().child += duration;
+    }
+
+    ProfileStat& stat = p.stats[make_pair(s.name, s.layer)];
+    if (stat.calls == 0) {
+        stat.name = s.name;
+        stat.layer = s.layer;
+    }
+    stat.calls++;
+    stat.seconds += duration * 1e-9;
+    stat.selfSeconds += (duration - min(duration, s.child)) * 1e-9;
+    stat.flops += s.flops;
+    stat.bytes += s.bytes;
+    if (counted) {
+        stat.countedCalls++;
+        for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+            stat.counters[i] += counters[i] - s.counters[i];
+        }
+    }
+
+    if (p.events.size() < PROFILER_MAX_EVENTS) {
+        TraceEvent e = { s.name, s.layer, s.flops, s.bytes, s.start, duration };
+        p.events.push_back(e);
+    }
+}
+
+/**
+ * @brief Charges an allocation to the innermost scope of the calling thread
+ * @param bytes Size of the allocation
+ */
+void Profiler::recordAlloc(size_t bytes) {
+    ThreadProfile& p = threadProfile();
+    if (!p.open.empty()) {
+        p.open.back().bytes += bytes;
+    }
+}
+
+/**
+ * @brief Totals per operation and layer over all threads
+ * @return Statistics sorted by layer, then by decreasing time
+ */
+vector<ProfileStat> Profiler::getStats() {
+    // The same literal may have a different address in each translation unit, so merge by text
+    map<pair<string, int>, ProfileStat> merged;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        for (size_t i = 0; i < registry.size(); i++) {
+            map<pair<const char*, int>, ProfileStat>& stats = registry[i]->stats;
+            for (map<pair<const char*, int>, ProfileStat>::iterator it = stats.begin(); it != stats.end(); ++it) {
+                ProfileStat& m = merged[make_pair(string(it->second.name), it->second.layer)];
+                if (m.calls == 0) {
+                    m = it->second;
+                    continue;
+                }
+                m.calls += it->second.calls;
+                m.seconds += it->second.seconds;
+                m.selfSeconds += it->second.selfSeconds;
+                m.flops += it->second.flops;
+                m.bytes += it->second.bytes;
+                m.countedCalls += it->second.countedCalls;
+                for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                    m.counters[e] += it->second.counters[e];
+                }
+            }
+        }
+    }
+
+    vector<ProfileStat> stats;
+    for (map<pair<string, int>, ProfileStat>::iterator it = merged.begin(); it != merged.end(); ++it) {
+        stats.push_back(it->second);
+    }
+    sort(stats.begin(), stats.end(), [](const ProfileStat& a, const ProfileStat& b) {
+        return a.layer != b.layer ? a.layer < b.layer : a.seconds > b.seconds;
+    });
+    return stats;
+}
+
+/**
+ * @brief Prints the totals as a table
+ * @param out Stream
+ */
+void Profiler::printSummary(ostream& out) {
+    vector<ProfileStat> stats = Profiler::getStats();
+    double total = 0.0;
+    for (size_t i = 0; i < stats.size(); i++) {
+        total += stats[i].selfSeconds;
+    }
+
+    const ios::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+    out << "layer\t" << left << setw(20) << "op" << right << "calls\ttotal ms\tself ms\tself %\tGFLOP/s\tMB alloc" << endl;
+    for (size_t i = 0; i < stats.size(); i++) {
+        const ProfileStat& s = stats[i];
+        out << (s.layer < 0 ? string("-") : to_string(s.layer)) << "\t" << left << setw(20) << s.name << right
+            << s.calls << "\t" << fixed << setprecision(3) << s.seconds * 1e3 << "\t" << s.selfSeconds * 1e3
+            << "\t" << setprecision(1) << (total > 0 ? 100.0 * s.selfSeconds / total : 0.0) << "\t" << setprecision(3)
+            << (s.flops > 0 && s.seconds > 0 ? s.flops / s.seconds * 1e-9 : 0.0) << "\t" << s.bytes / 1048576.0
+            << endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/**
+ * @brief Formats a counter ratio, or "n/a" when the event was not counted
+ * @param live Whether the numerator event was counted
+ * @param value Ratio
+ * @return Text
+ */
+static string formatCounter(bool live, double value) {
+    if (!live) {
+        return "n/a";
+    }
+    stringstream s;
+    s << fixed << setprecision(2) << value;
+    return s.str();
+}
+
+/**
+ * @brief Prints the hardware counters per operation and layer against the machine's roofline
+ *
+ * Arithmetic intensity is estimated from the LLC misses (64 bytes each), so an operation
+ * whose GFLOP/s sits near min(peak GFLOP/s, intensity * peak GB/s) is at the roofline.
+ * @param out Stream
+ * @param peak Ceilings, see PerfCounters::measurePeak
+ */
+void Profiler::printCounters(ostream& out, const MachinePeak& peak) {
+    const unsigned live = liveEvents;
+    const bool cycles = (live >> PERF_CYCLES) & 1;
+    const bool instructions = (live >> PERF_INSTRUCTIONS) & 1;
+    const bool l1 = (live >> PERF_L1D_MISSES) & 1;
+    const bool llc = (live >> PERF_LLC_MISSES) & 1;
+    const bool branches = (live >> PERF_BRANCH_MISSES) & 1;
+
+    out << "Peak: " << peak.gflops << " GFLOP/s, " << peak.gbytesPerSecond << " GB/s, ridge at "
+        << peak.gflops / peak.gbytesPerSecond << " FLOP/byte" << endl;
+    if (!instructions) {
+        out << "Hardware events not counted on this machine, cycles and misses shown as n/a" << endl;
+    }
+    out << "layer\t" << left << setw(20) << "op" << right
+        << "cpu ms\tMcycles\tIPC\tL1d/ki\tLLC/ki\tbr/ki\tGFLOP/s\tFLOP/B\t% roof\tbound" << endl;
+
+    vector<ProfileStat> stats = Profiler::getStats();
+    for (size_t i = 0; i < stats.size(); i++) {
+        const ProfileStat& s = stats[i];
+        if (s.countedCalls == 0) {
+            continue;
+        }
+        const double kiloInstructions = s.counters[PERF_INSTRUCTIONS] / 1e3;
+        out << (s.layer < 0 ? string("-") : to_string(s.layer)) << "\t" << left << setw(20) << s.name << right
+            << formatCounter(true, s.counters[PERF_TASK_CLOCK] * 1e-6) << "\t"
+            << formatCounter(cycles, s.counters[PERF_CYCLES] * 1e-6) << "\t"
+            << formatCounter(cycles && instructions && s.counters[PERF_CYCLES] > 0, (double)s.counters[PERF_INSTRUCTIONS] / max<uint64_t>(1, s.counters[PERF_CYCLES])) << "\t"
+            << formatCounter(l1 && instructions, s.counters[PERF_L1D_MISSES] / max(1.0, kiloInstructions)) << "\t"
+            << formatCounter(llc && instructions, s.counters[PERF_LLC_MISSES] / max(1.0, kiloInstructions)) << "\t"
+            << formatCounter(branches && instructions, s.counters[PERF_BRANCH_MISSES] / max(1.0, kiloInstructions)) << "\t";
+
+        if (s.flops <= 0 || s.seconds <= 0) {
+            out << endl;
+            continue;
+        }
+        const double gflops = s.flops / s.seconds * 1e-9;
+        out << formatCounter(true, gflops) << "\t";
+        // Without LLC misses there is no traffic estimate, so only the compute roof applies
+        double roof = peak.gflops;
+        string bound = "?";
+        if (llc && s.counters[PERF_LLC_MISSES] > 0) {
+            const double intensity = s.flops / (s.counters[PERF_LLC_MISSES] * 64.0);
+            roof = min(peak.gflops, intensity * peak.gbytesPerSecond);
+            bound = intensity * peak.gbytesPerSecond < peak.gflops ? "memory" : "compute";
+            out << formatCounter(true, intensity) << "\t";
+        }
+        else {
+            out << (llc ? "inf" : "n/a") << "\t";
+            bound = llc ? "compute" : "?";
+        }
+        // Above 100% the ceilings were measured too low (e.g. a busy machine), flag rather than print it
+        const double percent = roof > 0 ? 100.0 * gflops / roof : 0.0;
+        out << (percent > 100.0 ? string(">100") : formatCounter(true, percent)) << "\t" << bound << endl;
+    }
+}
+
+/**
+ * @brief Writes the recorded scopes in the Chrome trace event format
+ *
+ * The file opens in chrome://tracing or https://ui.perfetto.dev, one track per thread.
+ * @param path Output file
+ * @return Whether the file was written
+ */
+bool Profiler::writeChromeTrace(const string& path) {
+    ofstream out(path);
+    if (!out.is_open()) {
+        cerr << "Cannot write trace " << path << endl;
+        return false;
+    }
+
+    lock_guard<mutex> lock(registryMutex);
+    out << fixed << setprecision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << endl;
+    bool first = true;
+    for (size_t t = 0; t < registry.size(); t++) {
+        const ThreadProfile& p = *registry[t];
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << p.tid
+            << ", \"args\": {\"name\": \"" << (p.tid == 0 ? "main" : "thread " + to_string(p.tid)) << "\"}}";
+        first = false;
+        for (size_t i = 0; i < p.events.size(); i++) {
+            const TraceEvent& e = p.events[i];
+            out << ",\n{\"name\": \"" << e.name;
+            if (e.layer >= 0) {
+                out << " L" << e.layer;
+            }
+            // Timestamps and durations are in microseconds
+            out << "\", \"cat\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << p.tid
+                << ", \"ts\": " << e.start * 1e-3 << ", \"dur\": " << e.duration * 1e-3
+                << ", \"args\": {\"layer\": " << e.layer << ", \"flops\": " << setprecision(0) << e.flops
+                << ", \"bytes\": " << e.bytes << "}}" << setprecision(3);
+        }
+    }
+    out << endl << "]}" << endl;
+    return true;
+}
@@ -0,0 +1,410 @@
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "../include/QuantizedNetwork.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/ModelFile.hpp"
+#include "../include/Activation.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+static_assert(sizeof(QuantizedFileHeader) == 64, "QuantizedFileHeader must stay 64 bytes");
+
+/**
+ * @brief Gets the scale that maps the largest magnitude to QUANTIZED_MAX
+ */
+static float scaleFor(double maxAbs) {
+    // An all-zero tensor quantizes to zeros with any scale
+    return maxAbs > 0.0 ? (float)(maxAbs / QUANTIZED_MAX) : 1.0f;
+}
+
+/**
+ * @brief Quantizes a trained network
+ * @param network Network to quantize (its weights are not modified)
+ * @param calibration Sample inputs used to choose the activation scales
+ */
+QuantizedNetwork::QuantizedNetwork(NeuralNetwork& network, const vector<vector<double>>& calibration) {
+    if (calibration.size() == 0) {
+        cerr << "Quantization needs at least one calibration input!." << endl;
+        assert(false);
+    }
+
+    this->topology = network.getTopology();
+    this->allocate();
+
+    // Largest magnitude reaching every weight matrix: raw input values for the first,
+    // activated values for the others
+    vector<double> maxAbs(this->layers.size(), 0.0);
+    for (int k = 0; k < calibration.size(); k++) {
+        delete network.predict(calibration.at(k));
+        for (int i = 0; i < this->layers.size(); i++) {
+            Matrix* m = i == 0 ? network.getNeuronMatrix(i) : network.getActivatedNeuronMatrix(i);
+            for (int r = 0; r < m->getNumRows(); r++) {
+                maxAbs.at(i) = max(maxAbs.at(i), fabs(m->getVal(r, 0)));
+            }
+            delete m;
+        }
+    }
+
+    for (int i = 0; i < this->layers.size(); i++) {
+        QuantizedLayer& l = this->layers.at(i);
+        Matrix* w = network.getWeightMatrix(i);
+        Matrix* b = network.getBiasMatrix(i + 1);
+        l.inputScale = scaleFor(maxAbs.at(i));
+        l.activation = network.getActivation(i + 1);
+
+        for (int r = 0; r < l.rows; r++) {
+            const double* row = w->rowPtr(r);
+            double rowMax = 0.0;
+            for (int c = 0; c < l.cols; c++) {
+                rowMax = max(rowMax, fabs(row[c]));
+            }
+            l.rowScales[r] = scaleFor(rowMax);
+            l.biases[r] = (float)b->getVal(r, 0);
+
+            const double inv = 1.0 / l.rowScales[r];
+            for (int c = 0; c < l.cols; c++) {
+                l.weights[(size_t)r * l.stride + c] = (int8_t)lrint(row[c] * inv);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Loads a quantized model written by save
+ * @param path Path to the quantized model file
+ */
+QuantizedNetwork::QuantizedNetwork(const string& path) {
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open()) {
+        cerr << "Could not open quantized model file: " << path << endl;
+        assert(false);
+    }
+    const uint64_t fileSize = (uint64_t)file.tellg();
+    file.seekg(0);
+
+    QuantizedFileHeader h;
+    if (fileSize < sizeof(h) || !file.read(reinterpret_cast<char*>(&h), sizeof(h))
+        || strncmp(h.magic, QUANTIZED_FILE_MAGIC, sizeof(h.magic)) != 0) {
+        cerr << "Not a quantized model file: " << path << endl;
+        assert(false);
+    }
+    if (h.byteOrder != MODEL_FILE_BYTE_ORDER) {
+        cerr << "Quantized model file was written with a different byte order: " << path << endl;
+        assert(false);
+    }
+    if (h.version < 1 || h.version > QUANTIZED_FILE_VERSION) {
+        cerr << "Unsupported quantized model file version " << h.version << ": " << path << endl;
+        assert(false);
+    }
+    if (h.payloadSize != fileSize - sizeof(h) || h.numLayers < 2) {
+        cerr << "Corrupt quantized model file header: " << path << endl;
+        assert(false);
+    }
+
+    vector<unsigned char> payload(h.payloadSize);
+    file.read(reinterpret_cast<char*>(payload.data()), payload.size());
+    if (ModelFile::checksum(MODEL_FILE_CHECKSUM_SEED, payload.data(), payload.size()) != h.checksum) {
+        cerr << "Quantized model file checksum mismatch: " << path << endl;
+        assert(false);
+    }
+
+    size_t pos = 0;
+    auto take = [&](void* out, size_t bytes) {
+        if (payload.size() - pos < bytes) {
+            cerr << "Quantized model file is truncated: " << path << endl;
+            assert(false);
+        }
+        memcpy(out, payload.data() + pos, bytes);
+        pos += bytes;
+    };
+
+    for (uint32_t i = 0; i < h.numLayers; i++) {
+        uint32_t size;
+        take(&size, sizeof(size));
+        if (size == 0) {
+            cerr << "Quantized model file has an empty layer: " << path << endl;
+            assert(false);
+        }
+        this->topology.push_back((int)size);
+    }
+    this->allocate();
+
+    for (uint32_t i = 0; h.version >= 2 && i < h.numLayers; i++) {
+        uint32_t activation;
+        take(&activation, sizeof(activation));
+        if (!Activation::isValid(activation)) {
+            cerr << "Unknown activation " << activation << " in quantized model file: " << path << endl;
+            assert(false);
+        }
+        // The input layer's activation is not used by the pass
+        if (i > 0) {
+            this->layers.at(i - 1).activation = (ActivationType)activation;
+        }
+    }
+
+    for (int i = 0; i < this->layers.size(); i++) {
+        QuantizedLayer& l = this->layers.at(i);
+        take(&l.inputScale, sizeof(float));
+        take(l.rowScales, sizeof(float) * l.rows);
+        take(l.biases, sizeof(float) * l.rows);
+        for (int r = 0; r < l.rows; r++) {
+            take(l.weights + (size_t)r * l.stride, l.cols);
+        }
+    }
+    if (pos != payload.size()) {
+        cerr << "Quantized model file has trailing data: " << path << endl;
+        assert(false);
+    }
+}
+
+/**
+ * @brief Destructor to clean up memory
+ */
+QuantizedNetwork::~QuantizedNetwork() {
+    for (int i = 0; i < this->layers.size(); i++) {
+        Matrix::alignedFree(this->layers.at(i).weights);
+        Matrix::alignedFree(this->layers.at(i).rowScales);
+        Matrix::alignedFree(this->layers.at(i).biases);
+    }
+    Matrix::alignedFree(this->inputBuffer);
+    Matrix::alignedFree(this->accumulators);
+    Matrix::alignedFree(this->values);
+    Matrix::alignedFree(this->nextValues);
+}
+
+/**
+ * @brief Allocates the layers and scratch buffers for the topology
+ */
+void QuantizedNetwork::allocate() {
+    size_t widest = 0;
+    for (int i = 0; i < this->topology.size(); i++) {
+        widest = max(widest, (size_t)this->topology.at(i));
+    }
+
+    for (int i = 0; i + 1 < this->topology.size(); i++) {
+        QuantizedLayer l;
+        l.rows = this->topology.at(i + 1);
+        l.cols = this->topology.at(i);
+        l.stride = (l.cols + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+        l.weights = static_cast<int8_t*>(Matrix::alignedAlloc((size_t)l.rows * l.stride));
+        l.rowScales = static_cast<float*>(Matrix::alignedAlloc(sizeof(float) * l.rows));
+        l.biases = static_cast<float*>(Matrix::alignedAlloc(sizeof(float) * l.rows));
+        l.inputScale = 1.0f;
+        l.activation = ACTIVATION_SOFTSIGN;
+        this->layers.push_back(l);
+    }
+
+    this->inputBuffer = static_cast<int8_t*>(Matrix::alignedAlloc(widest));
+    this->accumulators = static_cast<int32_t*>(Matrix::alignedAlloc(sizeof(int32_t) * widest));
+    this->values = static_cast<float*>(Matrix::alignedAlloc(sizeof(float) * widest));
+    this->nextValues = static_cast<float*>(Matrix::alignedAlloc(sizeof(float) * widest));
+}
+
+/**
+ * @brief Writes the quantized model, e.g. next to the model saved by NeuralNetwork::saveModel
+ * @param path Path to save the quantized model
+ */
+void QuantizedNetwork::save(const string& path) {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        cerr << "Could not open quantized model file for writing: " << path << endl;
+        assert(false);
+    }
+
+    QuantizedFileHeader h;
+    memset(&h, 0, sizeof(h));
+    strncpy(h.magic, QUANTIZED_FILE_MAGIC, sizeof(h.magic));
+    h.version = QUANTIZED_FILE_VERSION;
+    h.byteOrder = MODEL_FILE_BYTE_ORDER;
+    h.numLayers = this->topology.size();
+    // Written again once the payload size and checksum are known
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    uint64_t hash = MODEL_FILE_CHECKSUM_SEED;
+    auto put = [&](const void* data, size_t bytes) {
+        file.write(static_cast<const char*>(data), bytes);
+        hash = ModelFile::checksum(hash, static_cast<const unsigned char*>(data), bytes);
+        h.payloadSize += bytes;
+    };
+
+    for (int i = 0; i < this->topology.size(); i++) {
+        uint32_t size = this->topology.at(i);
+        put(&size, sizeof(size));
+    }
+    for (int i = 0; i < this->topology.size(); i++) {
+        uint32_t activation = i > 0 ? this->layers.at(i - 1).activation : ACTIVATION_SOFTSIGN;
+        put(&activation, sizeof(activation));
+    }
+    for (int i = 0; i < this->layers.size(); i++) {
+        const QuantizedLayer& l = this->layers.at(i);
+        put(&l.inputScale, sizeof(float));
+        put(l.rowScales, sizeof(float) * l.rows);
+        put(l.biases, sizeof(float) * l.rows);
+        for (int r = 0; r < l.rows; r++) {
+            put(l.weights + (size_t)r * l.stride, l.cols);
+        }
+    }
+
+    h.checksum = hash;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    if (!file.good()) {
+        cerr << "Could not write quantized model file: " << path << endl;
+        assert(false);
+    }
+}
+
+/**
+ * @brief Checks whether a file starts with the quantized model magic
+ * @param path Path to the file
+ * @return True for quantized model files
+ */
+bool QuantizedNetwork::isQuantized(const string& path) {
+    ifstream file(path, ios::binary);
+    char magic[8] = { 0 };
+    file.read(magic, sizeof(magic));
+    return file.gcount() == sizeof(magic) && strncmp(magic, QUANTIZED_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+ * @brief Quantizes values to int8 with a given scale
+ * @param in Values to quantize
+ * @param out Receives the int8 values
+ * @param n Number of values
+ * @param scale Value of one int8 step
+ */
+void QuantizedNetwork::quantize(const float* in, int8_t* out, int n, float scale) {
+    const float inv = 1.0f / scale;
+    for (int i = 0; i < n; i++) {
+        // Values beyond the calibrated range saturate
+        float q = nearbyintf(in[i] * inv);
+        q = q > QUANTIZED_MAX ? QUANTIZED_MAX : (q < -QUANTIZED_MAX ? -QUANTIZED_MAX : q);
+        out[i] = (int8_t)q;
+    }
+}
+
+/**
+ * @brief Makes a prediction with the int8 engine
+ * @param input Input vector
+ * @return Matrix containing the output prediction (caller deletes)
+ */
+Matrix* QuantizedNetwork::predict(const vector<double>& input) {
+    if (input.size() != this->topology.front()) {
+        cerr << "Input is not same size that of the input layer size: " << endl;
+        assert(false);
+    }
+
+    Matrix* output = new Matrix(this->topology.back(), 1, false);
+    this->predictInto(input.data(), output->getData());
+    return output;
+}
+
+/**
+ * @brief Makes a prediction into a caller buffer without allocating
+ * @param input Input values, one per input neuron
+ * @param output Receives one value per output neuron
+ */
+void QuantizedNetwork::predictInto(const double* input, double* output) {
+    const KernelTable& kernels = Kernels::get();
+
+    for (int i = 0; i < this->topology.front(); i++) {
+        this->values[i] = (float)input[i];
+    }
+
+    for (int i = 0; i < this->layers.size(); i++) {
+        const QuantizedLayer& l = this->layers.at(i);
+        const bool last = i == this->layers.size() - 1;
+        quantize(this->values, this->inputBuffer, l.cols, l.inputScale);
+
+        auto body = [&](size_t b, size_t e) {
+            kernels.gemvInt8(l.weights + b * l.stride, this->inputBuffer, this->accumulators + b, e - b, l.cols, l.stride);
+            for (size_t r = b; r < e; r++) {
+                float v = this->accumulators[r] * (l.rowScales[r] * l.inputScale) + l.biases[r];
+                if (last) {
+                    output[r] = v;
+                }
+                else {
+                    this->nextValues[r] = v;
+                }
+            }
+            if (!last) {
+                Activation::apply<float>(l.activation, this->nextValues + b, this->nextValues + b, nullptr, e - b);
+            }
+        };
+        ThreadPool::global().parallelFor(0, l.rows, (size_t)l.rows * l.cols, body);
+
+        swap(this->values, this->nextValues);
+    }
+}
+
+/**
+ * @brief Compares the int8 outputs with the double precision predict on the same inputs
+ * @param network Network the engine was quantized from
+ * @param inputs Inputs to compare on
+ * @return Error statistics
+ */
+QuantizationReport QuantizedNetwork::evaluate(NeuralNetwork& network, const vector<vector<double>>& inputs) {
+    QuantizationReport report;
+    report.samples = inputs.size();
+    report.maxAbsError = 0.0;
+    report.meanAbsError = 0.0;
+    report.rmsError = 0.0;
+    report.maxRelativeError = 0.0;
+    report.argmaxAgreement = 0.0;
+
+    const int outputs = this->topology.back();
+    vector<double> quantized(outputs);
+    int agreed = 0;
+    for (int k = 0; k < inputs.size(); k++) {
+        Matrix* reference = network.predict(inputs.at(k));
+        this->predictInto(inputs.at(k).data(), quantized.data());
+
+        double maxRef = 0.0;
+        double maxDiff = 0.0;
+        int argRef = 0;
+        int argQuant = 0;
+        for (int r = 0; r < outputs; r++) {
+            double ref = reference->getVal(r, 0);
+            double diff = fabs(quantized.at(r) - ref);
+            maxRef = max(maxRef, fabs(ref));
+            maxDiff = max(maxDiff, diff);
+            report.meanAbsError += diff;
+            report.rmsError += diff * diff;
+            argRef = ref > reference->getVal(argRef, 0) ? r : argRef;
+            argQuant = quantized.at(r) > quantized.at(argQuant) ? r : argQuant;
+        }
+        report.maxAbsError = max(report.maxAbsError, maxDiff);
+        if (maxRef > 0.0) {
+            report.maxRelativeError = max(report.maxRelativeError, maxDiff / maxRef);
+        }
+        agreed += argRef == argQuant;
+        delete reference;
+    }
+
+    if (report.samples > 0) {
+        const double values = (double)report.samples * outputs;
+        report.meanAbsError /= values;
+        report.rmsError = sqrt(report.rmsError / values);
+        report.argmaxAgreement = (double)agreed / report.samples;
+    }
+    return report;
+}
+
+/**
+ * @brief Prints an accuracy report to the console
+ * @param report Report returned by evaluate
+ */
+void QuantizedNetwork::printReport(const QuantizationReport& report) {
+    cout << "==========" << endl;
+    cout << "INT8 vs DOUBLE (" << report.samples << " inputs): " << endl;
+    cout << "Max abs error:\t\t" << report.maxAbsError << endl;
+    cout << "Mean abs error:\t\t" << report.meanAbsError << endl;
+    cout << "RMS error:\t\t" << report.rmsError << endl;
+    cout << "Max relative error:\t" << report.maxRelativeError << endl;
+    cout << "Argmax agreement:\t" << report.argmaxAgreement * 100.0 << "%" << endl;
+}
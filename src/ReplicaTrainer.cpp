@@ -0,0 +1,258 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "../include/ReplicaTrainer.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+/**
+ * @brief Reusable barrier for a fixed number of threads
+ */
+struct ReplicaTrainer::Barrier {
+    mutex lock;
+    condition_variable arrived;
+    int count;
+    int waiting;
+    unsigned long generation;
+
+    Barrier(int count) : count(count), waiting(0), generation(0) {}
+
+    void wait() {
+        unique_lock<mutex> guard(this->lock);
+        unsigned long gen = this->generation;
+        if (++this->waiting == this->count) {
+            this->waiting = 0;
+            this->generation++;
+            this->arrived.notify_all();
+            return;
+        }
+        this->arrived.wait(guard, [this, gen] { return this->generation != gen; });
+    }
+};
+
+/**
+ * @brief Constructor for ReplicaTrainer
+ * @param model Network to train; receives the trained weights
+ * @param numReplicas Number of replicas and threads
+ * @param mode How replicas combine their updates
+ * @param syncInterval Steps between parameter averaging (REPLICA_SYNC only)
+ */
+ReplicaTrainer::ReplicaTrainer(NeuralNetwork* model, int numReplicas, ReplicaMode mode, int syncInterval) {
+    if (numReplicas < 1 || syncInterval < 1) {
+        cerr << "Replica trainer needs at least one replica and a positive sync interval: " << endl;
+        assert(false);
+    }
+
+    this->model = model;
+    this->mode = mode;
+    this->syncInterval = syncInterval;
+    this->samplesPerSecond = 0.0;
+    this->numParameters = 2 * model->getTopologySize() - 1;
+    this->parameterSize = 0;
+    for (int p = 0; p < this->numParameters; p++) {
+        Matrix* m = this->getParameter(model, p);
+        this->parameterSize += (size_t)m->getNumRows() * m->getNumCols();
+    }
+
+    for (int r = 0; r < numReplicas; r++) {
+        NeuralNetwork* replica = new NeuralNetwork(model->getTopology(), model->getLearningRate());
+        replica->setActivations(model->getActivations());
+        replica->setOptimizer(model->getOptimizerConfig());
+        if (mode == REPLICA_HOGWILD) {
+            // Views onto the model's parameters: every replica updates the same memory
+            for (int i = 0; i < model->getTopologySize() - 1; i++) {
+                Matrix* w = model->getWeightMatrix(i);
+                replica->setWeightMatrix(i, new Matrix(w->getData(), w->getNumRows(), w->getNumCols(), w->getStride()));
+            }
+            for (int i = 0; i < model->getTopologySize(); i++) {
+                Matrix* b = model->getBiasMatrix(i);
+                replica->setBiasMatrix(i, new Matrix(b->getData(), b->getNumRows(), b->getNumCols(), b->getStride()));
+            }
+        }
+        this->replicas.push_back(replica);
+    }
+
+    this->sync = new Barrier(numReplicas);
+}
+
+/**
+ * @brief Destructor, deletes the replicas (not the model)
+ */
+ReplicaTrainer::~ReplicaTrainer() {
+    for (int r = 0; r < this->replicas.size(); r++) {
+        delete this->replicas.at(r);
+    }
+    delete this->sync;
+}
+
+/**
+ * @brief Gets parameter matrix p (weights first, then biases) of a network
+ */
+Matrix* ReplicaTrainer::getParameter(NeuralNetwork* network, int p) {
+    int numWeights = network->getTopologySize() - 1;
+    return p < numWeights ? network->getWeightMatrix(p) : network->getBiasMatrix(p - numWeights);
+}
+
+/**
+ * @brief Trains the model on a dataset
+ * @param inputs Input vectors, one per sample
+ * @param targets Target vectors, one per sample
+ * @param epochs Number of passes over every shard
+ */
+void ReplicaTrainer::train(const vector<vector<double>>& inputs, const vector<vector<double>>& targets, int epochs) {
+    const int numReplicas = this->replicas.size();
+    if (inputs.size() != targets.size() || inputs.size() < (size_t)numReplicas) {
+        cerr << "Need matching inputs and targets and at least one sample per replica: " << endl;
+        assert(false);
+    }
+
+    if (this->mode == REPLICA_SYNC) {
+        for (int r = 0; r < numReplicas; r++) {
+            for (int p = 0; p < this->numParameters; p++) {
+                *this->getParameter(this->replicas.at(r), p) = *this->getParameter(this->model, p);
+            }
+        }
+    }
+
+    // Replicas in sync mode must take the same number of steps to meet at the barriers,
+    // so shorter shards wrap around
+    size_t stepsPerEpoch = (inputs.size() + numReplicas - 1) / numReplicas;
+
+    this->stats.assign(numReplicas, ReplicaStats());
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    vector<thread> threads;
+    for (int r = 0; r < numReplicas; r++) {
+        threads.push_back(thread(&ReplicaTrainer::runReplica, this, r, cref(inputs), cref(targets), epochs, stepsPerEpoch));
+    }
+    for (int r = 0; r < numReplicas; r++) {
+        threads.at(r).join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t total = 0;
+    for (int r = 0; r < numReplicas; r++) {
+        total += this->stats.at(r).samples;
+    }
+    this->samplesPerSecond = seconds > 0.0 ? total / seconds : 0.0;
+
+    if (this->mode == REPLICA_SYNC) {
+        for (int p = 0; p < this->numParameters; p++) {
+            *this->getParameter(this->model, p) = *this->getParameter(this->replicas.at(0), p);
+        }
+    }
+}
+
+/**
+ * @brief Training loop of one replica thread
+ */
+void ReplicaTrainer::runReplica(int index, const vector<vector<double>>& inputs, const vector<vector<double>>& targets,
+                                int epochs, size_t stepsPerEpoch) {
+    // Parallelism comes from the replicas, keep their kernels on this thread
+    ThreadPool::setThreadInline(true);
+
+    const int numReplicas = this->replicas.size();
+    const size_t shardBegin = inputs.size() * index / numReplicas;
+    const size_t shardEnd = inputs.size() * (index + 1) / numReplicas;
+    const size_t shardSize = shardEnd - shardBegin;
+    if (this->mode == REPLICA_HOGWILD) {
+        stepsPerEpoch = shardSize;
+    }
+
+    NeuralNetwork* nn = this->replicas.at(index);
+    ReplicaStats& stat = this->stats.at(index);
+    stat.replica = index;
+    stat.samples = 0;
+    stat.meanError = 0.0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t steps = 0;
+
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        double errorSum = 0.0;
+        for (size_t step = 0; step < stepsPerEpoch; step++) {
+            size_t sample = shardBegin + step % shardSize;
+            nn->setCurrentInput(inputs.at(sample));
+            nn->setCurrentTarget(targets.at(sample));
+            nn->feedForward();
+            nn->backPropogate();
+            errorSum += nn->getError();
+            stat.samples++;
+
+            if (this->mode == REPLICA_SYNC && ++steps % this->syncInterval == 0) {
+                this->barrier();
+                this->averageSlice(index);
+                this->barrier();
+            }
+        }
+        stat.meanError = errorSum / stepsPerEpoch;
+    }
+
+    if (this->mode == REPLICA_SYNC && steps % this->syncInterval != 0) {
+        this->barrier();
+        this->averageSlice(index);
+        this->barrier();
+    }
+
+    stat.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    stat.samplesPerSecond = stat.seconds > 0.0 ? stat.samples / stat.seconds : 0.0;
+    ThreadPool::setThreadInline(false);
+}
+
+/**
+ * @brief Averages slice index of the parameters across replicas (REPLICA_SYNC)
+ *
+ * The flattened parameters are split into one contiguous slice per replica. Values are
+ * summed in replica order and the mean is written back to every replica.
+ */
+void ReplicaTrainer::averageSlice(int index) {
+    const int numReplicas = this->replicas.size();
+    const size_t sliceBegin = this->parameterSize * index / numReplicas;
+    const size_t sliceEnd = this->parameterSize * (index + 1) / numReplicas;
+    const double scale = 1.0 / numReplicas;
+
+    size_t offset = 0;
+    for (int p = 0; p < this->numParameters && offset < sliceEnd; p++) {
+        Matrix* first = this->getParameter(this->replicas.at(0), p);
+        const size_t size = (size_t)first->getNumRows() * first->getNumCols();
+        const size_t b = sliceBegin > offset ? sliceBegin - offset : 0;
+        const size_t e = sliceEnd - offset < size ? sliceEnd - offset : size;
+
+        for (size_t i = b; i < e; i++) {
+            double sum = 0.0;
+            for (int r = 0; r < numReplicas; r++) {
+                sum += this->getParameter(this->replicas.at(r), p)->getData()[i];
+            }
+            for (int r = 0; r < numReplicas; r++) {
+                this->getParameter(this->replicas.at(r), p)->getData()[i] = sum * scale;
+            }
+        }
+        offset += size;
+    }
+}
+
+/**
+ * @brief Blocks until every replica thread has arrived
+ */
+void ReplicaTrainer::barrier() {
+    this->sync->wait();
+}
+
+/**
+ * @brief Prints the per-replica and aggregate statistics to the console
+ */
+void ReplicaTrainer::printStats() {
+    cout << "==========" << endl;
+    cout << "REPLICAS (" << (this->mode == REPLICA_SYNC ? "sync" : "hogwild") << "): " << endl;
+    for (int r = 0; r < this->stats.size(); r++) {
+        const ReplicaStats& s = this->stats.at(r);
+        cout << "Replica " << s.replica << "\t" << s.samples << " samples\t"
+             << s.samplesPerSecond << " samples/s\terror " << s.meanError << endl;
+    }
+    cout << "Total: " << this->samplesPerSecond << " samples/s" << endl;
+}
@@ -0,0 +1,260 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "../include/TextModelReader.hpp"
+
+using namespace std;
+
+/**
+ * @brief Powers of ten that are exactly representable as doubles
+ */
+static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * @brief Whether a character separates tokens
+ */
+static bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * @brief Opens a text model file
+ * @param path Path to the model file
+ * @param bufferSize Size of the read buffer in bytes
+ */
+TextModelReader::TextModelReader(const string& path, size_t bufferSize) : file(path, ios::binary) {
+    if (!this->file.is_open()) {
+        throw runtime_error("Could not open model file: " + path);
+    }
+    if (bufferSize < 2 * TEXT_MODEL_MAX_TOKEN) {
+        bufferSize = 2 * TEXT_MODEL_MAX_TOKEN;
+    }
+
+    this->path = path;
+    this->buffer = new char[bufferSize];
+    this->bufferSize = bufferSize;
+    this->pos = 0;
+    this->end = 0;
+    this->consumed = 0;
+    this->tokenOffset = 0;
+    this->eof = false;
+    this->refill();
+}
+
+/**
+ * @brief Destructor, releases the buffer
+ */
+TextModelReader::~TextModelReader() {
+    delete[] this->buffer;
+}
+
+/**
+ * @brief Moves the unread bytes to the front of the buffer and fills the rest
+ */
+void TextModelReader::refill() {
+    const size_t left = this->end - this->pos;
+    memmove(this->buffer, this->buffer + this->pos, left);
+    this->consumed += this->pos;
+    this->pos = 0;
+    this->end = left;
+
+    this->file.read(this->buffer + left, this->bufferSize - left);
+    this->end += this->file.gcount();
+    if (!this->file) {
+        this->eof = true;
+    }
+}
+
+/**
+ * @brief Skips whitespace, refilling the buffer as needed
+ * @return False at the end of the file
+ */
+bool TextModelReader::skipWhitespace() {
+    while (true) {
+        while (this->pos < this->end && isSpace(this->buffer[this->pos])) {
+            this->pos++;
+        }
+        if (this->pos < this->end) {
+            return true;
+        }
+        if (this->eof) {
+            return false;
+        }
+        this->refill();
+    }
+}
+
+/**
+ * @brief Reads the next number and the delimiter after it
+ * @param delimiter Receives the delimiter, ',' or ';'
+ * @return Parsed value
+ */
+double TextModelReader::next(char& delimiter) {
+    if (!this->skipWhitespace()) {
+        this->tokenOffset = this->consumed + this->pos;
+        this->fail("unexpected end of file, expected a number");
+    }
+    // Make sure a whole token is in the buffer
+    if (this->end - this->pos < TEXT_MODEL_MAX_TOKEN && !this->eof) {
+        this->refill();
+    }
+    this->tokenOffset = this->consumed + this->pos;
+
+    const char* first = this->buffer + this->pos;
+    const char* last = first;
+    const char* limit = this->buffer + this->end;
+    while (last < limit && *last != ',' && *last != ';' && !isSpace(*last)) {
+        last++;
+    }
+    if (last - first >= TEXT_MODEL_MAX_TOKEN) {
+        this->fail("number is too long");
+    }
+
+    double value;
+    if (last == first || parseDouble(first, last, value) != last) {
+        this->fail("malformed number '" + string(first, last) + "'");
+    }
+    this->pos = last - this->buffer;
+
+    if (!this->skipWhitespace()) {
+        this->fail("unexpected end of file after number, expected ',' or ';'");
+    }
+    delimiter = this->buffer[this->pos++];
+    return value;
+}
+
+/**
+ * @brief Reads the next number, which must be followed by a given delimiter
+ * @param delimiter Expected delimiter, ',' or ';'
+ * @return Parsed value
+ */
+double TextModelReader::nextBefore(char delimiter) {
+    char found;
+    double value = this->next(found);
+    if (found != delimiter) {
+        this->fail(string("expected '") + delimiter + "' after number but found '" + found + "'");
+    }
+    return value;
+}
+
+/**
+ * @brief Reads one ';' terminated block of values into a matrix, row by row
+ * @param m Destination, its shape determines how many values are read
+ */
+template <typename T>
+void TextModelReader::readMatrix(BasicMatrix<T>& m) {
+    for (int r = 0; r < m.getNumRows(); r++) {
+        T* row = m.rowPtr(r);
+        for (int c = 0; c < m.getNumCols(); c++) {
+            const bool last = r == m.getNumRows() - 1 && c == m.getNumCols() - 1;
+            row[c] = this->nextBefore(last ? ';' : ',');
+        }
+    }
+}
+
+template void TextModelReader::readMatrix(Matrix&);
+template void TextModelReader::readMatrix(MatrixF&);
+
+/**
+ * @brief Fails unless only whitespace is left in the file
+ */
+void TextModelReader::expectEnd() {
+    if (this->skipWhitespace()) {
+        this->tokenOffset = this->consumed + this->pos;
+        this->fail("trailing data after the model");
+    }
+}
+
+/**
+ * @brief Stops the load, reporting malformed input at the current token
+ *
+ * Throws rather than asserting so that release builds stop at the first error too.
+ * @param message Description of the problem
+ */
+void TextModelReader::fail(const string& message) {
+    throw runtime_error("Malformed model file " + this->path + " at byte " + to_string(this->tokenOffset) + ": " + message);
+}
+
+/**
+ * @brief Parses a decimal floating point number, in the manner of std::from_chars
+ * @param first Start of the text
+ * @param last End of the text
+ * @param value Receives the parsed value
+ * @return Pointer past the last character consumed, first if no number was found
+ */
+const char* TextModelReader::parseDouble(const char* first, const char* last, double& value) {
+    const char* p = first;
+    bool negative = false;
+    if (p < last && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool sawDigit = false;
+
+    for (; p < last && *p >= '0' && *p <= '9'; p++) {
+        sawDigit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else {
+            exponent++;
+        }
+    }
+    if (p < last && *p == '.') {
+        p++;
+        for (; p < last && *p >= '0' && *p <= '9'; p++) {
+            sawDigit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+
+    if (sawDigit && p < last && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < last && (*q == '-' || *q == '+')) {
+            negativeExponent = *q == '-';
+            q++;
+        }
+        if (q < last && *q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; q < last && *q >= '0' && *q <= '9'; q++) {
+                if (e < 100000) {
+                    e = e * 10 + (*q - '0');
+                }
+            }
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles
+    if (sawDigit && digits <= 15 && exponent >= -22 && exponent <= 22) {
+        double v = (double)mantissa;
+        v = exponent < 0 ? v / exactPowersOfTen[-exponent] : v * exactPowersOfTen[exponent];
+        value = negative ? -v : v;
+        return p;
+    }
+
+    // Long mantissas, large exponents, nan and inf
+    char token[TEXT_MODEL_MAX_TOKEN];
+    const size_t length = (size_t)(last - first) < sizeof(token) - 1 ? last - first : sizeof(token) - 1;
+    memcpy(token, first, length);
+    token[length] = '\0';
+    char* parsed;
+    value = strtod(token, &parsed);
+    return first + (parsed - token);
+}
@@ -0,0 +1,187 @@
+#include <iostream>
+#include <cassert>
+
+#include "../include/ThreadPool.hpp"
+
+size_t ThreadPool::threshold = 1 << 16;
+
+/**
+ * @brief Constructor for ThreadPool
+ * @param numThreads Total number of threads including the caller (at least 1)
+ */
+ThreadPool::ThreadPool(int numThreads) {
+    if (numThreads < 1) {
+        std::cerr << "Thread pool needs at least one thread: " << std::endl;
+        assert(false);
+    }
+    this->numThreads = numThreads;
+    this->generation = 0;
+    this->stopping = false;
+    this->task = nullptr;
+    this->ctx = nullptr;
+    this->begin = 0;
+    this->end = 0;
+    this->chunks = 0;
+    this->pending = 0;
+    this->start();
+}
+
+/**
+ * @brief Destructor, stops and joins the workers
+ */
+ThreadPool::~ThreadPool() {
+    this->stop();
+}
+
+/**
+ * @brief Gets the process-wide pool used by the matrix kernels
+ * @return Global pool, sized to the hardware concurrency on first use
+ */
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool(std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1);
+    return pool;
+}
+
+/**
+ * @brief Flag set on threads currently executing a chunk, to serialize nested loops
+ */
+bool& ThreadPool::insideTask() {
+    static thread_local bool inside = false;
+    return inside;
+}
+
+/**
+ * @brief Changes the number of threads, restarting the workers
+ * @param numThreads Total number of threads including the caller (at least 1)
+ */
+void ThreadPool::resize(int numThreads) {
+    if (numThreads < 1) {
+        std::cerr << "Thread pool needs at least one thread: " << std::endl;
+        assert(false);
+    }
+
+    std::lock_guard<std::mutex> caller(this->callerMutex);
+    if (numThreads == this->numThreads) {
+        return;
+    }
+    this->stop();
+    this->numThreads = numThreads;
+    this->start();
+}
+
+/**
+ * @brief Starts numThreads - 1 workers
+ */
+void ThreadPool::start() {
+    this->stopping = false;
+    for (int i = 1; i < this->numThreads; i++) {
+        this->workers.push_back(std::thread(&ThreadPool::workerLoop, this, i, this->generation));
+    }
+}
+
+/**
+ * @brief Stops and joins all workers
+ */
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (int i = 0; i < this->workers.size(); i++) {
+        this->workers.at(i).join();
+    }
+    this->workers.clear();
+}
+
+/**
+ * @brief Runs chunk index of the current job, keeping its exception for the caller
+ */
+void ThreadPool::runChunk(int index) {
+    const size_t n = this->end - this->begin;
+    const size_t b = this->begin + n * index / this->chunks;
+    const size_t e = this->begin + n * (index + 1) / this->chunks;
+
+    // Marks the thread as inside a chunk until the scope exits, by return or by throw
+    struct TaskScope {
+        bool& inside;
+        bool previous;
+        explicit TaskScope(bool& inside) : inside(inside), previous(inside) { this->inside = true; }
+        ~TaskScope() { this->inside = this->previous; }
+    } scope(ThreadPool::insideTask());
+    try {
+        this->task(this->ctx, b, e);
+    }
+    catch (...) {
+        // An exception must not end a worker (std::terminate) or leave the caller waiting on
+        // pending, so keep the first one and let run rethrow it once every chunk is done
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->error) {
+            this->error = std::current_exception();
+        }
+    }
+}
+
+/**
+ * @brief Dispatches a loop to the workers and runs the first chunk on the caller
+ */
+void ThreadPool::run(size_t begin, size_t end, Task task, void* ctx) {
+    std::unique_lock<std::mutex> caller(this->callerMutex, std::try_to_lock);
+    if (!caller.owns_lock()) {
+        // Another thread is using the pool, do the work here rather than queue behind it
+        task(ctx, begin, end);
+        return;
+    }
+
+    const size_t n = end - begin;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->task = task;
+        this->ctx = ctx;
+        this->begin = begin;
+        this->end = end;
+        this->chunks = n < (size_t)this->numThreads ? (int)n : this->numThreads;
+        this->pending = this->chunks - 1;
+        this->error = nullptr;
+        this->generation++;
+    }
+    this->wake.notify_all();
+
+    this->runChunk(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this] { return this->pending == 0; });
+    std::exception_ptr error = this->error;
+    this->error = nullptr;
+    lock.unlock();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Main loop of worker thread index
+ * @param index Chunk index this worker runs
+ * @param seen Last job generation posted before the worker was started
+ */
+void ThreadPool::workerLoop(int index, unsigned long seen) {
+    while (true) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->wake.wait(lock, [this, seen] { return this->stopping || this->generation != seen; });
+        if (this->stopping) {
+            return;
+        }
+        seen = this->generation;
+        if (index >= this->chunks) {
+            continue;
+        }
+        lock.unlock();
+
+        this->runChunk(index);
+
+        lock.lock();
+        if (--this->pending == 0) {
+            this->done.notify_one();
+        }
+    }
+}
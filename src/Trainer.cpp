@@ -0,0 +1,425 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "../include/Trainer.hpp"
+#include "../include/Initializer.hpp"
+
+using namespace std;
+
+/**
+ * @brief Constructor for BasicTrainer
+ * @param network Network to train, must outlive the trainer
+ * @param config Epochs, batching, schedule, early stopping and checkpointing
+ */
+template <typename T>
+BasicTrainer<T>::BasicTrainer(BasicNeuralNetwork<T>& network, const TrainerConfig& config) : network(network) {
+    if (config.epochs < 0 || config.batchSize < 1) {
+        cerr << "Trainer needs a positive batch size and a non-negative number of epochs" << endl;
+        assert(false);
+    }
+    this->config = config;
+    this->baseRate = network.getLearningRate();
+    this->rng = config.seed;
+    this->bestEpoch = 0;
+    this->bestLoss = INFINITY;
+    this->stopped = false;
+    this->checkpointSeconds = 0.0;
+    this->pending = NULL;
+    this->writing = false;
+    this->stopping = false;
+    this->written = 0;
+    this->failed = 0;
+}
+
+/**
+ * @brief Destructor, finishes the pending checkpoint and joins the checkpoint thread
+ */
+template <typename T>
+BasicTrainer<T>::~BasicTrainer() {
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->wake.notify_one();
+    if (this->writer.joinable()) {
+        this->writer.join();
+    }
+    freeParameters(this->bestWeights);
+    freeParameters(this->bestBiases);
+}
+
+/**
+ * @brief Trains on a mapped dataset, passing batch views straight to the network
+ * @param train Training set
+ * @param validation Validation set, or NULL to skip validation
+ * @return History, one entry per epoch run
+ */
+template <typename T>
+const vector<TrainerEpoch>& BasicTrainer<T>::fit(BasicMappedDataset<T>& train, BasicMappedDataset<T>* validation) {
+    const vector<int> topology = this->network.getTopology();
+    if (train.getNumInputs() != topology.front() || train.getNumTargets() != topology.back()
+        || (validation != NULL && (validation->getNumInputs() != topology.front() || validation->getNumTargets() != topology.back()))) {
+        cerr << "Dataset does not match the input and output layer sizes: " << endl;
+        assert(false);
+    }
+
+    const int batchSize = this->config.batchSize;
+    const bool shuffle = this->config.shuffle;
+    train.setSeed(this->config.seed);
+
+    auto beginEpoch = [&]() {
+        return train.beginEpoch(batchSize, shuffle);
+    };
+    auto trainStep = [&](int b) {
+        BasicMatrix<T> x = train.batchInputs(b);
+        this->network.trainBatch(x, train.batchTargets(b));
+        return x.getNumCols();
+    };
+    function<double()> validate;
+    if (validation != NULL) {
+        validate = [&]() {
+            double sum = 0.0;
+            size_t samples = 0;
+            const int batches = validation->beginEpoch(batchSize, false);
+            for (int b = 0; b < batches; b++) {
+                BasicMatrix<T> x = validation->batchInputs(b);
+                sum += this->network.evaluate(x, validation->batchTargets(b)) * x.getNumCols();
+                samples += x.getNumCols();
+            }
+            return samples > 0 ? sum / samples : 0.0;
+        };
+    }
+
+    this->run(beginEpoch, trainStep, validate);
+    return this->history;
+}
+
+/**
+ * @brief Trains on samples held in memory
+ * @param inputs Training input vectors, one per sample
+ * @param targets Training target vectors, one per sample
+ * @param validationInputs Validation input vectors, empty to skip validation
+ * @param validationTargets Validation target vectors
+ * @return History, one entry per epoch run
+ */
+template <typename T>
+const vector<TrainerEpoch>& BasicTrainer<T>::fit(const vector<vector<double>>& inputs, const vector<vector<double>>& targets,
+                                                 const vector<vector<double>>& validationInputs,
+                                                 const vector<vector<double>>& validationTargets) {
+    if (inputs.size() != targets.size() || validationInputs.size() != validationTargets.size()) {
+        cerr << "Dataset has " << inputs.size() << " inputs but " << targets.size() << " targets" << endl;
+        assert(false);
+    }
+
+    const size_t batchSize = this->config.batchSize;
+    const size_t n = inputs.size();
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++) {
+        order.at(i) = i;
+    }
+    this->rng = this->config.seed;
+
+    // Batch buffers keep their capacity from step to step
+    vector<vector<double>> x, t;
+    auto beginEpoch = [&]() {
+        for (size_t i = n; this->config.shuffle && i > 1; i--) {
+            swap(order.at(i - 1), order.at(SplitMix64::next(this->rng) % i));
+        }
+        return (int)((n + batchSize - 1) / batchSize);
+    };
+    auto trainStep = [&](int b) {
+        const size_t first = b * batchSize;
+        const size_t count = min(batchSize, n - first);
+        x.resize(count);
+        t.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            x.at(i) = inputs.at(order.at(first + i));
+            t.at(i) = targets.at(order.at(first + i));
+        }
+        this->network.trainBatch(x, t);
+        return (int)count;
+    };
+    function<double()> validate;
+    if (!validationInputs.empty()) {
+        validate = [&]() {
+            double sum = 0.0;
+            for (size_t first = 0; first < validationInputs.size(); first += batchSize) {
+                const size_t count = min(batchSize, validationInputs.size() - first);
+                x.assign(validationInputs.begin() + first, validationInputs.begin() + first + count);
+                t.assign(validationTargets.begin() + first, validationTargets.begin() + first + count);
+                sum += this->network.evaluate(x, t) * count;
+            }
+            return sum / validationInputs.size();
+        };
+    }
+
+    this->run(beginEpoch, trainStep, validate);
+    return this->history;
+}
+
+/**
+ * @brief Epoch loop shared by both fit overloads
+ * @param beginEpoch Lays out the epoch's batches and returns how many there are
+ * @param trainStep Trains on one batch and returns its number of samples
+ * @param validate Returns the validation loss, empty if there is no validation set
+ */
+template <typename T>
+void BasicTrainer<T>::run(const function<int()>& beginEpoch, const function<int(int)>& trainStep,
+                          const function<double()>& validate) {
+    const TrainerConfig& c = this->config;
+    this->history.clear();
+    this->bestEpoch = 0;
+    this->bestLoss = INFINITY;
+    this->stopped = false;
+    freeParameters(this->bestWeights);
+    freeParameters(this->bestBiases);
+
+    int step = 0;
+    int totalSteps = 0;
+    int sinceBest = 0;
+    for (int e = 0; e < c.epochs; e++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        const int batches = beginEpoch();
+        if (e == 0) {
+            totalSteps = batches * c.epochs;
+        }
+
+        TrainerEpoch record;
+        record.epoch = e + 1;
+        record.learningRate = this->network.getLearningRate();
+        record.validationLoss = NAN;
+        double lossSum = 0.0;
+        size_t samples = 0;
+        for (int b = 0; b < batches; b++, step++) {
+            record.learningRate = this->getScheduledRate(step, e, totalSteps);
+            this->network.setLearningRate(record.learningRate);
+            const int count = trainStep(b);
+            lossSum += this->network.getError() * count;
+            samples += count;
+        }
+        record.trainLoss = samples > 0 ? lossSum / samples : 0.0;
+
+        bool improved = false;
+        if (validate && (e + 1) % max(1, c.validateEvery) == 0) {
+            record.validationLoss = validate();
+            if (record.validationLoss < this->bestLoss - c.minDelta) {
+                this->bestLoss = record.validationLoss;
+                this->bestEpoch = e + 1;
+                sinceBest = 0;
+                improved = true;
+                if (c.restoreBest) {
+                    freeParameters(this->bestWeights);
+                    freeParameters(this->bestBiases);
+                    this->copyParameters(this->bestWeights, this->bestBiases);
+                }
+            }
+            else {
+                sinceBest++;
+            }
+        }
+
+        if (!c.checkpointPath.empty() && (c.checkpointBestOnly ? improved : (e + 1) % max(1, c.checkpointEvery) == 0)) {
+            this->checkpoint(c.checkpointPath);
+        }
+        record.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        this->history.push_back(record);
+
+        if (c.logEvery > 0 && (e == 0 || (e + 1) % c.logEvery == 0)) {
+            cout << "Epoch " << e + 1 << "/" << c.epochs << ", Error: " << record.trainLoss;
+            if (!isnan(record.validationLoss)) {
+                cout << ", Validation: " << record.validationLoss;
+            }
+            cout << ", Rate: " << record.learningRate << endl;
+        }
+
+        if (c.patience > 0 && sinceBest >= c.patience) {
+            this->stopped = e + 1 < c.epochs;
+            break;
+        }
+    }
+
+    // The network takes over the copies
+    for (int i = 0; i < this->bestWeights.size(); i++) {
+        this->network.setWeightMatrix(i, this->bestWeights.at(i));
+    }
+    for (int i = 0; i < this->bestBiases.size(); i++) {
+        this->network.setBiasMatrix(i, this->bestBiases.at(i));
+    }
+    this->bestWeights.clear();
+    this->bestBiases.clear();
+    this->network.setLearningRate(this->baseRate);
+}
+
+/**
+ * @brief Gets the scheduled learning rate of a step
+ * @param step Step number over the whole run, from 0
+ * @param epoch Epoch number, from 0
+ * @param totalSteps Steps in the whole run
+ * @return Learning rate
+ */
+template <typename T>
+double BasicTrainer<T>::getScheduledRate(int step, int epoch, int totalSteps) const {
+    const TrainerConfig& c = this->config;
+    if (step < c.warmupSteps) {
+        return this->baseRate * (step + 1) / c.warmupSteps;
+    }
+
+    switch (c.schedule) {
+        case SCHEDULE_STEP:
+            return this->baseRate * pow(c.stepFactor, epoch / max(1, c.stepEpochs));
+        case SCHEDULE_COSINE: {
+            const int span = totalSteps - c.warmupSteps;
+            const double progress = span > 1 ? min(1.0, (double)(step - c.warmupSteps) / (span - 1)) : 1.0;
+            return c.minLearningRate + 0.5 * (this->baseRate - c.minLearningRate) * (1.0 + cos(acos(-1.0) * progress));
+        }
+        default:
+            return this->baseRate;
+    }
+}
+
+/**
+ * @brief Writes a checkpoint of the network on the background thread
+ * @param path Model file to write
+ */
+template <typename T>
+void BasicTrainer<T>::checkpoint(const string& path) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Snapshot* s = new Snapshot;
+    s->path = path;
+    s->topology = this->network.getTopology();
+    s->activations = this->network.getActivations();
+    s->learningRate = this->baseRate;
+    this->copyParameters(s->weights, s->biases);
+
+    {
+        lock_guard<mutex> guard(this->lock);
+        if (!this->writer.joinable()) {
+            this->writer = thread(&BasicTrainer<T>::writerLoop, this);
+        }
+        // Superseded before it was written
+        if (this->pending != NULL) {
+            freeParameters(this->pending->weights);
+            freeParameters(this->pending->biases);
+            delete this->pending;
+        }
+        this->pending = s;
+    }
+    this->wake.notify_one();
+    this->checkpointSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Waits until every requested checkpoint is on disk
+ */
+template <typename T>
+void BasicTrainer<T>::waitForCheckpoints() {
+    unique_lock<mutex> guard(this->lock);
+    this->idle.wait(guard, [this] { return this->pending == NULL && !this->writing; });
+}
+
+/**
+ * @brief Gets the number of checkpoints written to disk
+ * @return Completed checkpoints
+ */
+template <typename T>
+int BasicTrainer<T>::getCheckpointsWritten() {
+    lock_guard<mutex> guard(this->lock);
+    return this->written;
+}
+
+/**
+ * @brief Gets the number of checkpoints that could not be written
+ * @return Failed checkpoints, whose previous file was left in place
+ */
+template <typename T>
+int BasicTrainer<T>::getCheckpointsFailed() {
+    lock_guard<mutex> guard(this->lock);
+    return this->failed;
+}
+
+/**
+ * @brief Gets the reason the last checkpoint failed
+ * @return Error message, empty if no checkpoint failed
+ */
+template <typename T>
+string BasicTrainer<T>::getCheckpointError() {
+    lock_guard<mutex> guard(this->lock);
+    return this->checkpointError;
+}
+
+/**
+ * @brief Main loop of the checkpoint thread
+ */
+template <typename T>
+void BasicTrainer<T>::writerLoop() {
+    unique_lock<mutex> guard(this->lock);
+    while (true) {
+        this->wake.wait(guard, [this] { return this->pending != NULL || this->stopping; });
+        if (this->pending == NULL) {
+            break;
+        }
+        Snapshot* s = this->pending;
+        this->pending = NULL;
+        this->writing = true;
+        guard.unlock();
+
+        // Written aside and renamed by ModelFile only once complete, so a crash or a failed
+        // write leaves the previous checkpoint intact
+        string error;
+        try {
+            ModelFile::write(s->path, s->topology, s->activations, s->learningRate, s->weights, s->biases);
+        }
+        catch (const exception& e) {
+            error = e.what();
+            cerr << "Checkpoint not written: " << error << endl;
+        }
+        freeParameters(s->weights);
+        freeParameters(s->biases);
+        delete s;
+
+        guard.lock();
+        this->writing = false;
+        if (error.empty()) {
+            this->written++;
+        }
+        else {
+            this->failed++;
+            this->checkpointError = error;
+        }
+        this->idle.notify_all();
+    }
+}
+
+/**
+ * @brief Copies the current weights and biases
+ * @param weights Receives new copies of the weight matrices
+ * @param biases Receives new copies of the bias matrices
+ */
+template <typename T>
+void BasicTrainer<T>::copyParameters(vector<BasicMatrix<T>*>& weights, vector<BasicMatrix<T>*>& biases) {
+    const int layers = this->network.getTopologySize();
+    for (int i = 0; i < layers - 1; i++) {
+        weights.push_back(new BasicMatrix<T>(*this->network.getWeightMatrix(i)));
+    }
+    for (int i = 0; i < layers; i++) {
+        biases.push_back(new BasicMatrix<T>(*this->network.getBiasMatrix(i)));
+    }
+}
+
+/**
+ * @brief Frees a list of copied matrices
+ * @param matrices Matrices to delete, cleared afterwards
+ */
+template <typename T>
+void BasicTrainer<T>::freeParameters(vector<BasicMatrix<T>*>& matrices) {
+    for (int i = 0; i < matrices.size(); i++) {
+        delete matrices.at(i);
+    }
+    matrices.clear();
+}
+
+template class BasicTrainer<double>;
+template class BasicTrainer<float>;
@@ -0,0 +1,39 @@
+#include <iostream>
+#include <string>
+#include "../include/MappedDataset.hpp"
+
+/**
+ * @brief Converts a CSV or binary row dataset into a memory-mappable columnar file
+ * @param argc Argument count
+ * @param argv source output numInputs numTargets [f32|f64] [--header]
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " <source.csv|rows.bin> <output.col> <inputs> <targets> [f32|f64] [--header]" << std::endl;
+        return 1;
+    }
+
+    ModelDtype dtype = MODEL_FLOAT64;
+    bool skipHeader = false;
+    for (int i = 5; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "f32") {
+            dtype = MODEL_FLOAT32;
+        }
+        else if (arg == "f64") {
+            dtype = MODEL_FLOAT64;
+        }
+        else if (arg == "--header") {
+            skipHeader = true;
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    size_t samples = MappedDataset::convert(argv[1], argv[2], std::stoi(argv[3]), std::stoi(argv[4]), dtype, skipHeader);
+    std::cout << "Wrote " << samples << " samples to " << argv[2] << std::endl;
+    return 0;
+}
@@ -4,14 +4,55 @@
 #include "../include/Neuron.hpp" 
 #include "../include/Matrix.hpp" 
 #include "../include/NeuralNetwork.hpp" 
+#include "../include/MappedDataset.hpp"
+#include "../include/Trainer.hpp"
+#include "../include/Profiler.hpp"
+
+/**
+ * @brief Trains on a columnar dataset (see nn_convert_dataset) with validation,
+ *        early stopping and checkpoints
+ * @param trainPath Training set
+ * @param validationPath Validation set, empty for none
+ * @return Exit code
+ */
+static int trainDataset(const std::string& trainPath, const std::string& validationPath) {
+    MappedDataset train(trainPath);
+    MappedDataset* validation = validationPath.empty() ? NULL : new MappedDataset(validationPath);
+    NeuralNetwork nn({ train.getNumInputs(), 128, 256, train.getNumTargets() }, 0.001);
+    nn.setOptimizer(OptimizerConfig(OPTIMIZER_ADAM));
+
+    TrainerConfig config;
+    config.epochs = 50;
+    config.batchSize = 64;
+    config.schedule = SCHEDULE_COSINE;
+    config.warmupSteps = 100;
+    config.patience = 5;
+    config.checkpointPath = "trained_model.nn";
+    config.checkpointBestOnly = validation != NULL;
+    Trainer trainer(nn, config);
+    trainer.fit(train, validation);
+    trainer.waitForCheckpoints();
+
+    if (validation != NULL) {
+        std::cout << "Best validation error " << trainer.getBestValidationLoss() << " at epoch " << trainer.getBestEpoch()
+                  << (trainer.stoppedEarly() ? ", stopped early" : "") << std::endl;
+    }
+    std::cout << "Model saved to trained_model.nn" << std::endl;
+    delete validation;
+    return 0;
+}
 
 /**
  * @brief Main function demonstrating neural network training
  * @param argc Argument count
- * @param argv Argument values
+ * @param argv Optional columnar training set and validation set
  * @return Exit code
  */
 int main(int argc, char** argv) {
+    if (argc > 1) {
+        return trainDataset(argv[1], argc > 2 ? argv[2] : "");
+    }
+
     // Define network topology: 5 input neurons, 128 and 256 hidden neurons, 10 output neurons
     std::vector<int> topology;
     topology.push_back(5);
@@ -43,23 +84,19 @@ int main(int argc, char** argv) {
     // Create neural network with learning rate 0.01
     NeuralNetwork* nn = new NeuralNetwork(topology, 0.01);
     
-    // Set input and target for training
-    nn->setCurrentInput(input);
-    nn->setCurrentTarget(output);
-    
     std::cout << "Training neural network..." << std::endl;
     
-    // Train the network
-    const int epochs = 600;
-    for (int i = 0; i < epochs; i++) {
-        nn->feedForward();
-        nn->backPropogate();
-        
-        // Print progress
-        if (i % 100 == 0) {
-            std::cout << "Epoch " << i << "/" << epochs << ", Error: " << nn->getError() << std::endl;
-        }
-    }
+    // Train the network on the single sample, printing progress every 100 epochs
+    TrainerConfig config;
+    config.epochs = 600;
+    config.batchSize = 1;
+    config.shuffle = false;
+    config.logEvery = 100;
+    Trainer* trainer = new Trainer(*nn, config);
+    trainer->fit({ input }, { output });
+    delete trainer;
+    nn->setCurrentInput(input);
+    nn->feedForward();
     
     // Print final output
     std::cout << "\nFinal output:" << std::endl;
@@ -68,7 +105,16 @@ int main(int argc, char** argv) {
     // Save the trained model
     nn->saveModel("trained_model.nn");
     std::cout << "Model saved to trained_model.nn" << std::endl;
-    
+
+    // Built with -DNN_PROFILE=ON: where the training time went, and a trace to open in a viewer
+    if (Profiler::isCompiledIn()) {
+        std::cout << std::endl;
+        Profiler::printSummary(std::cout);
+        if (Profiler::writeChromeTrace("nn_profile.json")) {
+            std::cout << "Trace written to nn_profile.json" << std::endl;
+        }
+    }
+
     // Clean up
     delete nn;
     
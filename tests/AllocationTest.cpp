@@ -0,0 +1,87 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/ThreadPool.hpp"
+
+using namespace std;
+
+#define TEST_STEPS 20
+
+/// Heap allocations made by any thread since the start of the program
+static atomic<long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+/**
+ * @brief Counts the allocations of repeated calls and reports a failure if there were any
+ * @param name Printed name of the check
+ * @param step Work of one steady-state step, run once before counting
+ * @return Whether no allocation was made
+ */
+template <typename F>
+static bool expectNoAllocations(const char* name, F step) {
+    step();
+    const long before = allocations.load();
+    for (int s = 0; s < TEST_STEPS; s++) {
+        step();
+    }
+    const long count = allocations.load() - before;
+    cout << (count == 0 ? "PASS " : "FAIL ") << name << ": " << count << " allocations in " << TEST_STEPS << " steps" << endl;
+    return count == 0;
+}
+
+/**
+ * @brief Checks that steady-state training and evaluation steps make no heap allocation
+ * @return Number of failed checks
+ */
+int main() {
+    // Two threads and no threshold, so the pooled paths are exercised too
+    ThreadPool::setNumThreads(2);
+    ThreadPool::setParallelThreshold(0);
+
+    NeuralNetwork nn({ 5, 128, 256, 10 }, 0.01);
+    nn.reserveHistory(16 * TEST_STEPS);
+    nn.setCurrentInput({ 0.1, 0.2, 0.3, 0.4, 0.5 });
+    nn.setCurrentTarget({ 0, 1, 0, 0, 0, 0, 0, 0, 0, 0 });
+
+    Matrix inputs(5, 64, true), targets(10, 64, true);
+    Matrix smallInputs(5, 16, true), smallTargets(10, 16, true);
+    vector<vector<double> > vectorInputs(16, vector<double>(5, 0.5)), vectorTargets(16, vector<double>(10, 0.5));
+
+    int failures = 0;
+    failures += !expectNoAllocations("feedForward + backPropogate", [&]() {
+        nn.feedForward();
+        nn.backPropogate();
+    });
+    failures += !expectNoAllocations("trainBatch(64)", [&]() {
+        nn.trainBatch(inputs, targets);
+    });
+    failures += !expectNoAllocations("evaluate(16) + trainBatch(64)", [&]() {
+        nn.evaluate(smallInputs, smallTargets);
+        nn.trainBatch(inputs, targets);
+    });
+    failures += !expectNoAllocations("evaluate(16 vectors) + trainBatch(64)", [&]() {
+        nn.evaluate(vectorInputs, vectorTargets);
+        nn.trainBatch(inputs, targets);
+    });
+    return failures;
+}
@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../include/InferenceModel.hpp"
+#include "../include/Matrix.hpp"
+#include "../include/NeuralNetwork.hpp"
+#include "../include/Trainer.hpp"
+
+using namespace std;
+
+#define TEST_PATH "nn_model_file_test.nn"
+// In a directory that does not exist, so every write fails
+#define UNWRITABLE_PATH "nn_model_file_test_missing/model.nn"
+
+/**
+ * @brief Whether two networks of the same topology hold exactly the same parameters
+ * @param a First network
+ * @param b Second network
+ * @return True if every weight and bias is equal
+ */
+static bool sameParameters(NeuralNetwork& a, NeuralNetwork& b) {
+    for (int l = 0; l < a.getTopologySize(); l++) {
+        Matrix* ab = a.getBiasMatrix(l);
+        Matrix* bb = b.getBiasMatrix(l);
+        for (int i = 0; i < ab->getNumRows(); i++) {
+            if (ab->at(i, 0) != bb->at(i, 0)) {
+                return false;
+            }
+        }
+        if (l + 1 == a.getTopologySize()) {
+            break;
+        }
+        Matrix* aw = a.getWeightMatrix(l);
+        Matrix* bw = b.getWeightMatrix(l);
+        for (int i = 0; i < aw->getNumRows(); i++) {
+            for (int j = 0; j < aw->getNumCols(); j++) {
+                if (aw->at(i, j) != bw->at(i, j)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reports one check
+ * @param name Printed name of the check
+ * @param passed Result
+ * @return passed
+ */
+static bool expect(const char* name, bool passed) {
+    cout << (passed ? "PASS " : "FAIL ") << name << endl;
+    return passed;
+}
+
+/**
+ * @brief Checks that a model can be saved over the file it was loaded from, which the loaded
+ *        network (and any InferenceModel) still maps, and that failed writes are reported
+ * @return Number of failed checks
+ */
+int main() {
+    NeuralNetwork original({ 5, 128, 256, 10 }, 0.01, INIT_XAVIER_UNIFORM, 42);
+    original.saveModel(TEST_PATH);
+
+    int failures = 0;
+    {
+        NeuralNetwork loaded(TEST_PATH);
+        InferenceModel mapped(TEST_PATH);
+        vector<double> input(5, 0.5), before(10), after(10), scratch(mapped.getScratchSize());
+        mapped.predict(input.data(), before.data(), scratch.data());
+
+        loaded.saveModel(TEST_PATH);
+        failures += !expect("binary load then save to the same path", sameParameters(original, loaded));
+
+        // The inference model still reads the pages of the file it mapped
+        mapped.predict(input.data(), after.data(), scratch.data());
+        failures += !expect("inference model mapped from the replaced file", before == after);
+
+        NeuralNetwork reloaded(TEST_PATH);
+        failures += !expect("reload after saving over the source", sameParameters(original, reloaded));
+
+        reloaded.saveModel(TEST_PATH, MODEL_TEXT);
+    }
+    NeuralNetwork text(TEST_PATH);
+    failures += !expect("text save over a mapped binary model", sameParameters(original, text));
+
+    bool threw = false;
+    try {
+        original.saveModel(UNWRITABLE_PATH);
+    }
+    catch (const runtime_error&) {
+        threw = true;
+    }
+    failures += !expect("failed save throws", threw);
+
+    {
+        Trainer trainer(original, TrainerConfig());
+        trainer.checkpoint(UNWRITABLE_PATH);
+        trainer.waitForCheckpoints();
+        failures += !expect("failed checkpoint is recorded",
+                            trainer.getCheckpointsWritten() == 0 && trainer.getCheckpointsFailed() == 1 &&
+                            !trainer.getCheckpointError().empty());
+    }
+
+    remove(TEST_PATH);
+    return failures;
+}